@@ -0,0 +1,60 @@
+/**
+ *  Project     Campos
+ *  @file		boot.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for boot.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef BOOT_H_
+#define BOOT_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	BOOT_RESET = 0,			// Reset, HAL and systick are running
+	BOOT_POWER = 1,			// Power hold and battery ADC
+	BOOT_LCD = 2,			// TFT initialized
+	BOOT_LOGO = 3,			// Startup logo is visible
+	BOOT_IRLINK = 4,		// IR link initialized
+	BOOT_USART = 5,			// Debug port initialized
+	BOOT_CAMERA = 6,		// OV5647 registers written, video started
+	BOOT_TRACK = 7,			// Tracking started
+	BOOT_FIRST_FRAME = 8,	// First frame received
+	BOOT_FIRST_POSITION = 9,// First valid position
+	BOOT_SPLASH_END = 10,	// Logo removed, normal display
+	BOOT_PHASES = 11
+} Boot_PhaseTypeDef;
+
+/* Defines -------------------------------------------------------------------*/
+
+// The logo is shown at least this time, even if the position is already valid
+#define BOOT_SPLASH_MIN_MS	1000
+// .. and it is removed after this time, even if there is no position
+#define BOOT_SPLASH_MAX_MS	5000
+
+/* Function prototypes -------------------------------------------------------*/
+void BOOT_Init(void);
+void BOOT_Mark(Boot_PhaseTypeDef phase);
+int BOOT_Task(void);
+void BOOT_PrintTimeline(void);
+
+#endif /* BOOT_H_ */
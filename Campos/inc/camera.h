@@ -91,6 +91,10 @@ extern uint8_t frame_flag; // is set, if a new frame was received
 extern int window_x, window_y;
 extern int offset_window_x, offset_window_y; // Offset of the captured window
 extern int offset_x, offset_y;
+extern uint32_t camera_exposure; // exposure time in 1/16 lines
+extern uint32_t camera_gain; // sensor gain, 16 = 1x
+extern int camera_held; // The capture is stopped, the pixels stay valid
+extern uint32_t camera_skipped; // Frames that were not processed on purpose
 
 /* Defines ------------------------------------------------------------------*/
 
@@ -106,10 +110,16 @@ extern int offset_x, offset_y;
 
 #define CAMERA_I2C_ADDRESS               0x6C
 
+// Time in ms the camera needs after switching on the supply
+#define CAMERA_POWERUP_MS				100
+
 /* Function prototypes -------------------------------------------------------*/
 
+void BSP_CAMERA_PowerOn(void);
 uint8_t BSP_CAMERA_Init();
 void BSP_CAMERA_ContinuousStart(void);
+void BSP_CAMERA_SetHold(int hold);
+void BSP_CAMERA_Release(void);
 void BSP_CAMERA_Suspend(void);
 void BSP_CAMERA_Resume(void);
 uint8_t BSP_CAMERA_Stop(void);
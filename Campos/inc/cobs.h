@@ -0,0 +1,43 @@
+/**
+ *  Project     Campos
+ *  @file		cobs.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for cobs.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef COBS_H_
+#define COBS_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// The encoded data never contains this byte, it separates the packets
+#define COBS_DELIMITER		0x00
+
+// Maximum size of n encoded bytes without the delimiter
+#define COBS_MAX_ENCODED(n)	((n) + (n) / 254 + 1)
+
+/* Function prototypes -------------------------------------------------------*/
+int COBS_Encode(const uint8_t *data, int n, uint8_t *coded);
+int COBS_Decode(const uint8_t *coded, int n, uint8_t *data, int max);
+
+#endif /* COBS_H_ */
@@ -0,0 +1,96 @@
+/**
+ *  Project     Campos
+ *  @file		command.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for command.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This header does not use the HAL, the host client takes the command
+ *  codes from it.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stream.h"
+#include "param.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+// The requests and responses are stream packets (see stream.h), all
+// values little endian.
+// Request payload:  sequence number (16 bit), command (8 bit), arguments
+// Response payload: sequence number and command of the request,
+//                   status (8 bit), result
+#define COMMAND_VERSION			2
+
+// Ping. Result: protocol version (8 bit), frame number (16 bit),
+// time since reset in ms (32 bit)
+#define COMMAND_PING			0x00
+// Read sensor registers. Arguments: n * address (16 bit).
+// Result: n * value (8 bit)
+#define COMMAND_REG_READ		0x01
+// Write sensor registers. Arguments: n * (address (16 bit), value (8 bit))
+#define COMMAND_REG_WRITE		0x02
+// Read parameters. Arguments: n * id (8 bit, Param_IdTypeDef).
+// Result: n * value (32 bit)
+#define COMMAND_PARAM_GET		0x03
+// Set parameters. Arguments: n * (id (8 bit), value (32 bit)).
+// Result: n * new value (32 bit). Nothing is set, if one value is invalid.
+#define COMMAND_PARAM_SET		0x04
+// Stream control. Arguments: frame stream mode, telemetry on, trace on
+// (8 bit each, COMMAND_UNCHANGED keeps the setting).
+// Result: frames sent, frames skipped, telemetry packets dropped, trace
+// events dropped, bytes dropped by the debug port (32 bit each)
+#define COMMAND_STREAM			0x05
+// Describe parameters. Arguments: n * id (8 bit). Result: number of
+// parameters (8 bit), n * (type (8 bit), min, max, value after reset
+// (32 bit each), name (PARAM_NAME_LEN bytes, filled up with 0))
+#define COMMAND_PARAM_INFO		0x06
+#define COMMAND_PARAM_INFO_SIZE	(1 + 3 * 4 + PARAM_NAME_LEN)
+
+#define COMMAND_UNCHANGED		0xFF
+
+// Registers or parameters in one request
+#define COMMAND_MAX_ITEMS		64
+// Parameter descriptions in one request, they must fit into the response
+#define COMMAND_MAX_INFO		12
+
+#define COMMAND_REQUEST_HEADER	3
+#define COMMAND_RESPONSE_HEADER	4
+
+// An incomplete request is discarded after this time
+#define COMMAND_TIMEOUT_MS		200
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	COMMAND_OK = 0,
+	COMMAND_ERR_UNKNOWN = 1,	// Unknown command
+	COMMAND_ERR_LENGTH = 2,		// Arguments do not fit to the command
+	COMMAND_ERR_RANGE = 3		// Unknown parameter or invalid value
+} Command_StatusTypeDef;
+
+/* Function Prototypes --------------------------------------------------------*/
+int COMMAND_Receiving(void);
+void COMMAND_Receive(uint8_t c);
+void COMMAND_Task(void);
+int COMMAND_Pending(void);
+
+#endif /* COMMAND_H_ */
@@ -0,0 +1,86 @@
+/**
+ *  Project     Campos
+ *  @file		config.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for config.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This header does not use the HAL, the host tool configsim runs the
+ *  store on a simulated flash.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Layout of a sector, all values are 32 bit words:
+//  header:  status, generation (incremented with each transfer)
+//  records: value, key (16 bit) and CRC16 of key and value (16 bit)
+// The key word is programmed after the value, so a record that was
+// interrupted by a power fail has no valid CRC.
+#define CONFIG_SECTORS			2
+#define CONFIG_HEADER_WORDS		2
+#define CONFIG_RECORD_WORDS		2
+
+// Status of a sector. Flash bits can only be cleared, so each status
+// is programmed over the one before.
+#define CONFIG_ERASED			0xFFFFFFFF	// Empty sector
+#define CONFIG_RECEIVING		0xEEEEEEEE	// The values are copied into it
+#define CONFIG_VALID			0x00000000	// Sector with the values
+
+// Different keys in the RAM copy
+#define CONFIG_MAX_KEYS			64
+#define CONFIG_KEY_NONE			0xFFFF
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	CONFIG_FREE = 0,		// Unused entry
+	CONFIG_STORED = 1,		// The value is in the flash
+	CONFIG_PENDING = 2		// The value has to be programmed
+} Config_StateTypeDef;
+
+typedef struct {
+	uint16_t key;
+	uint8_t state;			// Config_StateTypeDef
+	uint32_t value;
+} Config_EntryTypeDef;
+
+/* Global variables  ---------------------------------------------------------*/
+extern uint32_t config_generation;	// Generation of the active sector
+extern uint32_t config_records;		// Used records of the active sector
+extern uint32_t config_errors;		// Failed flash operations
+extern int config_full;				// No space until the next reset
+
+// The flash driver, configflash.c on the target
+extern volatile uint32_t * const config_sectors[CONFIG_SECTORS];
+extern const uint32_t config_sector_words;
+int CONFIG_FlashErase(int sector);
+int CONFIG_FlashProgram(volatile uint32_t *address, uint32_t value);
+
+/* Function prototypes -------------------------------------------------------*/
+void CONFIG_Init(void);
+int CONFIG_Read(uint16_t key, uint32_t *value);
+int CONFIG_Write(uint16_t key, uint32_t value);
+int CONFIG_Pending(void);
+void CONFIG_Task(void);
+
+#endif /* CONFIG_H_ */
@@ -0,0 +1,41 @@
+/**
+ *  Project     Campos
+ *  @file		crc.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for crc.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CRC_H_
+#define CRC_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define CRC32_INIT		0xFFFFFFFF
+#define CRC16_INIT		0xFFFF
+
+/* Function prototypes -------------------------------------------------------*/
+uint32_t CRC_Crc32(uint32_t crc, const uint32_t *data, int n);
+uint32_t CRC_Crc32Bytes(uint32_t crc, const uint8_t *data, int n);
+uint16_t CRC_Crc16(uint16_t crc, const uint16_t *data, int n);
+uint16_t CRC_Crc16Bytes(uint16_t crc, const uint8_t *data, int n);
+
+#endif /* CRC_H_ */
@@ -0,0 +1,59 @@
+/**
+ *  Project     Campos
+ *  @file		framestream.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for framestream.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FRAMESTREAM_H_
+#define FRAMESTREAM_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "stream.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	FRAMESTREAM_OFF = 0,	// No streaming
+	FRAMESTREAM_RAW = 1,	// Uncoded pixels
+	FRAMESTREAM_DELTA = 2,	// Difference coded pixels
+	FRAMESTREAM_RECORD = 3,	// Every frame, the capture waits until it is sent
+	FRAMESTREAM_MODES = 4
+} FrameStream_ModeTypeDef;
+
+/* Defines -------------------------------------------------------------------*/
+
+// Without the record mode only the zoomed 120x120 frames are streamed
+#define FRAMESTREAM_W			120
+#define FRAMESTREAM_H			120
+
+// Tiles of a total frame
+#define FRAMESTREAM_TILES_X		3
+
+/* Global variables  ---------------------------------------------------------*/
+extern uint32_t framestream_sent;		// Completely sent frames
+extern uint32_t framestream_skipped;	// Frames skipped while sending
+
+/* Function Prototypes --------------------------------------------------------*/
+void FRAMESTREAM_SetMode(FrameStream_ModeTypeDef mode);
+void FRAMESTREAM_FrameCallback(void);
+void FRAMESTREAM_Task(void);
+
+#endif /* FRAMESTREAM_H_ */
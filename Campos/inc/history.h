@@ -0,0 +1,60 @@
+/**
+ *  Project     Campos
+ *  @file		history.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for history.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "track.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef struct {
+	uint32_t time;		// time stamp in ms
+	int32_t intensity;	// intensity (integral of all pixel values)
+	uint16_t x;			// position in sensor pixels
+	uint16_t y;			// position in sensor pixels
+	uint16_t subx;		// sub pixel position from 0..999
+	uint16_t suby;		// sub pixel position from 0..999
+	uint8_t status;		// Track_StatusTypeDef
+} History_EntryTypeDef;
+
+/* Defines -------------------------------------------------------------------*/
+
+// Number of positions in the ring buffer. Must be a power of 2
+#define HISTORY_SIZE	256
+#define HISTORY_MASK	(HISTORY_SIZE-1)
+
+// Number of positions drawn as trail on the LCD
+#define HISTORY_TRAIL	32
+
+/* Function prototypes -------------------------------------------------------*/
+void HISTORY_Init(void);
+void HISTORY_Add(Track_StatusTypeDef status, int x, int subx, int y, int suby,
+		int intensity);
+int HISTORY_Count(void);
+History_EntryTypeDef* HISTORY_Get(int age);
+int HISTORY_DumpLine(int line, char *buf, int size);
+
+#endif /* HISTORY_H_ */
@@ -0,0 +1,52 @@
+/**
+ *  Project     Campos
+ *  @file		irfec.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for irfec.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IRFEC_H_
+#define IRFEC_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "irpacket.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	IRFEC_NONE = 0,			// The packet words are sent as they are
+	IRFEC_HAMMING = 1,		// Hamming(7,4), one code word after the other
+	IRFEC_INTERLEAVED = 2,	// Hamming(7,4), bit planes of all code words
+	IRFEC_MODES = 3
+} IrFec_ModeTypeDef;
+
+/* Defines -------------------------------------------------------------------*/
+
+// Number of words of a coded packet with n data words
+#define IRFEC_CODED_WORDS(n)	(((n) * 4 * 7 + 15) / 16)
+#define IRFEC_MAX_WORDS			IRFEC_CODED_WORDS(IRPACKET_MAX_WORDS)
+
+/* Function prototypes -------------------------------------------------------*/
+int IRFEC_Encode(IrFec_ModeTypeDef mode, const uint16_t *data, int n,
+		uint16_t *coded, int max_coded);
+int IRFEC_Decode(IrFec_ModeTypeDef mode, const uint16_t *coded, int n,
+		uint16_t *data, int max_data, int *corrected);
+
+#endif /* IRFEC_H_ */
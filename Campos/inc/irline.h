@@ -0,0 +1,44 @@
+/**
+ *  Project     Campos
+ *  @file		irline.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for irline.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IRLINE_H_
+#define IRLINE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Minimum length of the header and the pause after it in symbols
+#define IRLINE_HEADER_SYMBOLS	6
+#define IRLINE_PAUSE_SYMBOLS	3
+
+// Number of symbols of a transmission with n words
+#define IRLINE_SYMBOLS(n)		(IRLINE_HEADER_SYMBOLS + IRLINE_PAUSE_SYMBOLS + (n)*16*2 + 1)
+
+/* Function prototypes -------------------------------------------------------*/
+int IRLINE_BuildSymbols(uint16_t *symbols, const uint16_t *data, int words,
+		int header_symbols, uint16_t on);
+
+#endif /* IRLINE_H_ */
@@ -29,12 +29,53 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
 #include "track.h"
+#include "irpacket.h"
+#include "irfec.h"
+#include "irqueue.h"
+#include "irline.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	IRLINK_IDLE = 0,	// Nothing to send
+	IRLINK_HEADER = 1,	// The header is sent, waiting for the data
+	IRLINK_SENDING = 2	// The symbol buffer is sent by DMA
+} Irlink_StateTypeDef;
+
+/* Defines -------------------------------------------------------------------*/
+
+// Carrier of the bursts. Timer 3 counts with 42MHz.
+#define IRLINK_CARRIER_CLOCK	42000000
+#define IRLINK_CARRIER_HZ		38000
+#define IRLINK_CARRIER_MIN_HZ	30000
+#define IRLINK_CARRIER_MAX_HZ	56000
+
+// Duration of one symbol (half of a Manchester bit). A packet with one
+// target and the latency takes 266 symbols, so it fits into the 33ms
+// frame period with some time for the processing of the frame.
+#define IRLINK_SYMBOL_US		100
+#define IRLINK_SYMBOL_MIN_US	100
+#define IRLINK_SYMBOL_MAX_US	10000
+
+// Size of the symbol buffer: header, pause, 2 symbols per bit and the end
+#define IRLINK_MAX_SYMBOLS		IRLINE_SYMBOLS(IRFEC_MAX_WORDS)
+
+/* Global variables  ---------------------------------------------------------*/
+extern uint16_t irlink_frame_seq;	// Incremented with each frame
+extern uint32_t irlink_frame_us;	// Time stamp of the last frame in us
+extern int irlink_carrier_hz;		// Carrier frequency of the bursts
+extern int irlink_latency;			// Send the latency of the last packet
 
 /* Function Prototypes --------------------------------------------------------*/
 void IRLINK_Init(void);
 void IRLINK_Output(int value);
+void IRLINK_SetSymbolPeriod(int us);
+void IRLINK_SetCarrier(int hz);
+void IRLINK_SetFec(IrFec_ModeTypeDef mode);
+void IRLINK_SetCompact(int on);
 void IRLINK_StartHeader(void);
-void IRLINK_500usTask(void);
+void IRLINK_DMA_IRQHandler(void);
+void IRLINK_SendPacket(IrPacket_TypeDef *packet);
+void IRLINK_PrintCounters(void);
 void IRLINK_Send(Track_StatusTypeDef track_status ,
 		int position_x, int position_subx,
 		int position_y, int position_suby,
@@ -0,0 +1,133 @@
+/**
+ *  Project     Campos
+ *  @file		irpacket.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for irpacket.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IRPACKET_H_
+#define IRPACKET_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Packet layout in 16 bit words, MSB first:
+//  0: version (4 bit), flags (4 bit), low byte of the sequence number
+//  1,2: time stamp in us, high word first
+//  (3: latency in 100us, only with IRPACKET_FLAG_LATENCY)
+//  3..: per target x, y and status (4 bit) with intensity (12 bit)
+//  last: CRC-16
+// The length is given by the number of received words, like for the
+// delta packets. The compact decoder restores the high byte of the
+// sequence number from the last received packet.
+#define IRPACKET_VERSION		3
+#define IRPACKET_HEADER_WORDS	3
+#define IRPACKET_LATENCY_WORDS	1
+#define IRPACKET_TARGET_WORDS	3
+#define IRPACKET_CRC_WORDS		1
+
+// Unit of the latency
+#define IRPACKET_LATENCY_US		100
+
+// Number of fractional bits of the coordinates. 1/16 pixel keeps x and y
+// in one word each, the 1/1000 pixel of the tracker would need 22 bits.
+#define IRPACKET_FRACTION_BITS	4
+
+// Intensity is reduced to 12 bit
+#define IRPACKET_INTENSITY_SHIFT	10
+#define IRPACKET_INTENSITY_MAX		0x0FFF
+
+// Compact packets: key packets have the normal format, the packets
+// between them carry the differences to the last key packet as bit
+// stream, so a lost delta packet does not break the following ones:
+//  0: version (4 bit), flags (4 bit), low byte of the sequence number
+//  1..: distance to the key packet, deviation of the time difference
+//       from distance * IRPACKET_FRAME_US, number of targets and per
+//       target status, dx, dy and intensity difference, with
+//       IRPACKET_FLAG_LATENCY the latency difference at the end.
+//       All values as variable length numbers with 3 bit groups
+//  last: CRC-16
+#define IRPACKET_FLAG_DELTA		0x01
+// The header before the packet started at the time stamp
+#define IRPACKET_FLAG_SYNC		0x02
+// The packet carries the latency of the last sent packet
+#define IRPACKET_FLAG_LATENCY	0x04
+#define IRPACKET_KEY_INTERVAL	8
+#define IRPACKET_MAX_REF		15
+// Nominal frame period of the camera at 30fps
+#define IRPACKET_FRAME_US		33333
+
+#define IRPACKET_MAX_TARGETS	4
+#define IRPACKET_MAX_WORDS		(IRPACKET_HEADER_WORDS + IRPACKET_LATENCY_WORDS \
+		+ IRPACKET_MAX_TARGETS*IRPACKET_TARGET_WORDS + IRPACKET_CRC_WORDS)
+
+/* Type defs -----------------------------------------------------------------*/
+typedef struct {
+	uint16_t x;			// position in sensor pixels, fixed point 12.4
+	uint16_t y;			// position in sensor pixels, fixed point 12.4
+	uint16_t intensity;	// intensity >> IRPACKET_INTENSITY_SHIFT, 12 bit
+	uint8_t status;		// Track_StatusTypeDef, 4 bit
+} IrPacket_TargetTypeDef;
+
+typedef struct {
+	uint8_t version;	// format version
+	uint8_t flags;		// IRPACKET_FLAG_xx
+	uint16_t seq;		// frame sequence number
+	uint32_t timestamp;	// capture time of the frame in us
+	uint16_t latency;	// VSYNC to the end of the last sent packet in
+						// IRPACKET_LATENCY_US, 0 without IRPACKET_FLAG_LATENCY
+	int targets;		// number of targets. The first one is the tracked one
+	IrPacket_TargetTypeDef target[IRPACKET_MAX_TARGETS];
+} IrPacket_TypeDef;
+
+typedef enum {
+	IRPACKET_OK = 0,
+	IRPACKET_ERR_SHORT = -1,	// Less words than the header and the CRC
+	IRPACKET_ERR_VERSION = -2,	// Unknown version
+	IRPACKET_ERR_LENGTH = -3,	// Words do not fit to a number of targets
+	IRPACKET_ERR_CRC = -4,		// CRC error
+	IRPACKET_ERR_REFERENCE = -5	// Delta packet without its reference packet
+} IrPacket_ResultTypeDef;
+
+typedef struct {
+	int key_interval;		// Maximum number of packets between key packets
+	int valid;				// The reference packet is valid
+	int since_key;			// Packets since the last key packet
+	IrPacket_TypeDef ref;	// Last sent or received key packet
+} IrPacket_DeltaTypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+uint16_t IRPACKET_ToFixed(int pixel, int sub);
+int IRPACKET_FixedToMilli(uint16_t fixed);
+void IRPACKET_SetTarget(IrPacket_TargetTypeDef *target, int status,
+		int x, int subx, int y, int suby, int intensity);
+int IRPACKET_Encode(const IrPacket_TypeDef *packet, uint16_t *words, int max_words);
+IrPacket_ResultTypeDef IRPACKET_Decode(IrPacket_TypeDef *packet,
+		const uint16_t *words, int n);
+void IRPACKET_DeltaInit(IrPacket_DeltaTypeDef *delta, int key_interval);
+int IRPACKET_EncodeCompact(IrPacket_DeltaTypeDef *delta,
+		const IrPacket_TypeDef *packet, uint16_t *words, int max_words);
+IrPacket_ResultTypeDef IRPACKET_DecodeCompact(IrPacket_DeltaTypeDef *delta,
+		IrPacket_TypeDef *packet, const uint16_t *words, int n);
+uint16_t IRPACKET_Crc16(const uint16_t *words, int n);
+
+#endif /* IRPACKET_H_ */
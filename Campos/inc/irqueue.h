@@ -0,0 +1,64 @@
+/**
+ *  Project     Campos
+ *  @file		irqueue.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for irqueue.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IRQUEUE_H_
+#define IRQUEUE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "irpacket.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	IRQUEUE_DROP_NEWEST = 0,	// A full queue rejects the new packet
+	IRQUEUE_DROP_OLDEST = 1		// A full queue overwrites the oldest packet
+} IrQueue_PolicyTypeDef;
+
+typedef struct {
+	uint32_t queued;		// Packets put into the queue
+	uint32_t sent;			// Packets completely sent
+	uint32_t dropped;		// New packets rejected by a full queue
+	uint32_t overwritten;	// Old packets overwritten in a full queue
+	uint32_t skipped;		// Frames without header, because a packet was sent
+	uint32_t stale;			// Old packets removed at a header, not sent
+} IrQueue_CountersTypeDef;
+
+/* Defines -------------------------------------------------------------------*/
+
+// Number of packets in the queue. Must be a power of 2
+#define IRQUEUE_SIZE	4
+#define IRQUEUE_MASK	(IRQUEUE_SIZE-1)
+
+/* Global variables ----------------------------------------------------------*/
+extern IrQueue_CountersTypeDef irqueue_counters;
+
+/* Function prototypes -------------------------------------------------------*/
+void IRQUEUE_Init(IrQueue_PolicyTypeDef policy);
+void IRQUEUE_SetPolicy(IrQueue_PolicyTypeDef policy);
+int IRQUEUE_Put(const IrPacket_TypeDef *packet);
+int IRQUEUE_Get(IrPacket_TypeDef *packet);
+int IRQUEUE_Count(void);
+int IRQUEUE_Flush(void);
+
+#endif /* IRQUEUE_H_ */
@@ -0,0 +1,83 @@
+/**
+ *  Project     Campos
+ *  @file		latency.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for latency.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Frames that are followed at the same time. The IR packet of a frame
+// may be sent after the header of the next one. Must be a power of 2.
+#define LATENCY_FRAMES			4
+#define LATENCY_MASK			(LATENCY_FRAMES - 1)
+
+// The VSYNC and the frame interrupt come at the same edge. A VSYNC
+// shortly before the frame interrupt belongs already to the next frame.
+#define LATENCY_VSYNC_GAP_US	500
+
+// Histogram of the latency from VSYNC to the end of the IR packet
+#define LATENCY_BUCKET_US		1000
+#define LATENCY_BUCKETS			128
+
+/* Type defs -----------------------------------------------------------------*/
+
+// Time stamps of a frame on its way through the pipeline
+typedef enum {
+	LATENCY_VSYNC = 0,			// Start of the frame
+	LATENCY_FRAME = 1,			// Frame captured
+	LATENCY_TRACK_START = 2,	// TRACK_Search() called
+	LATENCY_TRACK_END = 3,		// Position found
+	LATENCY_IR_START = 4,		// The IR symbols of the packet start
+	LATENCY_IR_END = 5,			// Last IR symbol of the packet sent
+	LATENCY_POINTS
+} Latency_PointTypeDef;
+
+typedef struct {
+	uint16_t seq;						// Frame sequence number
+	uint8_t marked[LATENCY_POINTS];		// The time stamp was taken
+	uint32_t us[LATENCY_POINTS];		// Time stamps
+} Latency_FrameTypeDef;
+
+// Statistics of the time from one point to the next one
+typedef struct {
+	uint32_t count;
+	uint32_t max;
+	uint64_t sum;
+} Latency_StageTypeDef;
+
+/* Global variables  ---------------------------------------------------------*/
+extern uint32_t latency_last_us;	// Latency of the last sent IR packet
+extern uint32_t latency_count;		// Frames in the histogram
+
+/* Function Prototypes --------------------------------------------------------*/
+void LATENCY_Reset(void);
+void LATENCY_Vsync(void);
+void LATENCY_Frame(uint16_t seq, uint32_t us);
+void LATENCY_Mark(uint16_t seq, Latency_PointTypeDef point);
+void LATENCY_Print(void);
+
+#endif /* LATENCY_H_ */
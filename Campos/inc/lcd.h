@@ -35,6 +35,7 @@
 #define LCD_BLACK 0x0000
 #define LCD_WHITE 0xFFFF
 #define LCD_RED   0xF800
+#define LCD_YELLOW 0xFFE0
 
 #define LCD_Y_TRACK_STATUS	1
 #define LCD_Y_POSX			4
@@ -45,12 +46,25 @@
 #define LCD_OPAQUE 0
 #define LCD_TRANSPARENT 1
 
+// Magnification of the zoomed camera image
+#define LCD_ZOOM_1X 1
+#define LCD_ZOOM_2X 2
+#define LCD_ZOOM_4X 4
+
+// The visible area follows the light point
+#define LCD_PAN_AUTO -1
+
 /* Function prototypes -------------------------------------------------------*/
 
 void LCD_Init(void);
 void LCD_Print(int x, int y, char * s, int transparent);
 void LCD_Image_Zoomed(uint8_t* pixelp);
-void LCD_Image_Total(uint8_t* pixelp);
+void LCD_SetZoom(int zoom);
+void LCD_SetPan(int x, int y);
+void LCD_Trail(void);
+void LCD_ReadLine(int y, uint16_t *buf);
+void LCD_Image_Total(void);
+void LCD_Overview(void);
 void LCD_FocusStatusWindow(void);
 void LCD_MiniWindow(Camera_SizeTypeDef cameraSize);
 void LCD_Clr(void);
@@ -60,6 +60,13 @@ extern const uint8_t Font12_Table[];
 
 #define LCD_DATA(x)     LCD_DATA_GPIO_PORT->ODR = x
 
+/* Switch the direction of all 16 data pins */
+#define LCD_DATA_INPUT()   LCD_DATA_GPIO_PORT->MODER = 0x00000000
+#define LCD_DATA_OUTPUT()  LCD_DATA_GPIO_PORT->MODER = 0x55555555
+
+/* Wait loops for a RDX low pulse of at least 355ns */
+#define LCD_IO_READ_WAIT	16
+
 #define LCD_IO_WRITE_2xDATA(x) LCD_DATA(x);\
 							 LCD_WRX_GPIO_PORT->BSRRH = LCD_WRX_PIN; \
 							 LCD_WRX_GPIO_PORT->BSRRL = LCD_WRX_PIN; \
@@ -116,5 +123,6 @@ void LCD_IO_Init(void);
 void LCD_IO_WriteData(uint16_t RegValue);
 void LCD_IO_WriteReg(uint8_t Reg);
 uint16_t LCD_IO_ReadData(void);
+void LCD_IO_ReadBlock(uint16_t *buf, int n);
 
 #endif /* LCD_IO_H_ */
@@ -0,0 +1,66 @@
+/**
+ *  Project     Campos
+ *  @file		lcdline.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for lcdline.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LCDLINE_H_
+#define LCDLINE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Size of the video area in LCD pixels and of the zoomed camera window
+#define LCDLINE_SIZE			240
+#define LCDLINE_CAMERA_SIZE		120
+
+// Color of the cursor, LCD_RED
+#define LCDLINE_CURSOR			0xF800
+
+/* Type defs -----------------------------------------------------------------*/
+
+// One line of the zoomed image
+typedef union {
+	uint16_t pixel[LCDLINE_SIZE];
+	uint32_t pair[LCDLINE_SIZE / 2];
+} LcdLine_BufferTypeDef;
+
+// Geometry of the zoomed image
+typedef struct {
+	int zoom;		// LCD pixels per camera pixel: 1, 2 or 4
+	int span;		// visible camera pixels per line
+	int size;		// visible LCD pixels per line
+	int pan_x;		// upper left visible camera pixel
+	int pan_y;
+	int cursor_x;	// cursor in visible camera pixels, -1 without cursor
+	int cursor_y;	// cursor in camera pixels, -1 without cursor
+} LcdLine_ZoomTypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void LCDLINE_Setup(LcdLine_ZoomTypeDef *z, int zoom, int pan_x, int pan_y,
+		int position_x, int position_y, int cursor);
+void LCDLINE_Expand(const LcdLine_ZoomTypeDef *z, LcdLine_BufferTypeDef *line,
+		const uint8_t *pixels, int y, const uint16_t *table,
+		const uint32_t *table2);
+
+#endif /* LCDLINE_H_ */
@@ -36,6 +36,14 @@
 #define LED_GREEN LED4
 #define LED_BLUE  LED6
 
+// Deadlines of the tasks: maximum time from the event to the end in us
+#define MAIN_TRACK_DEADLINE_US		20000	// Before the next frame
+#define MAIN_IR_DEADLINE_US			5000	// Right after the track task
+#define MAIN_COMMAND_DEADLINE_US	50000
+#define MAIN_LCD_DEADLINE_US		100000
+#define MAIN_POWER_DEADLINE_US		200000	// Before the next tick
+#define MAIN_BACKGROUND_DEADLINE_US	10000
+
 /* Function prototypes -------------------------------------------------------*/
 void Error_Handler(void);
 
@@ -44,6 +44,17 @@ struct regval_list {
 #define OV5647_SC_CMMN_CHIP_ID_H 	0x300A
 #define OV5647_SC_CMMN_CHIP_ID_L 	0x300B
 
+// Exposure registers, the value is in 1/16 lines
+#define OV5647_EXPOSURE_H			0x3500
+#define OV5647_EXPOSURE_M			0x3501
+#define OV5647_EXPOSURE_L			0x3502
+#define OV5647_EXPOSURE				0x001008
+
+// Gain registers, the real gain is the value / 16
+#define OV5647_GAIN_H				0x350A
+#define OV5647_GAIN_L				0x350B
+#define OV5647_GAIN					0x07F
+
 /* Function prototypes -------------------------------------------------------*/
 
 void ov5647_Init(uint16_t DeviceAddr);
@@ -0,0 +1,51 @@
+/**
+ *  Project     Campos
+ *  @file		overview.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for overview.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef OVERVIEW_H_
+#define OVERVIEW_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// One overview pixel is the maximum of 12x12 camera pixels
+#define OVERVIEW_SCALE	12
+#define OVERVIEW_W		(2592 / OVERVIEW_SCALE)
+#define OVERVIEW_H		(1944 / OVERVIEW_SCALE)
+
+// Length of a dumped line: 2 hex digits per pixel and CR LF
+#define OVERVIEW_DUMP_LINE	(2 * OVERVIEW_W + 2)
+
+/* global variables ---------------------------------------------------------*/
+extern uint8_t overview[OVERVIEW_H][OVERVIEW_W];
+extern int overview_view; // Show the overview instead of the camera image
+
+/* Function prototypes -------------------------------------------------------*/
+void OVERVIEW_Init(void);
+void OVERVIEW_UpdateTotal(uint8_t* pixelp, int window_x, int window_y);
+void OVERVIEW_UpdateZoomed(uint8_t* pixelp, int offset_x, int offset_y);
+int OVERVIEW_DumpLine(int line, char *buf, int size);
+
+#endif /* OVERVIEW_H_ */
@@ -0,0 +1,91 @@
+/**
+ *  Project     Campos
+ *  @file		param.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for param.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This header does not use the HAL, the host tools take the parameter
+ *  ids and types from it.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PARAM_H_
+#define PARAM_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Maximum length of a parameter name
+#define PARAM_NAME_LEN			24
+
+// Key of a parameter in the flash, see config.c
+#define PARAM_CONFIG_KEY(id)	(0x0100 + (id))
+
+/* Type defs -----------------------------------------------------------------*/
+
+// The parameter ids. New parameters are added at the end, so the ids
+// of a tuning script stay valid.
+typedef enum {
+	PARAM_CAMERA_SIZE = 0,			// 1: zoomed, 2: total
+	PARAM_IR_FEC = 1,				// IrFec_ModeTypeDef
+	PARAM_IR_COMPACT = 2,			// 1: delta packets
+	PARAM_IR_POLICY = 3,			// IrQueue_PolicyTypeDef
+	PARAM_IR_SYMBOL_US = 4,			// duration of one IR symbol
+	PARAM_LCD_ZOOM = 5,				// 1, 2 or 4
+	PARAM_OVERVIEW = 6,				// 1: show the overview
+	PARAM_EXPOSURE = 7,				// exposure time in 1/16 lines
+	PARAM_GAIN = 8,					// sensor gain, 16 = 1x
+	PARAM_IR_CARRIER_HZ = 9,		// carrier frequency of the IR bursts
+	PARAM_TRACK_PIXEL_MIN = 10,		// darker pixels are not integrated
+	PARAM_TRACK_SEARCH_MIN = 11,	// brightest pixel of a light point
+	PARAM_TRACK_INTENSITY_MIN = 12,	// integral of a light point
+	PARAM_TRACK_LOST_FRAMES = 13,	// frames until the search restarts
+	PARAM_TRACK_WINDOW_STEP = 14,	// grid of the zoomed window position
+	PARAM_IR_LATENCY = 15,			// 1: send the latency in the IR packets
+	PARAMS
+} Param_IdTypeDef;
+
+typedef enum {
+	PARAM_INT = 0,		// Any value from min to max
+	PARAM_BOOL = 1,		// 0 or 1
+	PARAM_ENUM = 2		// A value of a typedef enum
+} Param_TypeTypeDef;
+
+typedef struct {
+	const char *name;
+	Param_TypeTypeDef type;
+	int stored;					// 1: the value is kept in the flash
+	int32_t min;
+	int32_t max;
+	int32_t def;				// Value after reset
+	int *value;					// Cached copy in the module, or NULL
+	int32_t (*get)(void);		// Reads the value, if there is no cached copy
+	void (*set)(int32_t value);	// Applies a new value, or NULL to only
+								// write the cached copy
+} Param_TypeDef;
+
+/* Function Prototypes --------------------------------------------------------*/
+const Param_TypeDef * PARAM_Info(int id);
+int32_t PARAM_Get(int id);
+int PARAM_Check(int id, int32_t value);
+int PARAM_Set(int id, int32_t value);
+void PARAM_Load(void);
+
+#endif /* PARAM_H_ */
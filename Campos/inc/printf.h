@@ -5,12 +5,18 @@
 
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "usartl1.h"
 
 
 /* Function prototypes -------------------------------------------------------*/
 int my_printf(const char *format, ...);
 int sprintf(char *out, const char *format, ...);
+int my_snprintf(char *out, size_t size, const char *format, ...);
+int my_vsnprintf(char *out, size_t size, const char *format, va_list args);
+int sprintf_fixed(char *out, size_t size, int32_t value, int int_digits, int frac_digits);
 
 
 #endif /* __PRINTF_H */
@@ -0,0 +1,114 @@
+/**
+ *  Project     Campos
+ *  @file		profile.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for profile.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The profiling is only compiled in, if the symbol PROFILE is defined.
+ *  The Debug configuration defines it, in the Release configuration all
+ *  PROFILE_ macros are empty.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#ifdef PROFILE
+#include "stm32f4xx_hal.h"
+#endif
+
+/* Defines -------------------------------------------------------------------*/
+
+// The measured zones: id and name
+#define PROFILE_ZONES(X) \
+	X(PROFILE_POWER,			"power task") \
+	X(PROFILE_USART_RX,			"UART receive") \
+	X(PROFILE_FRAMESTREAM,		"frame stream") \
+	X(PROFILE_TRACE,			"trace") \
+	X(PROFILE_CONFIG,			"config") \
+	X(PROFILE_LCD,				"LCD task") \
+	X(PROFILE_LCD_STATUS,		"LCD status") \
+	X(PROFILE_LCD_PRINT,		"LCD print") \
+	X(PROFILE_LCD_MINIWINDOW,	"LCD mini window") \
+	X(PROFILE_FRAME,			"frame") \
+	X(PROFILE_FRAME_COPY,		"frame copy") \
+	X(PROFILE_OVERVIEW,			"overview") \
+	X(PROFILE_TRACK,			"track search") \
+	X(PROFILE_IRLINK,			"IR send") \
+	X(PROFILE_LCD_IMAGE,		"LCD image") \
+	X(PROFILE_LCD_TRAIL,		"LCD trail") \
+	X(PROFILE_TELEMETRY,		"telemetry") \
+	X(PROFILE_IRQ_DCMI,			"DCMI IRQ") \
+	X(PROFILE_IRQ_CAMERA_DMA,	"camera DMA IRQ") \
+	X(PROFILE_IRQ_SYSTICK,		"SysTick IRQ") \
+	X(PROFILE_IRQ_USART,		"UART IRQ") \
+	X(PROFILE_IRQ_USART_DMA,	"UART DMA IRQ") \
+	X(PROFILE_IRQ_IRLINK_DMA,	"IR DMA IRQ")
+
+// Histogram with logarithmic buckets: bucket 0 counts durations below
+// 64 cycles, bucket n from 2^(n+5) to 2^(n+6)-1 cycles. The last bucket
+// also counts all longer ones (100ms and more).
+#define PROFILE_BUCKETS			20
+#define PROFILE_BUCKET_SHIFT	6
+
+// Longest line of PROFILE_DumpLine(): the values and all buckets
+#define PROFILE_DUMP_LINE		(16 + 9 + 3*10 + 2 + 16 + PROFILE_BUCKETS*22 + 2 + 1)
+
+#ifdef PROFILE
+// Measure a zone. A zone must not interrupt itself, the interrupts are
+// measured in separate zones. The time of an interrupt is included in
+// the zone that it interrupts.
+#define PROFILE_BEGIN(zone)		(profile_start[(zone)] = DWT->CYCCNT)
+#define PROFILE_END(zone)		PROFILE_Add((zone), DWT->CYCCNT - profile_start[(zone)])
+#else
+#define PROFILE_BEGIN(zone)
+#define PROFILE_END(zone)
+#define PROFILE_Init()
+#define PROFILE_Reset()
+#endif
+
+/* Type defs -----------------------------------------------------------------*/
+#define PROFILE_ENUM(id, name)	id,
+typedef enum {
+	PROFILE_ZONES(PROFILE_ENUM)
+	PROFILE_ZONE_IDS
+} Profile_ZoneIdTypeDef;
+#undef PROFILE_ENUM
+
+typedef struct {
+	uint32_t count;
+	uint32_t min;				// Cycles
+	uint32_t max;
+	uint64_t sum;				// For the mean value
+	uint32_t histogram[PROFILE_BUCKETS];
+} Profile_ZoneTypeDef;
+
+#ifdef PROFILE
+/* Global variables  ---------------------------------------------------------*/
+extern uint32_t profile_start[PROFILE_ZONE_IDS];
+
+/* Function Prototypes --------------------------------------------------------*/
+void PROFILE_Init(void);
+void PROFILE_Reset(void);
+void PROFILE_Add(Profile_ZoneIdTypeDef zone, uint32_t cycles);
+int PROFILE_DumpLine(int line, char *buf, int size);
+#endif
+
+#endif /* PROFILE_H_ */
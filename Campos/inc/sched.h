@@ -0,0 +1,83 @@
+/**
+ *  Project     Campos
+ *  @file		sched.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for sched.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SCHED_H_
+#define SCHED_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+// Priorities of the tasks, 0 is the highest one
+#define SCHED_PRIORITIES		5
+
+// Each event is queued only once, so a queue never overflows.
+// Must be a power of 2 and at least SCHED_EVENTS.
+#define SCHED_QUEUE_SIZE		8
+#define SCHED_QUEUE_MASK		(SCHED_QUEUE_SIZE - 1)
+
+/* Type defs -----------------------------------------------------------------*/
+
+// The events. Each one starts a task.
+typedef enum {
+	SCHED_FRAME = 0,		// A frame was captured
+	SCHED_IR = 1,			// The tracking result can be sent
+	SCHED_UART_RX = 2,		// Bytes were received by the debug port
+	SCHED_LCD = 3,			// The display can be updated
+	SCHED_TICK = 4,			// 200ms tick
+	SCHED_BACKGROUND = 5,	// 1ms tick for the streams and the flash
+	SCHED_EVENTS
+} Sched_EventTypeDef;
+
+typedef struct {
+	const char *name;
+	void (*task)(void);			// Runs to completion
+	uint8_t priority;
+	uint32_t deadline_us;		// Maximum time from the event to the end
+								// of the task
+	volatile uint8_t pending;	// The event is in the queue
+	volatile uint32_t post_us;	// Time of the event
+
+	// Statistics
+	uint32_t posts;				// Events
+	uint32_t overruns;			// Events while the last one was pending
+	uint32_t runs;
+	uint32_t misses;			// Deadline missed
+	uint32_t delay_min;			// Time from the event to the start in us.
+	uint32_t delay_max;			// max - min is the jitter.
+	uint64_t delay_sum;
+	uint32_t run_max;			// Run time of the task in us
+} Sched_TaskTypeDef;
+
+/* Function Prototypes --------------------------------------------------------*/
+void SCHED_Init(void);
+void SCHED_Register(Sched_EventTypeDef event, const char *name,
+		void (*task)(void), uint8_t priority, uint32_t deadline_us);
+void SCHED_Post(Sched_EventTypeDef event);
+void SCHED_Run(void);
+void SCHED_Reset(void);
+void SCHED_Print(void);
+
+#endif /* SCHED_H_ */
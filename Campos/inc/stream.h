@@ -0,0 +1,146 @@
+/**
+ *  Project     Campos
+ *  @file		stream.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for stream.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STREAM_H_
+#define STREAM_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "cobs.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+// Packet on the debug port, before COBS coding:
+//  type (8 bit), payload, CRC-16 of type and payload (little endian)
+// The COBS coded packet has a delimiter in front and behind it, so it can
+// be found between the ASCII output of the debug console.
+#define STREAM_TYPE_FRAME		0x01	// part of a camera frame
+#define STREAM_TYPE_TELEMETRY	0x02	// tracking result of one frame
+#define STREAM_TYPE_TRACE		0x03	// trace events
+#define STREAM_TYPE_REQUEST		0x04	// command from the host, see command.h
+#define STREAM_TYPE_RESPONSE	0x05	// answer to a command
+
+#define STREAM_MAX_PAYLOAD		512
+#define STREAM_MAX_PACKET		(COBS_MAX_ENCODED(1 + STREAM_MAX_PAYLOAD + 2) + 2)
+
+// Frame packet payload, all values little endian:
+//  flags (8 bit), frame number (16 bit), camera size, tile index (8 bit),
+//  width, height, crop offset x, y (16 bit), exposure, time stamp in us,
+//  offset of the first pixel in this packet (32 bit), number of pixels
+//  (16 bit), pixel data
+#define STREAM_FRAME_HEADER		27
+// Pixels per frame packet. 4 lines of a 120x120 frame
+#define STREAM_CHUNK_PIXELS		480
+
+// The pixel data is difference coded with 4 bit per pixel. Differences
+// that do not fit are escaped with STREAM_DELTA_ESCAPE and the pixel
+// value follows in 2 nibbles.
+#define STREAM_FLAG_DELTA		0x01
+#define STREAM_DELTA_ESCAPE		0x8
+
+// Telemetry packet payload, all values little endian:
+//  frame number (16 bit), time stamp in us (32 bit), status (8 bit),
+//  x, sub x, y, sub y (16 bit), intensity, exposure, processing time in us,
+//  dropped frames, dropped telemetry packets, dropped bytes of the debug
+//  port and dropped IR packets (32 bit)
+#define STREAM_TELEMETRY_SIZE	43
+
+// Trace packet payload, all values little endian:
+//  events dropped since the start of the trace (32 bit), then per event:
+//  time stamp in CPU cycles (32 bit), message id (16 bit), 2 arguments
+//  (32 bit)
+#define STREAM_TRACE_HEADER		4
+#define STREAM_TRACE_EVENT		14
+#define STREAM_TRACE_EVENTS		((STREAM_MAX_PAYLOAD - STREAM_TRACE_HEADER) / STREAM_TRACE_EVENT)
+
+/* Type defs -----------------------------------------------------------------*/
+typedef struct {
+	uint16_t frame;		// frame number
+	uint8_t size;		// Camera_SizeTypeDef
+	uint8_t tile;		// tile of a total frame: x + 3 * y
+	uint16_t width;		// frame size in pixels
+	uint16_t height;
+	uint16_t x;			// crop offset of the frame on the sensor
+	uint16_t y;
+	uint32_t exposure;	// exposure time in 1/16 lines
+	uint32_t timestamp;	// capture time in us
+} Stream_FrameTypeDef;
+
+typedef struct {
+	Stream_FrameTypeDef frame;
+	uint8_t flags;		// STREAM_FLAG_xx
+	uint32_t offset;	// first pixel of this packet
+	uint16_t count;		// number of pixels
+} Stream_ChunkTypeDef;
+
+typedef struct {
+	uint16_t frame;			// frame number
+	uint32_t timestamp;		// capture time in us
+	uint8_t status;			// Track_StatusTypeDef
+	uint16_t x;				// position in sensor pixels
+	uint16_t subx;			// sub pixel position from 0..999
+	uint16_t y;
+	uint16_t suby;
+	uint32_t intensity;		// integral of all pixel values
+	uint32_t exposure;		// exposure time in 1/16 lines
+	uint32_t process_us;	// processing time of the frame
+	uint32_t frames_dropped;	// frames that were lost, not the skipped ones
+	uint32_t telemetry_dropped;	// telemetry packets that did not fit
+	uint32_t uart_dropped;		// bytes that did not fit into the debug port
+	uint32_t ir_dropped;		// IR packets dropped, overwritten or stale
+} Stream_TelemetryTypeDef;
+
+typedef struct {
+	uint32_t cycles;		// time stamp in CPU cycles
+	uint32_t arg[2];		// arguments of the message
+	uint16_t id;			// Trace_IdTypeDef
+} Stream_TraceEventTypeDef;
+
+typedef enum {
+	STREAM_OK = 0,
+	STREAM_ERR_COBS = -1,	// Invalid COBS coding
+	STREAM_ERR_SHORT = -2,	// Less bytes than the header
+	STREAM_ERR_CRC = -3,	// CRC error
+	STREAM_ERR_FORMAT = -4	// Payload does not fit to the packet type
+} Stream_ResultTypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+int STREAM_Pack(uint8_t type, const uint8_t *payload, int n, uint8_t *packet);
+int STREAM_Unpack(const uint8_t *coded, int n, uint8_t *type,
+		uint8_t *payload, int max);
+int STREAM_DeltaEncode(const uint8_t *pixels, int n, uint8_t *out, int max);
+int STREAM_DeltaDecode(const uint8_t *data, int len, uint8_t *pixels, int n);
+int STREAM_EncodeChunk(Stream_ChunkTypeDef *chunk, const uint8_t *pixels,
+		uint8_t *packet);
+Stream_ResultTypeDef STREAM_DecodeChunk(Stream_ChunkTypeDef *chunk,
+		const uint8_t *payload, int n, uint8_t *pixels);
+int STREAM_EncodeTelemetry(const Stream_TelemetryTypeDef *t, uint8_t *packet);
+Stream_ResultTypeDef STREAM_DecodeTelemetry(Stream_TelemetryTypeDef *t,
+		const uint8_t *payload, int n);
+int STREAM_EncodeTrace(const Stream_TraceEventTypeDef *events, int count,
+		uint32_t dropped, uint8_t *packet);
+int STREAM_DecodeTrace(Stream_TraceEventTypeDef *events, int max,
+		uint32_t *dropped, const uint8_t *payload, int n);
+
+#endif /* STREAM_H_ */
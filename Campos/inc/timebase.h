@@ -0,0 +1,44 @@
+/**
+ *  Project     Campos
+ *  @file		timebase.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for timebase.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+// Timer 5 is 32 bit and runs with 84MHz / 84 = 1MHz. It overflows after
+// 71 minutes
+#define TIMEBASE_TIM			TIM5
+#define TIMEBASE_PRESCALER		84
+
+// Free running time in us
+#define TIMEBASE_Us()			(TIMEBASE_TIM->CNT)
+
+/* Function prototypes -------------------------------------------------------*/
+void TIMEBASE_Init(void);
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,86 @@
+/**
+ *  Project     Campos
+ *  @file		trace.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for trace.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This header does not use the HAL, the host tools take the message
+ *  texts from it.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stream.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+// The trace messages: id and printf format. The firmware only records the
+// id and the 2 arguments, the text is formatted by the host tool.
+// The arguments are 32 bit, so only %u, %d, %x and %c may be used.
+// New messages are added at the end, so old traces can still be decoded.
+#define TRACE_MESSAGES(X) \
+	X(TRACE_START,			"trace started, %u ms after reset") \
+	X(TRACE_TICK,			"tick %u ms") \
+	X(TRACE_FRAME_IRQ,		"frame %u captured, camera size %u") \
+	X(TRACE_FRAME_DISCARD,	"frame discarded after hold") \
+	X(TRACE_CAMERA_HOLD,	"capture held") \
+	X(TRACE_CAMERA_RELEASE,	"capture released, restart %u") \
+	X(TRACE_CAMERA_SIZE,	"camera size %u") \
+	X(TRACE_PROCESS_START,	"frame %u processing, %u us after capture") \
+	X(TRACE_TRACK,			"tracking status %u, intensity %u") \
+	X(TRACE_PROCESS_END,	"frame %u processed in %u us") \
+	X(TRACE_COMMAND,		"debug command '%c'") \
+	X(TRACE_REQUEST,		"request %u, command %u")
+
+// Number of events in the ring buffer. Must be a power of 2.
+#define TRACE_SIZE				256
+#define TRACE_MASK				(TRACE_SIZE - 1)
+
+// A packet is sent, if it is full or the last one is older than this
+#define TRACE_FLUSH_MS			20
+
+// Period of the TRACE_TICK events. They keep the host time stamps
+// consistent, the cycle counter overflows after 25s.
+#define TRACE_TICK_MS			100
+
+// Record an event. Only a flag is tested, if the trace is off.
+#define TRACE(id, a, b)			do { if (trace_on) TRACE_Event((id), (a), (b)); } while (0)
+
+/* Type defs -----------------------------------------------------------------*/
+#define TRACE_ENUM(id, text)	id,
+typedef enum {
+	TRACE_MESSAGES(TRACE_ENUM)
+	TRACE_IDS
+} Trace_IdTypeDef;
+#undef TRACE_ENUM
+
+/* Global variables  ---------------------------------------------------------*/
+extern volatile int trace_on;
+extern uint32_t trace_dropped;	// Events that did not fit into the ring buffer
+
+/* Function Prototypes --------------------------------------------------------*/
+void TRACE_Init(void);
+void TRACE_SetOn(int on);
+void TRACE_Event(Trace_IdTypeDef id, uint32_t a, uint32_t b);
+void TRACE_Task(void);
+
+#endif /* TRACE_H_ */
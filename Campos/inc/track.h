@@ -28,6 +28,21 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 
+/* Defines -------------------------------------------------------------------*/
+
+// Values after reset of the tuning parameters, see param.c
+#define TRACK_PIXEL_MIN			40		// Darker pixels are not integrated
+#define TRACK_SEARCH_MIN		128		// Brightest pixel of a light point
+#define TRACK_INTENSITY_MIN		2000	// Integral of a detected light point
+#define TRACK_LOST_FRAMES		50		// about 5sec until the search restarts
+
+// The zoomed window moves in steps on a grid, so it does not follow each
+// sub pixel movement. The light point stays at least half a step away
+// from the border, and more than 16 pixels for the center detection.
+#define TRACK_WINDOW_STEP		60
+#define TRACK_WINDOW_STEP_MIN	34
+#define TRACK_WINDOW_STEP_MAX	68
+
 /* Type defs -----------------------------------------------------------------*/
 typedef enum {
 	TRACK_INIT = 0,
@@ -47,6 +62,13 @@ extern int position_suby; 	// sub pixel position from 0..999
 extern int intensity; 		// intensity (integral of all pixel values)
 extern Track_StatusTypeDef track_status; // Status of tracking
 
+// Tuning parameters
+extern int track_pixel_min;
+extern int track_search_min;
+extern int track_intensity_min;
+extern int track_lost_frames;
+extern int track_window_step;
+
 
 /* Function prototypes -------------------------------------------------------*/
 void TRACK_Init(void);
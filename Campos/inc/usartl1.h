@@ -38,6 +38,8 @@ typedef struct {
 
 /* Global variables  ---------------------------------------------------------*/
 extern UART_HandleTypeDef UartHandle;
+extern DMA_HandleTypeDef hdma_usartl1_rx;
+extern uint32_t USARTL1_tx_dropped;
 
 /* Defines -------------------------------------------------------------------*/
 /* Definition for USARTx clock resources */
@@ -60,6 +62,7 @@ extern UART_HandleTypeDef UartHandle;
 /* Definition for USARTx's NVIC */
 #define USARTx_IRQn                      USART2_IRQn
 #define USARTx_IRQHandler                USART2_IRQHandler
+#define USARTx_DMA_TX_IRQHandler         DMA1_Stream6_IRQHandler
 
 /* Exported macro ------------------------------------------------------------*/
 #define COUNTOF(__BUFFER__)   (sizeof(__BUFFER__) / sizeof(*(__BUFFER__)))
@@ -73,12 +76,21 @@ extern UART_HandleTypeDef UartHandle;
 #define USARTL1_RX_SIZE 1024
 #define USARTL1_RX_MASK (USARTL1_RX_SIZE-1)
 
+// Position of the next byte the receive DMA will write
+#define USARTL1_RX_POS() ((USARTL1_RX_SIZE - \
+		__HAL_DMA_GET_COUNTER(&hdma_usartl1_rx)) & USARTL1_RX_MASK)
+
 
 /* Function Prototypes --------------------------------------------------------*/
 void USARTL1_Init(void);
-void USARTL1_RxBufferTask(void);
+void USARTL1_SetBaudrate(uint32_t baudrate);
+void USARTL1_Task(void);
+int USARTL1_RxBufferTask(void);
 int USARTL1_RxBufferNotEmpty(void);
-void USARTL1_PutByte(UART_HandleTypeDef *huart, uint8_t b);
+int USARTL1_TxFree(void);
+int USARTL1_Write(const uint8_t *data, int n);
+int USARTL1_PutByte(UART_HandleTypeDef *huart, uint8_t b);
+void USARTL1_DMA_TX_IRQHandler(void);
 void USARTL1_IRQHandler(UART_HandleTypeDef *huart);
 
 #endif /* USART_H_ */
@@ -30,18 +30,45 @@
 #include "stm32f4_discovery.h"
 #include "printf.h"
 #include "usartl1.h"
+#include "stream.h"
 
 /* Typedefs ------------------------------------------------------------------*/
 typedef enum {
 	DECODE_CMD, DECODE_ADDRESS, DECODE_DATA, DECODE_ENTER
 } enDecodeState;
 
+// Dumps, that are sent in the background
+typedef enum {
+	USARTL2_DUMP_NONE = 0,
+	USARTL2_DUMP_SCREENSHOT = 1,	// The LCD content, see scr2png
+	USARTL2_DUMP_OVERVIEW = 2,		// OVERVIEW_DumpLine()
+	USARTL2_DUMP_HISTORY = 3,		// HISTORY_DumpLine()
+	USARTL2_DUMP_PROFILE = 4,		// PROFILE_DumpLine(), only with PROFILE
+	USARTL2_DUMPS = 5
+} Usartl2_DumpTypeDef;
+
+
+
+/* Defines -------------------------------------------------------------------*/
+
+// Number of baud rates of the 'b' command
+#define USARTL2_BAUDRATES	6
+
+// Longest line of a dump: a line of the screenshot
+#define USARTL2_DUMP_LINE	(2 * (320 + 2))
 
+/* Global variables  ---------------------------------------------------------*/
+extern uint32_t telemetry_dropped;	// Telemetry packets that did not fit
+extern Usartl2_DumpTypeDef usartl2_dump;	// Dump that is sent
 
 /* Function Prototypes --------------------------------------------------------*/
 void USARTL2_Init(void);
 void USARTL2_Decode(char c);
-void USARTL2_FrameCallback(void);
+void USARTL2_FrameCallback(uint32_t process_us);
+void USARTL2_SetTelemetry(int on);
+void USARTL2_StartDump(Usartl2_DumpTypeDef dump);
+void USARTL2_DumpTask(void);
+int USARTL2_TxPaused(void);
 
 
 #endif /* USART_H_ */
@@ -0,0 +1,136 @@
+/**
+ *  Project     Campos
+ *  @file		boot.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Boot sequencer with a timeline of all boot phases
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "boot.h"
+#include "lcd.h"
+#include "track.h"
+#include "printf.h"
+
+/* local variables ----------------------------------------------------------*/
+uint32_t boot_time[BOOT_PHASES];	// Time stamp of each phase in ms
+uint32_t boot_marked = 0;			// One bit per phase that was reached
+int boot_splash = 0;				// The logo is still visible
+int boot_printed = 0;				// The timeline was printed
+
+static const char * const boot_names[BOOT_PHASES] = {
+	"reset",
+	"power",
+	"lcd",
+	"logo",
+	"irlink",
+	"usart",
+	"camera",
+	"track",
+	"first frame",
+	"first position",
+	"splash end"
+};
+
+/**
+ * @brief  Initialize the module. Must be called directly after the
+ * 		   systick was configured.
+ * @param  None
+ * @retval None
+ */
+void BOOT_Init(void) {
+	boot_marked = 0;
+	boot_splash = 1;
+	boot_printed = 0;
+	BOOT_Mark(BOOT_RESET);
+}
+
+/**
+ * @brief  Record the time stamp of a boot phase.
+ * 		   Only the first call per phase is recorded.
+ * @param  phase The boot phase that was reached
+ * @retval None
+ */
+void BOOT_Mark(Boot_PhaseTypeDef phase) {
+	if (boot_marked & (1 << phase))
+		return;
+
+	boot_time[phase] = HAL_GetTick();
+	boot_marked |= (1 << phase);
+}
+
+/**
+ * @brief  Cyclic task of the boot sequencer.
+ * 		   Removes the logo, if the first position was found or
+ * 		   after the timeout. Prints the timeline on the debug port.
+ * @param  None
+ * @retval 1 as long as the logo is visible
+ */
+int BOOT_Task(void) {
+	uint32_t t;
+
+	if (track_status == TRACK_CENTER_DETECTED) {
+		BOOT_Mark(BOOT_FIRST_POSITION);
+
+		// The position was found after the timeline was printed
+		if (boot_printed == 1) {
+			my_printf("Boot: %s at %d ms\r\n>", boot_names[BOOT_FIRST_POSITION],
+					boot_time[BOOT_FIRST_POSITION]);
+			boot_printed = 2;
+		}
+	}
+
+	if (!boot_splash)
+		return 0;
+
+	// Time since the logo is visible
+	t = HAL_GetTick() - boot_time[BOOT_LOGO];
+
+	if ((t >= BOOT_SPLASH_MAX_MS) || ((t >= BOOT_SPLASH_MIN_MS)
+			&& (boot_marked & (1 << BOOT_FIRST_POSITION)))) {
+
+		// Switch to the normal display
+		LCD_Clr();
+		LCD_DrawInfoWindow();
+		boot_splash = 0;
+		BOOT_Mark(BOOT_SPLASH_END);
+		BOOT_PrintTimeline();
+	}
+
+	return boot_splash;
+}
+
+/**
+ * @brief  Print the time stamps of all reached boot phases
+ * @param  None
+ * @retval None
+ */
+void BOOT_PrintTimeline(void) {
+	int i;
+
+	my_printf("\r\nBoot timeline:\r\n");
+	for (i = 0; i < BOOT_PHASES; i++) {
+		if (boot_marked & (1 << i))
+			my_printf("%5d ms %s\r\n", boot_time[i], boot_names[i]);
+		else
+			my_printf("   -- ms %s\r\n", boot_names[i]);
+	}
+	my_printf("\r\n>");
+
+	boot_printed = (boot_marked & (1 << BOOT_FIRST_POSITION)) ? 2 : 1;
+}
@@ -62,6 +62,9 @@
 #include "camera.h"
 #include "ov5647.h"
 #include "irlink.h"
+#include "trace.h"
+#include "latency.h"
+#include "sched.h"
 
 Union_PixelsType pixels; // Pixel field
 
@@ -75,30 +78,27 @@ Camera_SizeTypeDef size;
 int capturing = 0;
 DCMI_HandleTypeDef hdcmi_eval;
 int suppressFirstFrame = 0;
+int powered = 0;
+uint32_t power_on_tick = 0;
+uint32_t camera_exposure = OV5647_EXPOSURE; // exposure time in 1/16 lines
+uint32_t camera_gain = OV5647_GAIN; // sensor gain, 16 = 1x
+int camera_hold = 0;	// Stop the capture after each frame
+int camera_held = 0;	// The capture is stopped, the pixels stay valid
+int camera_restart = 0;	// The size was changed while the capture was stopped
+int camera_discard = 0;	// Frames to discard after the capture was resumed
+uint32_t camera_skipped = 0;	// Frames that were not processed on purpose
 
 /* Prototypes of local functions ---------------------------------------------*/
 static void DCMI_MspInit(void);
 
 /**
- * @brief  Initializes the camera.
- * @param  Camera: Pointer to the camera configuration structure
- * @retval Camera status
+ * @brief  Switch on the camera supply.
+ * 		   The camera needs CAMERA_POWERUP_MS to power up, so this should
+ * 		   be called early to use this time for other initializations.
+ * @param  None
+ * @retval None
  */
-uint8_t BSP_CAMERA_Init() {
-	DCMI_HandleTypeDef *phdcmi;
-
-	uint8_t ret = CAMERA_ERROR;
-	size_x = 120;
-	size_y = 120;
-	offset_x = 0;
-	offset_y = 0;
-	window_x = 0;
-	window_y = 0;
-	new_window_x = 0;
-	new_window_y = 0;
-	offset_window_x = 0;
-	offset_window_y = 0;
-
+void BSP_CAMERA_PowerOn(void) {
 	/* Configure IO functionalities for CAMERA detect pin */
 	GPIO_InitTypeDef GPIO_InitStruct;
 
@@ -119,6 +119,35 @@ uint8_t BSP_CAMERA_Init() {
 	HAL_GPIO_WritePin(CAMERA_LED_PORT, CAMERA_LED_PIN, GPIO_PIN_SET);
 	HAL_GPIO_WritePin(CAMERA_ON_PORT, CAMERA_ON_PIN, GPIO_PIN_SET);
 
+	power_on_tick = HAL_GetTick();
+	powered = 1;
+}
+
+/**
+ * @brief  Initializes the camera.
+ * @param  Camera: Pointer to the camera configuration structure
+ * @retval Camera status
+ */
+uint8_t BSP_CAMERA_Init() {
+	DCMI_HandleTypeDef *phdcmi;
+	uint32_t t;
+
+	uint8_t ret = CAMERA_ERROR;
+	size_x = 120;
+	size_y = 120;
+	offset_x = 0;
+	offset_y = 0;
+	window_x = 0;
+	window_y = 0;
+	new_window_x = 0;
+	new_window_y = 0;
+	offset_window_x = 0;
+	offset_window_y = 0;
+
+	// Switch on the camera, if it was not done before
+	if (!powered)
+		BSP_CAMERA_PowerOn();
+
 	/* Get the DCMI handle structure */
 	phdcmi = &hdcmi_eval;
 
@@ -132,8 +161,11 @@ uint8_t BSP_CAMERA_Init() {
 	phdcmi->Init.PCKPolarity = DCMI_PCKPOLARITY_RISING;
 	phdcmi->Instance = DCMI;
 
-	// wait until camera is powered up
-	CAMERA_Delay(100);
+	// wait until camera is powered up. The time since BSP_CAMERA_PowerOn()
+	// was already used by the other modules.
+	t = HAL_GetTick() - power_on_tick;
+	if (t < CAMERA_POWERUP_MS)
+		CAMERA_Delay(CAMERA_POWERUP_MS - t);
 
 	/* DCMI Initialization */
 	DCMI_MspInit();
@@ -180,8 +212,9 @@ Camera_SizeTypeDef BSP_CAMERA_GetSize(void) {
  */
 void BSP_CAMERA_SetSize(Camera_SizeTypeDef s) {
 	int stop_start = 0;
-	stop_start = capturing;
+	stop_start = capturing || camera_held;
 
+	TRACE(TRACE_CAMERA_SIZE, s, 0);
 	size = s;
 	if (size == CAMERA_ZOOMED) {
 		size_x = 120;
@@ -199,7 +232,11 @@ void BSP_CAMERA_SetSize(Camera_SizeTypeDef s) {
 		HAL_DCMI_Init(&hdcmi_eval);
 		HAL_DCMI_EnableCROP(&hdcmi_eval);
 		BSP_CAMERA_SetOffset(0,0);
-		BSP_CAMERA_ContinuousStart();
+		// Start it later, if the pixels are still needed
+		if (camera_held)
+			camera_restart = 1;
+		else
+			BSP_CAMERA_ContinuousStart();
 	    /* Process Unlocked */
 		__HAL_UNLOCK(&hdcmi_eval);
 
@@ -222,6 +259,40 @@ void BSP_CAMERA_ContinuousStart(void) {
 	// Start the camera capture
 	HAL_DCMI_Start_DMA(&hdcmi_eval, DCMI_MODE_CONTINUOUS, (uint32_t) (&pixels.firstByte),bytes);
 	capturing = 1;
+	camera_held = 0;
+}
+
+/**
+ * @brief  Stop the capture after each frame, so the pixels are not
+ *         overwritten until BSP_CAMERA_Release() is called.
+ * @param  hold 1 to stop after each frame, 0 for continuous capture
+ * @retval None
+ */
+void BSP_CAMERA_SetHold(int hold) {
+	camera_hold = hold;
+	if (!hold)
+		BSP_CAMERA_Release();
+}
+
+/**
+ * @brief  Continue the capture after it was stopped by the hold mode.
+ *         The first frame may be incomplete and is discarded.
+ * @param  None
+ * @retval None
+ */
+void BSP_CAMERA_Release(void) {
+	if (!camera_held)
+		return;
+	camera_held = 0;
+	TRACE(TRACE_CAMERA_RELEASE, camera_restart, 0);
+
+	if (camera_restart) {
+		camera_restart = 0;
+		BSP_CAMERA_ContinuousStart();
+	} else {
+		camera_discard = 1;
+		BSP_CAMERA_Resume();
+	}
 }
 
 /**
@@ -273,6 +344,20 @@ uint8_t BSP_CAMERA_Stop(void) {
 
 void BSP_CAMERA_DebugWrite(uint16_t Reg, uint8_t Value) {
 	CAMERA_IO_Write(CAMERA_I2C_ADDRESS, Reg, Value);
+
+	// Keep track of the exposure time
+	if (Reg == OV5647_EXPOSURE_H)
+		camera_exposure = (camera_exposure & 0x0FFFF) | ((uint32_t)(Value & 0x0F) << 16);
+	if (Reg == OV5647_EXPOSURE_M)
+		camera_exposure = (camera_exposure & 0xF00FF) | ((uint32_t)Value << 8);
+	if (Reg == OV5647_EXPOSURE_L)
+		camera_exposure = (camera_exposure & 0xFFF00) | Value;
+
+	// and of the gain
+	if (Reg == OV5647_GAIN_H)
+		camera_gain = (camera_gain & 0x0FF) | ((uint32_t)(Value & 0x03) << 8);
+	if (Reg == OV5647_GAIN_L)
+		camera_gain = (camera_gain & 0x300) | Value;
 }
 
 uint8_t BSP_CAMERA_DebugRead(uint16_t Reg) {
@@ -414,6 +499,7 @@ __weak void BSP_CAMERA_LineEventCallback(void) {
  * @retval None
  */
 void HAL_DCMI_VsyncEventCallback(DCMI_HandleTypeDef *hdcmi) {
+	LATENCY_Vsync();
 	BSP_CAMERA_VsyncEventCallback();
 }
 
@@ -439,6 +525,24 @@ void HAL_DCMI_FrameEventCallback(DCMI_HandleTypeDef *hdcmi) {
 
 	// Send IR header. It's also the sync pulse
 	IRLINK_StartHeader();
+	LATENCY_Frame(irlink_frame_seq, irlink_frame_us);
+
+	// The first frame after a hold may be incomplete.
+	// The window is not moved, so the next frame captures it again.
+	if (camera_discard > 0) {
+		camera_discard--;
+		camera_skipped++;
+		TRACE(TRACE_FRAME_DISCARD, 0, 0);
+		return;
+	}
+	TRACE(TRACE_FRAME_IRQ, irlink_frame_seq, size);
+
+	// Keep the pixels until they are released
+	if (camera_hold) {
+		BSP_CAMERA_Suspend();
+		camera_held = 1;
+		TRACE(TRACE_CAMERA_HOLD, 0, 0);
+	}
 
 	//BSP_CAMERA_FrameEventCallback();
 	frame_flag = 1;
@@ -471,6 +575,7 @@ void HAL_DCMI_FrameEventCallback(DCMI_HandleTypeDef *hdcmi) {
 
 				// wait one frame
 				suppressFirstFrame = 1;
+				SCHED_Post(SCHED_FRAME);
 				return;
 			}
 		}
@@ -483,7 +588,12 @@ void HAL_DCMI_FrameEventCallback(DCMI_HandleTypeDef *hdcmi) {
 	if (suppressFirstFrame > 0) {
 		suppressFirstFrame--;
 		frame_flag = 0;
+		camera_skipped++;
 	}
+
+	// Start the track task
+	if (frame_flag)
+		SCHED_Post(SCHED_FRAME);
 }
 
 /**
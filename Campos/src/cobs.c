@@ -0,0 +1,99 @@
+/**
+ *  Project     Campos
+ *  @file		cobs.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Consistent overhead byte stuffing (COBS)
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The encoded data contains no zero bytes, so a zero byte marks the end of
+ *  a packet. Each block starts with a code byte: the number of following
+ *  bytes plus one. A block shorter than 254 bytes is followed by a zero in
+ *  the original data. The overhead is at most one byte per 254 bytes.
+ *  This module does not use the HAL, so the host tools use it, too.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "cobs.h"
+
+/**
+ * @brief  Encode a block of data. The delimiter is not added.
+ * @param  data the data to encode
+ * @param  n number of bytes
+ * @param  coded output, COBS_MAX_ENCODED(n) bytes
+ * @retval Number of encoded bytes
+ */
+int COBS_Encode(const uint8_t *data, int n, uint8_t *coded) {
+	int code_pos = 0;	// Position of the code byte of the actual block
+	int pos = 1;
+	uint8_t code = 1;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (data[i] == 0) {
+			coded[code_pos] = code;
+			code_pos = pos++;
+			code = 1;
+		} else {
+			coded[pos++] = data[i];
+			code++;
+			// Block with the maximum length, without a zero behind it
+			if (code == 0xFF) {
+				coded[code_pos] = code;
+				code_pos = pos++;
+				code = 1;
+			}
+		}
+	}
+	coded[code_pos] = code;
+
+	return pos;
+}
+
+/**
+ * @brief  Decode a packet without the delimiter
+ * @param  coded the encoded packet
+ * @param  n number of encoded bytes
+ * @param  data output
+ * @param  max size of the output buffer
+ * @retval Number of decoded bytes or -1, if the packet is invalid
+ */
+int COBS_Decode(const uint8_t *coded, int n, uint8_t *data, int max) {
+	int pos = 0;
+	int len = 0;
+	int code, i;
+
+	while (pos < n) {
+		code = coded[pos++];
+		if ((code == 0) || (pos + code - 1 > n))
+			return -1;
+
+		for (i = 1; i < code; i++) {
+			if (len >= max)
+				return -1;
+			data[len++] = coded[pos++];
+		}
+
+		// A zero follows all blocks but the full ones and the last one
+		if ((code != 0xFF) && (pos < n)) {
+			if (len >= max)
+				return -1;
+			data[len++] = 0;
+		}
+	}
+
+	return len;
+}
@@ -0,0 +1,303 @@
+/**
+ *  Project     Campos
+ *  @file		command.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Binary request and response protocol on the debug port
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The ASCII console never sends a 0 byte, so a 0 byte starts a request
+ *  packet. The bytes are collected until the next 0 byte, then the
+ *  request is executed and answered. A request packet can carry many
+ *  register or parameter accesses, so a tuning tool does not need a
+ *  round trip for each register.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <string.h>
+#include "command.h"
+#include "usartl1.h"
+#include "camera.h"
+#include "irlink.h"
+#include "framestream.h"
+#include "trace.h"
+
+/* local variables ----------------------------------------------------------*/
+int command_receiving = 0;		// Between the 0 bytes of a request
+int command_overflow = 0;		// The request was too long
+int command_len = 0;
+uint32_t command_tick;			// Time of the last received byte
+uint32_t command_requests = 0;	// Executed requests
+uint32_t command_errors = 0;	// Requests with COBS or CRC errors
+int command_pending = 0;		// Length of the response that waits for space
+uint8_t command_coded[STREAM_MAX_PACKET];
+uint8_t command_request[STREAM_MAX_PAYLOAD];
+uint8_t command_response[STREAM_MAX_PAYLOAD];
+uint8_t command_packet[STREAM_MAX_PACKET];
+
+/**
+ * @brief  Write a 16 bit value little endian
+ */
+static void COMMAND_Put16(uint8_t *p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+/**
+ * @brief  Write a 32 bit value little endian
+ */
+static void COMMAND_Put32(uint8_t *p, uint32_t v) {
+	COMMAND_Put16(p, v & 0xFFFF);
+	COMMAND_Put16(p + 2, v >> 16);
+}
+
+/**
+ * @brief  Read a 16 bit value little endian
+ */
+static uint16_t COMMAND_Get16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * @brief  Read a 32 bit value little endian
+ */
+static uint32_t COMMAND_Get32(const uint8_t *p) {
+	return COMMAND_Get16(p) | ((uint32_t) COMMAND_Get16(p + 2) << 16);
+}
+
+/* Commands -----------------------------------------------------------------*/
+
+/**
+ * @brief  Execute a request
+ * @param  cmd the command
+ * @param  args the arguments
+ * @param  n length of the arguments
+ * @param  result output: the result
+ * @param  len output: length of the result
+ * @retval status
+ */
+static Command_StatusTypeDef COMMAND_Execute(uint8_t cmd, const uint8_t *args,
+		int n, uint8_t *result, int *len) {
+	const Param_TypeDef *param;
+	uint8_t *info;
+	int i, count;
+	int32_t value;
+
+	*len = 0;
+	switch (cmd) {
+	case COMMAND_PING:
+		if (n != 0)
+			return COMMAND_ERR_LENGTH;
+		result[0] = COMMAND_VERSION;
+		COMMAND_Put16(&result[1], irlink_frame_seq);
+		COMMAND_Put32(&result[3], HAL_GetTick());
+		*len = 7;
+		return COMMAND_OK;
+
+	case COMMAND_REG_READ:
+		count = n / 2;
+		if ((n % 2 != 0) || (count > COMMAND_MAX_ITEMS))
+			return COMMAND_ERR_LENGTH;
+		for (i = 0; i < count; i++)
+			result[i] = BSP_CAMERA_DebugRead(COMMAND_Get16(&args[2 * i]));
+		*len = count;
+		return COMMAND_OK;
+
+	case COMMAND_REG_WRITE:
+		count = n / 3;
+		if ((n % 3 != 0) || (count > COMMAND_MAX_ITEMS))
+			return COMMAND_ERR_LENGTH;
+		for (i = 0; i < count; i++)
+			BSP_CAMERA_DebugWrite(COMMAND_Get16(&args[3 * i]), args[3 * i + 2]);
+		return COMMAND_OK;
+
+	case COMMAND_PARAM_GET:
+		if (n > COMMAND_MAX_ITEMS)
+			return COMMAND_ERR_LENGTH;
+		for (i = 0; i < n; i++)
+			if (args[i] >= PARAMS)
+				return COMMAND_ERR_RANGE;
+		for (i = 0; i < n; i++)
+			COMMAND_Put32(&result[4 * i], PARAM_Get(args[i]));
+		*len = 4 * n;
+		return COMMAND_OK;
+
+	case COMMAND_PARAM_SET:
+		count = n / 5;
+		if ((n % 5 != 0) || (count > COMMAND_MAX_ITEMS))
+			return COMMAND_ERR_LENGTH;
+		// Check all values first, so nothing is set, if one is invalid
+		for (i = 0; i < count; i++) {
+			value = COMMAND_Get32(&args[5 * i + 1]);
+			if (!PARAM_Check(args[5 * i], value))
+				return COMMAND_ERR_RANGE;
+		}
+		for (i = 0; i < count; i++) {
+			PARAM_Set(args[5 * i], COMMAND_Get32(&args[5 * i + 1]));
+			COMMAND_Put32(&result[4 * i], PARAM_Get(args[5 * i]));
+		}
+		*len = 4 * count;
+		return COMMAND_OK;
+
+	case COMMAND_STREAM:
+		if (n != 3)
+			return COMMAND_ERR_LENGTH;
+		if ((args[0] != COMMAND_UNCHANGED) && (args[0] >= FRAMESTREAM_MODES))
+			return COMMAND_ERR_RANGE;
+		COMMAND_Put32(&result[0], framestream_sent);
+		COMMAND_Put32(&result[4], framestream_skipped);
+		COMMAND_Put32(&result[8], telemetry_dropped);
+		COMMAND_Put32(&result[12], trace_dropped);
+		COMMAND_Put32(&result[16], USARTL1_tx_dropped);
+		*len = 20;
+		if (args[0] != COMMAND_UNCHANGED)
+			FRAMESTREAM_SetMode(args[0]);
+		if (args[1] != COMMAND_UNCHANGED)
+			USARTL2_SetTelemetry(args[1]);
+		if (args[2] != COMMAND_UNCHANGED)
+			TRACE_SetOn(args[2]);
+		return COMMAND_OK;
+
+	case COMMAND_PARAM_INFO:
+		if (n > COMMAND_MAX_INFO)
+			return COMMAND_ERR_LENGTH;
+		for (i = 0; i < n; i++)
+			if (args[i] >= PARAMS)
+				return COMMAND_ERR_RANGE;
+		result[0] = PARAMS;
+		for (i = 0; i < n; i++) {
+			param = PARAM_Info(args[i]);
+			info = &result[1 + i * COMMAND_PARAM_INFO_SIZE];
+			info[0] = param->type;
+			COMMAND_Put32(&info[1], param->min);
+			COMMAND_Put32(&info[5], param->max);
+			COMMAND_Put32(&info[9], param->def);
+			// strncpy fills up the name with 0
+			strncpy((char *) &info[13], param->name, PARAM_NAME_LEN);
+		}
+		*len = 1 + n * COMMAND_PARAM_INFO_SIZE;
+		return COMMAND_OK;
+
+	default:
+		return COMMAND_ERR_UNKNOWN;
+	}
+}
+
+/**
+ * @brief  Decode, execute and answer a received request
+ * @param  None
+ * @retval None
+ */
+static void COMMAND_Request(void) {
+	Command_StatusTypeDef status;
+	uint8_t type;
+	int n, len;
+
+	n = STREAM_Unpack(command_coded, command_len, &type, command_request,
+			sizeof(command_request));
+	if ((n < COMMAND_REQUEST_HEADER) || (type != STREAM_TYPE_REQUEST)) {
+		command_errors++;
+		return;
+	}
+	command_requests++;
+	TRACE(TRACE_REQUEST, COMMAND_Get16(command_request), command_request[2]);
+
+	status = COMMAND_Execute(command_request[2],
+			&command_request[COMMAND_REQUEST_HEADER], n - COMMAND_REQUEST_HEADER,
+			&command_response[COMMAND_RESPONSE_HEADER], &len);
+
+	// The response repeats sequence number and command
+	command_response[0] = command_request[0];
+	command_response[1] = command_request[1];
+	command_response[2] = command_request[2];
+	command_response[3] = status;
+	command_pending = STREAM_Pack(STREAM_TYPE_RESPONSE, command_response,
+			COMMAND_RESPONSE_HEADER + len, command_packet);
+
+	// A response must not be dropped. If the stream packets fill the
+	// buffer, it waits for the background task.
+	COMMAND_Task();
+}
+
+/**
+ * @brief  Cyclic task. Sends the response, if it fits into the transmit
+ * 		   buffer.
+ * @param  None
+ * @retval None
+ */
+void COMMAND_Task(void) {
+	if ((command_pending != 0) && (USARTL1_TxFree() >= command_pending)) {
+		USARTL1_Write(command_packet, command_pending);
+		command_pending = 0;
+	}
+}
+
+/**
+ * @brief  Returns, whether a response waits for space in the transmit
+ * 		   buffer. Until it is sent, no new request is processed.
+ * @param  None
+ * @retval 1 if a response is pending
+ */
+int COMMAND_Pending(void) {
+	return command_pending != 0;
+}
+
+/**
+ * @brief  Returns, whether a request is being received. An incomplete
+ * 		   request is discarded after COMMAND_TIMEOUT_MS.
+ * @param  None
+ * @retval 1 if the next byte belongs to a request
+ */
+int COMMAND_Receiving(void) {
+	if (command_receiving && (HAL_GetTick() - command_tick > COMMAND_TIMEOUT_MS)) {
+		command_receiving = 0;
+		command_errors++;
+	}
+	return command_receiving;
+}
+
+/**
+ * @brief  Process a received byte of a request. The first 0 byte starts
+ * 		   the request, the next one ends it.
+ * @param  c the received byte
+ * @retval None
+ */
+void COMMAND_Receive(uint8_t c) {
+	command_tick = HAL_GetTick();
+
+	if (c != COBS_DELIMITER) {
+		if (command_len < (int) sizeof(command_coded))
+			command_coded[command_len++] = c;
+		else
+			command_overflow = 1;
+		return;
+	}
+
+	// Start of a request. 2 delimiters in a row are also a start.
+	if (!command_receiving || (command_len == 0)) {
+		command_receiving = 1;
+		command_len = 0;
+		command_overflow = 0;
+		return;
+	}
+
+	// End of the request
+	command_receiving = 0;
+	if (command_overflow)
+		command_errors++;
+	else
+		COMMAND_Request();
+}
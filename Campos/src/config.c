@@ -0,0 +1,376 @@
+/**
+ *  Project     Campos
+ *  @file		config.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Key value store in 2 flash sectors (EEPROM emulation)
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  A new value is appended as record to the active sector, the last
+ *  record of a key is valid. So a sector is erased only after it was
+ *  filled up, and both sectors wear evenly.
+ *  If the active sector is full, the latest values are copied into the
+ *  other sector, which becomes the active one. The old sector is erased
+ *  at the next reset, because the CPU can not read the flash while a
+ *  sector is erased, and that takes more than 1 second.
+ *
+ *  All values are also in a RAM copy. CONFIG_Write() only changes the
+ *  copy, the main loop programs one record with each call of
+ *  CONFIG_Task(), so the tracking is never blocked by the flash.
+ *
+ *  After a power fail, the last complete record or sector is used:
+ *  A record without valid CRC is skipped, a sector that was not
+ *  completely copied is still RECEIVING and is erased.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <string.h>
+#include "config.h"
+#include "crc.h"
+
+/* global variables ---------------------------------------------------------*/
+uint32_t config_generation = 0;	// Generation of the active sector
+uint32_t config_records = 0;	// Used records of the active sector
+uint32_t config_errors = 0;		// Failed flash operations
+int config_full = 0;			// No space until the next reset
+
+/* local variables ----------------------------------------------------------*/
+int config_active = -1;			// Active sector, -1: none
+uint32_t config_free;			// Next free word in the active sector
+int config_spare_erased = 0;	// The other sector can take a transfer
+int config_transfer = 0;		// The values are copied into the other sector
+int config_copy;				// Next entry to copy
+uint32_t config_copy_free;		// Next free word in the other sector
+Config_EntryTypeDef config_entries[CONFIG_MAX_KEYS];
+
+/**
+ * @brief  CRC of a record
+ */
+static uint16_t CONFIG_Crc(uint16_t key, uint32_t value) {
+	uint8_t b[6];
+
+	b[0] = key & 0xFF;
+	b[1] = key >> 8;
+	b[2] = value & 0xFF;
+	b[3] = (value >> 8) & 0xFF;
+	b[4] = (value >> 16) & 0xFF;
+	b[5] = value >> 24;
+	return CRC_Crc16Bytes(CRC16_INIT, b, sizeof(b));
+}
+
+/**
+ * @brief  Find the entry of a key in the RAM copy
+ * @param  key the key
+ * @param  add 1: use a free entry, if the key is new
+ * @retval the entry or NULL
+ */
+static Config_EntryTypeDef * CONFIG_Find(uint16_t key, int add) {
+	Config_EntryTypeDef *unused = NULL;
+	int i;
+
+	for (i = 0; i < CONFIG_MAX_KEYS; i++) {
+		if (config_entries[i].state == CONFIG_FREE) {
+			if (!unused)
+				unused = &config_entries[i];
+		} else if (config_entries[i].key == key) {
+			return &config_entries[i];
+		}
+	}
+	if (!add || !unused)
+		return NULL;
+	unused->key = key;
+	return unused;
+}
+
+/**
+ * @brief  Checks, whether a sector is completely erased
+ * @param  s sector
+ * @retval 1 if erased
+ */
+static int CONFIG_Blank(int s) {
+	volatile uint32_t *p = config_sectors[s];
+	uint32_t i;
+
+	for (i = 0; i < config_sector_words; i++)
+		if (p[i] != CONFIG_ERASED)
+			return 0;
+	return 1;
+}
+
+/**
+ * @brief  Erase a sector, if it is not empty
+ * @param  s sector
+ * @retval 0 on success
+ */
+static int CONFIG_Erase(int s) {
+	if (CONFIG_Blank(s))
+		return 0;
+	if ((CONFIG_FlashErase(s) != 0) || !CONFIG_Blank(s)) {
+		config_errors++;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Program a word
+ * @retval 0 on success
+ */
+static int CONFIG_Program(volatile uint32_t *address, uint32_t value) {
+	if (CONFIG_FlashProgram(address, value) != 0) {
+		config_errors++;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Append a record. A failed record is skipped.
+ * @param  s sector
+ * @param  pos next free word of the sector, it is incremented
+ * @param  key the key
+ * @param  value the value
+ * @retval 0 on success
+ */
+static int CONFIG_ProgramRecord(int s, uint32_t *pos, uint16_t key,
+		uint32_t value) {
+	volatile uint32_t *p = &config_sectors[s][*pos];
+
+	if (*pos + CONFIG_RECORD_WORDS > config_sector_words)
+		return -1;
+	*pos += CONFIG_RECORD_WORDS;
+
+	// The value first, the key word completes the record
+	if (CONFIG_Program(&p[0], value) != 0)
+		return -1;
+	return CONFIG_Program(&p[1], key | ((uint32_t) CONFIG_Crc(key, value) << 16));
+}
+
+/**
+ * @brief  Read all records of a sector into the RAM copy
+ * @param  s sector
+ * @retval None
+ */
+static void CONFIG_Load(int s) {
+	volatile uint32_t *p = config_sectors[s];
+	Config_EntryTypeDef *e;
+	uint32_t i, value, tag;
+
+	config_free = CONFIG_HEADER_WORDS;
+	for (i = CONFIG_HEADER_WORDS; i + CONFIG_RECORD_WORDS <= config_sector_words;
+			i += CONFIG_RECORD_WORDS) {
+		value = p[i];
+		tag = p[i + 1];
+		if ((value == CONFIG_ERASED) && (tag == CONFIG_ERASED))
+			break;
+		config_free = i + CONFIG_RECORD_WORDS;
+
+		// A record with a wrong CRC was interrupted
+		if ((tag == CONFIG_ERASED) || ((tag >> 16) != CONFIG_Crc(tag, value)))
+			continue;
+		e = CONFIG_Find(tag & 0xFFFF, 1);
+		if (e) {
+			e->value = value;
+			e->state = CONFIG_STORED;
+		}
+	}
+	config_records = (config_free - CONFIG_HEADER_WORDS) / CONFIG_RECORD_WORDS;
+}
+
+/**
+ * @brief  Find the active sector and read the values. This may erase a
+ * 		   sector, so it is called before the camera is started.
+ * @param  None
+ * @retval None
+ */
+void CONFIG_Init(void) {
+	volatile uint32_t *s0 = config_sectors[0];
+	volatile uint32_t *s1 = config_sectors[1];
+	int spare;
+
+	memset(config_entries, 0, sizeof(config_entries));
+	config_active = -1;
+	config_full = 0;
+	config_transfer = 0;
+	config_spare_erased = 0;
+
+	// After a transfer both sectors are valid, the newer one is active
+	if ((s0[0] == CONFIG_VALID) && (s1[0] == CONFIG_VALID))
+		config_active = ((int32_t)(s1[1] - s0[1]) > 0) ? 1 : 0;
+	else if (s0[0] == CONFIG_VALID)
+		config_active = 0;
+	else if (s1[0] == CONFIG_VALID)
+		config_active = 1;
+
+	// No values yet: start with sector 0
+	if (config_active < 0) {
+		if ((CONFIG_Erase(0) != 0) || (CONFIG_Program(&s0[1], 1) != 0)
+				|| (CONFIG_Program(&s0[0], CONFIG_VALID) != 0)) {
+			config_full = 1;
+			return;
+		}
+		config_active = 0;
+	}
+
+	// The other sector takes the next transfer
+	spare = 1 - config_active;
+	config_spare_erased = (CONFIG_Erase(spare) == 0);
+
+	config_generation = config_sectors[config_active][1];
+	CONFIG_Load(config_active);
+}
+
+/**
+ * @brief  Read a value from the RAM copy
+ * @param  key the key
+ * @param  value output: the value
+ * @retval 0 if the key was found
+ */
+int CONFIG_Read(uint16_t key, uint32_t *value) {
+	Config_EntryTypeDef *e = CONFIG_Find(key, 0);
+
+	if (!e)
+		return -1;
+	*value = e->value;
+	return 0;
+}
+
+/**
+ * @brief  Change a value. It is programmed later by CONFIG_Task().
+ * @param  key the key, not CONFIG_KEY_NONE
+ * @param  value the value
+ * @retval 0 on success, -1 if there are too many keys
+ */
+int CONFIG_Write(uint16_t key, uint32_t value) {
+	Config_EntryTypeDef *e;
+
+	if (key == CONFIG_KEY_NONE)
+		return -1;
+	e = CONFIG_Find(key, 1);
+	if (!e)
+		return -1;
+	if ((e->state != CONFIG_FREE) && (e->value == value))
+		return 0;
+	e->value = value;
+	e->state = CONFIG_PENDING;
+	return 0;
+}
+
+/**
+ * @brief  Number of values that are not yet safe in the flash
+ * @param  None
+ * @retval the number, 0 if all values are programmed
+ */
+int CONFIG_Pending(void) {
+	int i, n = config_transfer;
+
+	for (i = 0; i < CONFIG_MAX_KEYS; i++)
+		if (config_entries[i].state == CONFIG_PENDING)
+			n++;
+	return n;
+}
+
+/**
+ * @brief  Start to copy the values into the other sector
+ * @param  None
+ * @retval None
+ */
+static void CONFIG_StartTransfer(void) {
+	int spare = 1 - config_active;
+
+	// The other sector was already used since the reset
+	if (!config_spare_erased) {
+		config_full = 1;
+		return;
+	}
+	config_spare_erased = 0;
+
+	if ((CONFIG_Program(&config_sectors[spare][1], config_generation + 1) != 0)
+			|| (CONFIG_Program(&config_sectors[spare][0], CONFIG_RECEIVING) != 0)) {
+		config_full = 1;
+		return;
+	}
+	config_transfer = 1;
+	config_copy = 0;
+	config_copy_free = CONFIG_HEADER_WORDS;
+}
+
+/**
+ * @brief  Copy one value into the other sector, or finish the transfer
+ * @param  None
+ * @retval None
+ */
+static void CONFIG_TransferStep(void) {
+	int spare = 1 - config_active;
+	Config_EntryTypeDef *e;
+
+	while ((config_copy < CONFIG_MAX_KEYS)
+			&& (config_entries[config_copy].state == CONFIG_FREE))
+		config_copy++;
+
+	if (config_copy < CONFIG_MAX_KEYS) {
+		e = &config_entries[config_copy++];
+		if (CONFIG_ProgramRecord(spare, &config_copy_free, e->key, e->value) == 0)
+			e->state = CONFIG_STORED;
+		else
+			e->state = CONFIG_PENDING;
+		return;
+	}
+
+	// All values are copied, the other sector becomes active
+	config_transfer = 0;
+	if (CONFIG_Program(&config_sectors[spare][0], CONFIG_VALID) != 0) {
+		config_full = 1;
+		return;
+	}
+	config_active = spare;
+	config_free = config_copy_free;
+	config_generation++;
+	config_records = (config_free - CONFIG_HEADER_WORDS) / CONFIG_RECORD_WORDS;
+}
+
+/**
+ * @brief  Program one changed value or one step of a transfer.
+ * 		   Called by the main loop.
+ * @param  None
+ * @retval None
+ */
+void CONFIG_Task(void) {
+	Config_EntryTypeDef *e = NULL;
+	int i;
+
+	if ((config_active < 0) || config_full)
+		return;
+
+	if (config_transfer) {
+		CONFIG_TransferStep();
+		return;
+	}
+
+	for (i = 0; (i < CONFIG_MAX_KEYS) && !e; i++)
+		if (config_entries[i].state == CONFIG_PENDING)
+			e = &config_entries[i];
+	if (!e)
+		return;
+
+	if (config_free + CONFIG_RECORD_WORDS > config_sector_words) {
+		CONFIG_StartTransfer();
+		return;
+	}
+	if (CONFIG_ProgramRecord(config_active, &config_free, e->key, e->value) == 0)
+		e->state = CONFIG_STORED;
+	config_records = (config_free - CONFIG_HEADER_WORDS) / CONFIG_RECORD_WORDS;
+}
@@ -0,0 +1,89 @@
+/**
+ *  Project     Campos
+ *  @file		configflash.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Flash driver of the key value store
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The store uses the last 2 sectors of the flash (2 x 128k). They are
+ *  excluded from the program memory in STM32F407VG_FLASH.ld.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "config.h"
+#include "stm32f4xx_hal.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define CONFIG_FLASH_ERRORS	(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR \
+		| FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR)
+
+/* global variables ---------------------------------------------------------*/
+volatile uint32_t * const config_sectors[CONFIG_SECTORS] = {
+	(volatile uint32_t *) 0x080C0000,	// Sector 10
+	(volatile uint32_t *) 0x080E0000	// Sector 11
+};
+const uint32_t config_sector_words = 0x20000 / 4;
+
+/* local variables ----------------------------------------------------------*/
+static const uint32_t config_sector_numbers[CONFIG_SECTORS] = {
+	FLASH_SECTOR_10, FLASH_SECTOR_11
+};
+
+/**
+ * @brief  Erase a sector. The CPU waits until the flash can be read again.
+ * @param  sector 0 or 1
+ * @retval 0 on success
+ */
+int CONFIG_FlashErase(int sector) {
+	FLASH_EraseInitTypeDef erase;
+	uint32_t error = 0;
+	HAL_StatusTypeDef status;
+
+	erase.TypeErase = TYPEERASE_SECTORS;
+	erase.Sector = config_sector_numbers[sector];
+	erase.NbSectors = 1;
+	erase.VoltageRange = VOLTAGE_RANGE_3;
+
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(CONFIG_FLASH_ERRORS);
+	status = HAL_FLASHEx_Erase(&erase, &error);
+	HAL_FLASH_Lock();
+
+	// The data cache may still hold the old contents
+	__HAL_FLASH_DATA_CACHE_DISABLE();
+	__HAL_FLASH_DATA_CACHE_RESET();
+	__HAL_FLASH_DATA_CACHE_ENABLE();
+
+	return (status == HAL_OK) ? 0 : -1;
+}
+
+/**
+ * @brief  Program a 32 bit word. This takes about 16us.
+ * @param  address the address in one of the sectors
+ * @param  value the value
+ * @retval 0 on success
+ */
+int CONFIG_FlashProgram(volatile uint32_t *address, uint32_t value) {
+	HAL_StatusTypeDef status;
+
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(CONFIG_FLASH_ERRORS);
+	status = HAL_FLASH_Program(TYPEPROGRAM_WORD, (uint32_t) address, value);
+	HAL_FLASH_Lock();
+
+	return ((status == HAL_OK) && (*address == value)) ? 0 : -1;
+}
@@ -0,0 +1,150 @@
+/**
+ *  Project     Campos
+ *  @file		framestream.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Stream camera frames as binary packets on the debug port
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  A frame is copied and then sent in the background, a few lines per
+ *  packet. A packet is only written, if it fits completely into the
+ *  transmit buffer, so the main loop never waits for the UART.
+ *  Frames that arrive while a frame is sent are skipped.
+ *
+ *  The record mode sends every processed frame, also the tiles of the
+ *  total view. They are too big for a copy, so the capture is stopped
+ *  after each frame until it is sent. The tracking runs with a lower
+ *  frame rate, but a recording can be replayed frame by frame.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <string.h>
+#include "framestream.h"
+#include "camera.h"
+#include "irlink.h"
+#include "usartl1.h"
+
+/* local variables ----------------------------------------------------------*/
+FrameStream_ModeTypeDef framestream_mode = FRAMESTREAM_OFF;
+int framestream_busy = 0;		// A frame is being sent
+uint32_t framestream_pos = 0;	// Next pixel to send
+uint32_t framestream_pixel_count;	// Pixels of the frame
+const uint8_t *framestream_src;		// The pixels to send
+uint32_t framestream_sent = 0;
+uint32_t framestream_skipped = 0;
+Stream_FrameTypeDef framestream_frame;
+
+// Copy of the frame. The DCMI overwrites the pixels with the next frame.
+uint8_t framestream_pixels[FRAMESTREAM_W * FRAMESTREAM_H] __attribute__((section(".ccmram")));
+uint8_t framestream_packet[STREAM_MAX_PACKET];
+
+/**
+ * @brief  Start or stop the streaming
+ * @param  mode FRAMESTREAM_OFF, FRAMESTREAM_RAW or FRAMESTREAM_DELTA
+ * @retval None
+ */
+void FRAMESTREAM_SetMode(FrameStream_ModeTypeDef mode) {
+	if (mode >= FRAMESTREAM_MODES)
+		mode = FRAMESTREAM_OFF;
+	framestream_mode = mode;
+	framestream_busy = 0;
+	framestream_sent = 0;
+	framestream_skipped = 0;
+	BSP_CAMERA_SetHold(mode == FRAMESTREAM_RECORD);
+}
+
+/**
+ * @brief  Takes a copy of the new frame, if the last one was sent.
+ * 		   Must be called directly after a frame was received.
+ * @param  None
+ * @retval None
+ */
+void FRAMESTREAM_FrameCallback(void) {
+	Camera_SizeTypeDef size;
+
+	if (framestream_mode == FRAMESTREAM_OFF)
+		return;
+	size = BSP_CAMERA_GetSize();
+	if ((size != CAMERA_ZOOMED) && (framestream_mode != FRAMESTREAM_RECORD))
+		return;
+	if (framestream_busy) {
+		framestream_skipped++;
+		return;
+	}
+
+	framestream_frame.frame = irlink_frame_seq;
+	framestream_frame.size = size;
+	framestream_frame.exposure = camera_exposure;
+	framestream_frame.timestamp = irlink_frame_us;
+	if (size == CAMERA_ZOOMED) {
+		framestream_frame.tile = 0;
+		framestream_frame.width = FRAMESTREAM_W;
+		framestream_frame.height = FRAMESTREAM_H;
+		framestream_frame.x = offset_window_x;
+		framestream_frame.y = offset_window_y;
+	} else {
+		framestream_frame.tile = window_x + FRAMESTREAM_TILES_X * window_y;
+		framestream_frame.width = sizeof(pixels.total[0]);
+		framestream_frame.height = sizeof(pixels.total) / sizeof(pixels.total[0]);
+		framestream_frame.x = window_x * framestream_frame.width;
+		framestream_frame.y = window_y * framestream_frame.height;
+	}
+	framestream_pixel_count = framestream_frame.width * framestream_frame.height;
+
+	// The capture is stopped in the record mode, so the pixels stay valid
+	if (framestream_mode == FRAMESTREAM_RECORD) {
+		framestream_src = &pixels.firstByte;
+	} else {
+		memcpy(framestream_pixels, pixels.zoomed, sizeof(framestream_pixels));
+		framestream_src = framestream_pixels;
+	}
+	framestream_pos = 0;
+	framestream_busy = 1;
+}
+
+/**
+ * @brief  Cyclic task. Sends the next packets of the frame, as long as
+ * 		   they fit into the transmit buffer and no dump or response is sent.
+ * @param  None
+ * @retval None
+ */
+void FRAMESTREAM_Task(void) {
+	Stream_ChunkTypeDef chunk;
+	int len;
+
+	// The capture was stopped, but there is no frame to send
+	if (camera_held && !framestream_busy && !frame_flag)
+		BSP_CAMERA_Release();
+
+	while (framestream_busy && !USARTL2_TxPaused()
+			&& (USARTL1_TxFree() >= STREAM_MAX_PACKET)) {
+		chunk.frame = framestream_frame;
+		chunk.flags = (framestream_mode == FRAMESTREAM_RAW) ? 0 : STREAM_FLAG_DELTA;
+		chunk.offset = framestream_pos;
+		chunk.count = (framestream_pixel_count - framestream_pos > STREAM_CHUNK_PIXELS) ?
+				STREAM_CHUNK_PIXELS : framestream_pixel_count - framestream_pos;
+		len = STREAM_EncodeChunk(&chunk, &framestream_src[framestream_pos],
+				framestream_packet);
+		USARTL1_Write(framestream_packet, len);
+
+		framestream_pos += chunk.count;
+		if (framestream_pos >= framestream_pixel_count) {
+			framestream_busy = 0;
+			framestream_sent++;
+			BSP_CAMERA_Release();
+		}
+	}
+}
@@ -0,0 +1,120 @@
+/**
+ *  Project     Campos
+ *  @file		history.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Ring buffer with the last positions
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "history.h"
+#include "stm32f4xx_hal.h"
+#include "printf.h"
+
+/* local variables ----------------------------------------------------------*/
+// Ring buffer in CCM RAM. It is only accessed by the CPU.
+History_EntryTypeDef history[HISTORY_SIZE] __attribute__((section(".ccmram")));
+int history_wr_pointer = 0;	// Next entry to write
+int history_count = 0;		// Number of valid entries
+int history_dump_first;		// Oldest entry of the dump
+int history_dump_count;		// Entries of the dump
+
+/**
+ * @brief  Initialize the module
+ * @param  None
+ * @retval None
+ */
+void HISTORY_Init(void) {
+	history_wr_pointer = 0;
+	history_count = 0;
+}
+
+/**
+ * @brief  Add a new position. The oldest one is overwritten.
+ *
+ * @param  status The track_status
+ * @param  x The position_x
+ * @param  subx The position_subx
+ * @param  y The position_y
+ * @param  suby The position_suby
+ * @param  intensity The intensity
+ * @retval None
+ */
+void HISTORY_Add(Track_StatusTypeDef status, int x, int subx, int y, int suby,
+		int intensity) {
+	History_EntryTypeDef *e = &history[history_wr_pointer];
+
+	e->time = HAL_GetTick();
+	e->intensity = intensity;
+	e->x = x;
+	e->y = y;
+	e->subx = subx;
+	e->suby = suby;
+	e->status = status;
+
+	history_wr_pointer++;
+	history_wr_pointer &= HISTORY_MASK;
+	if (history_count < HISTORY_SIZE)
+		history_count++;
+}
+
+/**
+ * @brief  Number of valid positions in the ring buffer
+ * @param  None
+ * @retval Number of positions
+ */
+int HISTORY_Count(void) {
+	return history_count;
+}
+
+/**
+ * @brief  Get an older position
+ *
+ * @param  age 0 for the newest position, 1 for the one before ..
+ * @retval pointer to the entry or 0, if there is no such entry
+ */
+History_EntryTypeDef* HISTORY_Get(int age) {
+	if (age < 0 || age >= history_count)
+		return 0;
+	return &history[(history_wr_pointer - 1 - age) & HISTORY_MASK];
+}
+
+/**
+ * @brief  One line of the dump of all positions for the debug port, the
+ * 		   oldest one first. The positions of the first line are dumped,
+ * 		   new ones may overwrite the oldest entries that are already sent.
+ * @param  line number of the line, starting with 0
+ * @param  buf output: the text
+ * @param  size size of buf
+ * @retval Length of the line, 0 after the last line
+ */
+int HISTORY_DumpLine(int line, char *buf, int size) {
+	History_EntryTypeDef *e;
+
+	if (line == 0) {
+		history_dump_count = history_count;
+		history_dump_first = (history_wr_pointer - history_count) & HISTORY_MASK;
+		return my_snprintf(buf, size, "\r\nHistory %d\r\n", history_dump_count);
+	}
+	if (line > history_dump_count)
+		return 0;
+
+	e = &history[(history_dump_first + line - 1) & HISTORY_MASK];
+	return my_snprintf(buf, size, "%d;%d;%04d.%03d;%04d.%03d;%05d\r\n", e->time,
+			e->status, e->x, e->subx, e->y, e->suby, e->intensity);
+}
@@ -0,0 +1,163 @@
+/**
+ *  Project     Campos
+ *  @file		irfec.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Forward error correction of the IR link packets.
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "irfec.h"
+
+/* local variables ----------------------------------------------------------*/
+
+// Hamming(7,4) code words of all nibbles. Bit 6 is sent first and is
+// code word position 1: p1 p2 d3 p4 d2 d1 d0
+static const uint8_t irfec_code[16] = {
+	0x00, 0x69, 0x2A, 0x43, 0x4C, 0x25, 0x66, 0x0F,
+	0x70, 0x19, 0x5A, 0x33, 0x3C, 0x55, 0x16, 0x7F
+};
+
+/* Prototypes of local functions ---------------------------------------------*/
+static int IRFEC_Position(IrFec_ModeTypeDef mode, int codeword, int bit,
+		int codewords);
+
+/**
+ * @brief  Position of a code word bit in the coded bit stream
+ *
+ * @param  mode the FEC mode
+ * @param  codeword number of the code word
+ * @param  bit bit of the code word, 0 is sent first
+ * @param  codewords number of code words in the packet
+ * @retval bit position in the stream
+ */
+static int IRFEC_Position(IrFec_ModeTypeDef mode, int codeword, int bit,
+		int codewords) {
+	// With interleaving, a burst error hits each code word only once
+	if (mode == IRFEC_INTERLEAVED)
+		return bit * codewords + codeword;
+	return codeword * 7 + bit;
+}
+
+/**
+ * @brief  Encode the words of a packet
+ *
+ * @param  mode the FEC mode
+ * @param  data words of the packet
+ * @param  n number of words
+ * @param  coded buffer for the coded words
+ * @param  max_coded size of the buffer
+ * @retval number of coded words, or 0 if the buffer is too small
+ */
+int IRFEC_Encode(IrFec_ModeTypeDef mode, const uint16_t *data, int n,
+		uint16_t *coded, int max_coded) {
+	int i, bit, pos, codewords, words;
+	uint8_t code;
+
+	if (mode == IRFEC_NONE) {
+		if (n > max_coded)
+			return 0;
+		for (i = 0; i < n; i++)
+			coded[i] = data[i];
+		return n;
+	}
+
+	words = IRFEC_CODED_WORDS(n);
+	if (words > max_coded)
+		return 0;
+	for (i = 0; i < words; i++)
+		coded[i] = 0;
+
+	// 4 code words per data word, MSB nibble first
+	codewords = n * 4;
+	for (i = 0; i < codewords; i++) {
+		code = irfec_code[(data[i / 4] >> (12 - 4 * (i % 4))) & 0x0F];
+		for (bit = 0; bit < 7; bit++) {
+			if (code & (0x40 >> bit)) {
+				pos = IRFEC_Position(mode, i, bit, codewords);
+				coded[pos / 16] |= 0x8000 >> (pos % 16);
+			}
+		}
+	}
+
+	return words;
+}
+
+/**
+ * @brief  Decode the received words of a packet and correct single
+ * 		   bit errors per code word
+ *
+ * @param  mode the FEC mode
+ * @param  coded received words
+ * @param  n number of received words
+ * @param  data buffer for the packet words
+ * @param  max_data size of the buffer
+ * @param  corrected number of corrected bits. May be NULL
+ * @retval number of packet words
+ */
+int IRFEC_Decode(IrFec_ModeTypeDef mode, const uint16_t *coded, int n,
+		uint16_t *data, int max_data, int *corrected) {
+	int i, bit, pos, codewords, words;
+	int syndrome, fixes = 0;
+	uint8_t code;
+
+	if (mode == IRFEC_NONE) {
+		words = (n < max_data) ? n : max_data;
+		for (i = 0; i < words; i++)
+			data[i] = coded[i];
+		if (corrected != 0)
+			*corrected = 0;
+		return words;
+	}
+
+	// The padding is shorter than one data word
+	words = n * 16 / (4 * 7);
+	if (words > max_data)
+		words = max_data;
+	codewords = words * 4;
+
+	for (i = 0; i < words; i++)
+		data[i] = 0;
+
+	for (i = 0; i < codewords; i++) {
+		code = 0;
+		for (bit = 0; bit < 7; bit++) {
+			pos = IRFEC_Position(mode, i, bit, codewords);
+			if (coded[pos / 16] & (0x8000 >> (pos % 16)))
+				code |= 0x40 >> bit;
+		}
+
+		// The syndrome is the position 1..7 of the wrong bit
+		syndrome = 0;
+		for (bit = 0; bit < 7; bit++) {
+			if (code & (0x40 >> bit))
+				syndrome ^= bit + 1;
+		}
+		if (syndrome != 0) {
+			code ^= 0x40 >> (syndrome - 1);
+			fixes++;
+		}
+
+		// Data bits are at the positions 3, 5, 6 and 7
+		data[i / 4] |= (((code >> 1) & 0x08) | ((code >> 0) & 0x07)) << (12 - 4 * (i % 4));
+	}
+
+	if (corrected != 0)
+		*corrected = fixes;
+	return words;
+}
@@ -0,0 +1,68 @@
+/**
+ *  Project     Campos
+ *  @file		irline.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Line coding of the IR link: header, pause and Manchester code.
+ *  			It does not use the HAL, so the host tools compile it, too.
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "irline.h"
+
+/**
+ * @brief  Fill the symbol buffer with the rest of the header,
+ * 		   the pause and the Manchester coded data
+ *
+ * @param  symbols buffer for the symbols
+ * @param  data the 16 bit words to send
+ * @param  words number of words
+ * @param  header_symbols number of header symbols that are still to send
+ * @param  on value of a symbol with a burst. 0 is used for no burst
+ * @retval number of symbols in the buffer
+ */
+int IRLINE_BuildSymbols(uint16_t *symbols, const uint16_t *data, int words,
+		int header_symbols, uint16_t on) {
+	int n = 0;
+	int i, bit;
+
+	// Header is high ..
+	for (i = 0; i < header_symbols; i++)
+		symbols[n++] = on;
+
+	// .. and then a pause
+	for (i = 0; i < IRLINE_PAUSE_SYMBOLS; i++)
+		symbols[n++] = 0;
+
+	// Manchester code, MSB first
+	for (i = 0; i < words; i++) {
+		for (bit = 15; bit >= 0; bit--) {
+			if (data[i] & (1 << bit)) {
+				symbols[n++] = on;
+				symbols[n++] = 0;
+			} else {
+				symbols[n++] = 0;
+				symbols[n++] = on;
+			}
+		}
+	}
+
+	// finished
+	symbols[n++] = 0;
+	return n;
+}
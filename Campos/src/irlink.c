@@ -24,25 +24,47 @@
 /* Includes -----------------------------------------------------------------*/
 
 #include "irlink.h"
+#include "printf.h"
+#include "timebase.h"
+#include "latency.h"
 
 /* local variables ----------------------------------------------------------*/
-uint16_t irdata[4] = { 0, 0, 0, 0};
+uint16_t irdata[IRPACKET_MAX_WORDS];
+uint16_t irlink_coded[IRFEC_MAX_WORDS];
+IrPacket_TypeDef irlink_packet;
+IrFec_ModeTypeDef irlink_fec = IRFEC_NONE;
+int irlink_compact = 0;				// Send delta packets between key packets
+int irlink_latency = 0;				// Send the latency of the last packet
+IrPacket_DeltaTypeDef irlink_delta;	// Last sent packet
 
 TIM_HandleTypeDef htim3;
 TIM_OC_InitTypeDef sConfigTim3;
-CRC_HandleTypeDef   CrcHandle;
-uint32_t uwCRCValue = 0;
-
-int header_cnt;
-int header_sent;
-int header_endcnt;
-int send_data;
-int data_phase_cnt;
-int data_bit_cnt;
-int data_word_cnt;
+TIM_HandleTypeDef htim2;
+DMA_HandleTypeDef hdma_irlink;
+
+// Symbol buffer with one TIM3 compare value per symbol
+uint16_t irlink_symbols[IRLINK_MAX_SYMBOLS];
+int irlink_symbol_us = IRLINK_SYMBOL_US;
+int irlink_carrier_hz = IRLINK_CARRIER_HZ;
+uint16_t irlink_pulse;			// Compare value of timer 3 for a burst
+
+volatile Irlink_StateTypeDef irlink_state = IRLINK_IDLE;
+uint32_t header_us;				// Start of the header in us
+uint16_t irlink_frame_seq = 0;	// Incremented with each frame
+uint32_t irlink_frame_us;		// Time stamp of the last frame in us
+uint16_t header_seq;			// Sequence number of the frame of the header
+IrPacket_TypeDef irlink_tx_packet;	// Packet taken from the queue
+
+/* Prototypes of local functions ---------------------------------------------*/
+static void IRLINK_SendQueued(void);
+static void IRLINK_TransferComplete(DMA_HandleTypeDef *hdma);
 
 /**
- * @brief  Initialize the module and configure PWM PB5 as PWM output with 36kHz
+ * @brief  Initialize the module and configure PWM PB5 as PWM output with
+ * 		   the carrier frequency (38kHz)
+ * 		   Timer 2 is the symbol clock. With each update event the DMA
+ * 		   copies the next value of the symbol buffer into the compare
+ * 		   register of timer 3.
  * @param  None
  * @retval None
  */
@@ -50,12 +72,18 @@ void IRLINK_Init(void) {
 
 	// Timer configuration
 	htim3.Instance = TIM3;
-	//htim3.Init.Period = 1166 - 1; // = 36kHz = 42MHz / 1166
-	htim3.Init.Period = 1105 - 1; // = 38kHz = 42MHz / 1105
+	// 38kHz = 42MHz / 1105
+	htim3.Init.Period = IRLINK_CARRIER_CLOCK / irlink_carrier_hz - 1;
 	htim3.Init.Prescaler = 1;
 	htim3.Init.ClockDivision = 1;
 	htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
 	HAL_TIM_PWM_Init(&htim3);
+	irlink_pulse = (htim3.Init.Period + 1) / 2;
+
+	// Buffer the auto reload register, so a new carrier period is taken
+	// at the next update event. Otherwise the counter could already be
+	// above the new period and count up to 0xFFFF.
+	htim3.Instance->CR1 |= TIM_CR1_ARPE;
 
 	// Configure Timer 3 channel 2 as PWM output
 	sConfigTim3.OCMode = TIM_OCMODE_PWM1;
@@ -67,33 +95,106 @@ void IRLINK_Init(void) {
 	HAL_TIM_PWM_ConfigChannel(&htim3, &sConfigTim3, TIM_CHANNEL_2);
 	HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_2);
 
-	// Configure the CRC module
-	CrcHandle.Instance = CRC;
-	HAL_CRC_Init(&CrcHandle);
-
-	header_cnt = 0;
-	data_phase_cnt = 0;
-	data_bit_cnt = 0;
-	header_sent = 0;
-
-	// Set to 0 to stop the transmission
-	send_data = 0;
+	// Symbol clock: 84MHz / 84 = 1MHz counter clock
+	__TIM2_CLK_ENABLE();
+	htim2.Instance = TIM2;
+	htim2.Init.Period = irlink_symbol_us - 1;
+	htim2.Init.Prescaler = 84 - 1;
+	htim2.Init.ClockDivision = 0;
+	htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+	HAL_TIM_Base_Init(&htim2);
+
+	// DMA1 stream 1 channel 3 is triggered by the timer 2 update event
+	__DMA1_CLK_ENABLE();
+	hdma_irlink.Instance = DMA1_Stream1;
+	hdma_irlink.Init.Channel = DMA_CHANNEL_3;
+	hdma_irlink.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_irlink.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_irlink.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_irlink.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	hdma_irlink.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	hdma_irlink.Init.Mode = DMA_NORMAL;
+	hdma_irlink.Init.Priority = DMA_PRIORITY_MEDIUM;
+	hdma_irlink.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	hdma_irlink.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+	hdma_irlink.Init.MemBurst = DMA_MBURST_SINGLE;
+	hdma_irlink.Init.PeriphBurst = DMA_PBURST_SINGLE;
+	HAL_DMA_Init(&hdma_irlink);
+	hdma_irlink.XferCpltCallback = IRLINK_TransferComplete;
+
+	HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 6, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+
+	IRLINK_SetCompact(0);
+	IRQUEUE_Init(IRQUEUE_DROP_OLDEST);
+	irlink_state = IRLINK_IDLE;
 }
 
 /**
- * @brief  Outputs a 36kHz burst, or none
+ * @brief  Outputs a burst, or none
  * @param  value != 0 to output a burst
  * @retval None
  */
 void IRLINK_Output(int value) {
 	if (value != 0) {
-		__HAL_TIM_SetCompare(&htim3, TIM_CHANNEL_2, 1166 / 2);
+		__HAL_TIM_SetCompare(&htim3, TIM_CHANNEL_2, irlink_pulse);
 	} else {
 		__HAL_TIM_SetCompare(&htim3, TIM_CHANNEL_2, 0);
 	}
 
 }
 
+/**
+ * @brief  Set the duration of one symbol (half of a Manchester bit).
+ * 		   It is used from the next packet on.
+ * @param  us symbol period in us
+ * @retval None
+ */
+void IRLINK_SetSymbolPeriod(int us) {
+	if (us >= IRLINK_SYMBOL_MIN_US && us <= IRLINK_SYMBOL_MAX_US)
+		irlink_symbol_us = us;
+}
+
+/**
+ * @brief  Set the carrier frequency of the bursts. The period changes
+ * 		   with the next carrier period, the pulse width from the next
+ * 		   packet on.
+ * @param  hz carrier frequency in Hz
+ * @retval None
+ */
+void IRLINK_SetCarrier(int hz) {
+	uint32_t period;
+
+	if (hz < IRLINK_CARRIER_MIN_HZ || hz > IRLINK_CARRIER_MAX_HZ)
+		return;
+	irlink_carrier_hz = hz;
+	period = IRLINK_CARRIER_CLOCK / hz;
+	irlink_pulse = period / 2;
+	__HAL_TIM_SET_AUTORELOAD(&htim3, period - 1);
+}
+
+/**
+ * @brief  Select the forward error correction.
+ * 		   It is used from the next packet on.
+ * @param  mode the FEC mode
+ * @retval None
+ */
+void IRLINK_SetFec(IrFec_ModeTypeDef mode) {
+	if (mode < IRFEC_MODES)
+		irlink_fec = mode;
+}
+
+/**
+ * @brief  Switch between normal and compact packets.
+ * 		   The next compact packet is a key packet.
+ * @param  on 1 for compact packets
+ * @retval None
+ */
+void IRLINK_SetCompact(int on) {
+	IRPACKET_DeltaInit(&irlink_delta, IRPACKET_KEY_INTERVAL);
+	irlink_compact = on;
+}
+
 /**
  * @brief  Initializes the TIM PWM MSP.
  * @param  htim: TIM handle
@@ -119,79 +220,176 @@ void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim) {
 
 
 /**
- * @brief  Send the header
+ * @brief  Send the header. It's also the frame sync pulse.
+ * 		   The header is not sent, while the last packet is still sent.
+ * 		   The packets in the queue are from older frames. They are
+ * 		   removed, the header waits for the packet of this frame.
  * @param  None
  * @retval None
  */
 void IRLINK_StartHeader(void) {
+	// Count also the frames without a header, so the receiver sees the gap
+	irlink_frame_seq++;
+	irlink_frame_us = TIMEBASE_Us();
+
+	if (irlink_state == IRLINK_SENDING) {
+		irqueue_counters.skipped++;
+		return;
+	}
+
 	IRLINK_Output(1);
-	header_cnt = 5 + 1;
-	header_sent = 1;
+	header_us = irlink_frame_us;
+	header_seq = irlink_frame_seq;
+	irlink_state = IRLINK_HEADER;
+
+	// A packet that is several frames old is worth less than the
+	// sync pulse for the next one
+	IRQUEUE_Flush();
 }
 
+/**
+ * @brief  Start the transmission of the symbol buffer
+ *
+ * @param  n number of symbols in the buffer
+ * @retval None
+ */
+static void IRLINK_StartSymbols(int n) {
+
+	irlink_state = IRLINK_SENDING;
+
+	// The first symbol starts now, the DMA copies the next ones
+	// with each update event of the symbol clock
+	__HAL_TIM_DISABLE(&htim2);
+	__HAL_TIM_SET_AUTORELOAD(&htim2, irlink_symbol_us - 1);
+	__HAL_TIM_SET_COUNTER(&htim2, 0);
+	__HAL_TIM_SetCompare(&htim3, TIM_CHANNEL_2, irlink_symbols[0]);
+	HAL_DMA_Start_IT(&hdma_irlink, (uint32_t) &irlink_symbols[1],
+			(uint32_t) &TIM3->CCR2, n - 1);
+	__HAL_TIM_ENABLE_DMA(&htim2, TIM_DMA_UPDATE);
+	__HAL_TIM_ENABLE(&htim2);
+}
 
 /**
- * @brief  Send all the data in the 1ms task
+ * @brief  DMA transfer complete callback. The last symbol was written.
+ * @param  hdma DMA handle
+ * @retval None
+ */
+static void IRLINK_TransferComplete(DMA_HandleTypeDef *hdma) {
+	__HAL_TIM_DISABLE(&htim2);
+	__HAL_TIM_DISABLE_DMA(&htim2, TIM_DMA_UPDATE);
+	IRLINK_Output(0);
+	irqueue_counters.sent++;
+	irlink_state = IRLINK_IDLE;
+	LATENCY_Mark(irlink_tx_packet.seq, LATENCY_IR_END);
+}
+
+/**
+ * @brief  Handles the DMA interrupt request
+ * @param  None
+ * @retval None
+ */
+void IRLINK_DMA_IRQHandler(void) {
+	HAL_DMA_IRQHandler(&hdma_irlink);
+}
+
+
+/**
+ * @brief  Send the oldest packet of the queue after the header.
+ * 		   The caller must have set the state to IRLINK_SENDING.
+ *
  * @param  None
  * @retval None
  */
-void IRLINK_500usTask(void) {
-
-	// Header is n ms high and then one ms low.
-	if (header_cnt > 0) {
-		header_cnt--;
-		//IRLINK_Output(1);
-
-	} else if(send_data) {
-		if (header_endcnt > 0) {
-			// pause x ms
-			header_endcnt--;
-			IRLINK_Output(0);
+static void IRLINK_SendQueued(void) {
+	int header_symbols;
+	int words = 0;
+
+	if (IRQUEUE_Get(&irlink_tx_packet)) {
+		// The header is the sync pulse for the time stamp of this packet
+		if (irlink_tx_packet.seq == header_seq)
+			irlink_tx_packet.flags |= IRPACKET_FLAG_SYNC;
+		else
+			irlink_tx_packet.flags &= ~IRPACKET_FLAG_SYNC;
+
+		// The latency of the last packet is known, when the next one starts
+		if (irlink_latency) {
+			irlink_tx_packet.flags |= IRPACKET_FLAG_LATENCY;
+			irlink_tx_packet.latency = (latency_last_us / IRPACKET_LATENCY_US > 0xFFFF) ?
+					0xFFFF : latency_last_us / IRPACKET_LATENCY_US;
 		} else {
-			// Send now the data
-			if (data_word_cnt < 4) {
-
-				// Manchester code
-				if (data_phase_cnt == 0) {
-					if (irdata[data_word_cnt] & 0x8000) {
-						IRLINK_Output(1);
-					} else {
-						IRLINK_Output(0);
-					}
-				} else {
-					if (irdata[data_word_cnt] & 0x8000) {
-						IRLINK_Output(0);
-					} else {
-						IRLINK_Output(1);
-					}
-				}
-
-				// Next phase
-				data_phase_cnt++;
-				if (data_phase_cnt >= 2 ) {
-
-					// Next bit
-					irdata[data_word_cnt] <<= 1;
-					data_phase_cnt = 0;
-					data_bit_cnt ++;
-					if (data_bit_cnt >= 16 ) {
-
-						// Next word (16bit)
-						data_bit_cnt = 0;
-						data_word_cnt ++;
-					}
-				}
-			} else {
-				// finished
-				IRLINK_Output(0);
-				send_data = 0;
-				header_sent = 0;
-			}
+			irlink_tx_packet.flags &= ~IRPACKET_FLAG_LATENCY;
+			irlink_tx_packet.latency = 0;
 		}
+
+		if (irlink_compact)
+			words = IRPACKET_EncodeCompact(&irlink_delta, &irlink_tx_packet,
+					irdata, IRPACKET_MAX_WORDS);
+		else
+			words = IRPACKET_Encode(&irlink_tx_packet, irdata,
+					IRPACKET_MAX_WORDS);
 	}
+
+	// Nothing to send, switch the header off
+	if (words == 0) {
+		IRLINK_Output(0);
+		irlink_state = IRLINK_IDLE;
+		return;
+	}
+
+	words = IRFEC_Encode(irlink_fec, irdata, words, irlink_coded,
+			IRFEC_MAX_WORDS);
+
+	// The header is at least IRLINE_HEADER_SYMBOLS long
+	header_symbols = IRLINE_HEADER_SYMBOLS
+			- (int)(TIMEBASE_Us() - header_us) / irlink_symbol_us;
+	if (header_symbols < 0)
+		header_symbols = 0;
+
+	LATENCY_Mark(irlink_tx_packet.seq, LATENCY_IR_START);
+	IRLINK_StartSymbols(IRLINE_BuildSymbols(irlink_symbols, irlink_coded, words,
+			header_symbols, irlink_pulse));
 }
 
+/**
+ * @brief  Queue a packet of the current frame. It is sent after the
+ * 		   header of this frame. If the IR link is still busy, it is
+ * 		   removed by the next header and the packet of that frame is sent.
+ * 		   Sequence number and time stamp are set by the IR link.
+ *
+ * @param  packet the packet with the targets to send
+ * @retval None
+ */
+void IRLINK_SendPacket(IrPacket_TypeDef *packet) {
+	int start = 0;
+
+	packet->seq = irlink_frame_seq;
+	packet->timestamp = irlink_frame_us;
+
+	// Take over the header, so the frame interrupt does not send, too.
+	// A header between both would remove the packet.
+	__disable_irq();
+	IRQUEUE_Put(packet);
+	if (irlink_state == IRLINK_HEADER) {
+		irlink_state = IRLINK_SENDING;
+		start = 1;
+	}
+	__enable_irq();
+
+	if (start)
+		IRLINK_SendQueued();
+}
 
+/**
+ * @brief  Print the counters of the transmit queue
+ * @param  None
+ * @retval None
+ */
+void IRLINK_PrintCounters(void) {
+	my_printf("IR queue: %d queued %d sent %d dropped %d overwritten %d skipped %d stale %d",
+			IRQUEUE_Count(), irqueue_counters.queued, irqueue_counters.sent,
+			irqueue_counters.dropped, irqueue_counters.overwritten,
+			irqueue_counters.skipped, irqueue_counters.stale);
+}
 
 /**
  * @brief  The data to send. All data is copied to a memory structure
@@ -207,51 +405,10 @@ void IRLINK_500usTask(void) {
 void IRLINK_Send(Track_StatusTypeDef track_status, int position_x,
 		int position_subx, int position_y, int position_suby, int intensity) {
 
-	// If header was not sent, do not send data
-	if (!header_sent)
-		return;
-
-	irdata[0] = position_x*10 + position_subx / 100;
-	irdata[1] = position_y*10 + position_suby / 100;
-	irdata[2] = (intensity/256)*256 + (int)track_status;
-	irdata[3] = 0;
-
-	// Calculate the CRC
-	uwCRCValue = HAL_CRC_Calculate(&CrcHandle, (uint32_t *)irdata, 4 / 2);
-	irdata[3] = (uint16_t)uwCRCValue;
-
-	data_phase_cnt = 0;
-	data_bit_cnt = 0;
-	data_word_cnt = 0;
-	header_endcnt = 3;
-	send_data = 1;
-}
+	irlink_packet.flags = 0;
+	irlink_packet.targets = 1;
+	IRPACKET_SetTarget(&irlink_packet.target[0], track_status,
+			position_x, position_subx, position_y, position_suby, intensity);
 
-/**
-  * @brief CRC MSP Initialization
-  *        This function configures the hardware resources used in this example:
-  *           - Peripheral's clock enable
-  * @param hcrc: CRC handle pointer
-  * @retval None
-  */
-void HAL_CRC_MspInit(CRC_HandleTypeDef *hcrc)
-{
-   /* CRC Peripheral clock enable */
-  __CRC_CLK_ENABLE();
-}
-
-/**
-  * @brief CRC MSP De-Initialization
-  *        This function freeze the hardware resources used in this example:
-  *          - Disable the Peripheral's clock
-  * @param hcrc: CRC handle pointer
-  * @retval None
-  */
-void HAL_CRC_MspDeInit(CRC_HandleTypeDef *hcrc)
-{
-  /* Enable CRC reset state */
-  __CRC_FORCE_RESET();
-
-  /* Release CRC from reset state */
-  __CRC_RELEASE_RESET();
+	IRLINK_SendPacket(&irlink_packet);
 }
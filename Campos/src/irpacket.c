@@ -0,0 +1,477 @@
+/**
+ *  Project     Campos
+ *  @file		irpacket.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Builder and parser of the IR link packets.
+ *  			It does not use the HAL, so the host tools compile it, too.
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "irpacket.h"
+#include "crc.h"
+
+/* Defines ------------------------------------------------------------------*/
+
+// Variable length numbers: 3 data bits and a continue bit per group
+#define IRPACKET_GROUP_BITS		3
+
+/* Type defs ----------------------------------------------------------------*/
+typedef struct {
+	uint16_t *words;	// the packet words
+	int pos;			// bit position
+	int max_bits;		// size of the buffer in bits
+} IrPacket_BitsTypeDef;
+
+/* Prototypes of local functions ---------------------------------------------*/
+static void IRPACKET_PutBits(IrPacket_BitsTypeDef *bits, uint32_t value, int n);
+static uint32_t IRPACKET_GetBits(IrPacket_BitsTypeDef *bits, int n);
+static void IRPACKET_PutNumber(IrPacket_BitsTypeDef *bits, int value);
+static int IRPACKET_GetNumber(IrPacket_BitsTypeDef *bits);
+static int IRPACKET_EncodeDelta(const IrPacket_TypeDef *ref,
+		const IrPacket_TypeDef *packet, uint16_t *words, int max_words);
+static int IRPACKET_RefLatency(const IrPacket_TypeDef *ref);
+
+/**
+ * @brief  Convert a position with sub pixels to fixed point
+ *
+ * @param  pixel position in sensor pixels
+ * @param  sub sub pixel position from 0..999
+ * @retval position in fixed point 12.4
+ */
+uint16_t IRPACKET_ToFixed(int pixel, int sub) {
+	return (uint16_t)((pixel << IRPACKET_FRACTION_BITS)
+			+ ((sub << IRPACKET_FRACTION_BITS) + 500) / 1000);
+}
+
+/**
+ * @brief  Convert a fixed point position to 1/1000 pixels
+ *
+ * @param  fixed position in fixed point 12.4
+ * @retval position in 1/1000 pixels
+ */
+int IRPACKET_FixedToMilli(uint16_t fixed) {
+	return ((int)fixed * 1000) >> IRPACKET_FRACTION_BITS;
+}
+
+/**
+ * @brief  Fill a target with a tracked position
+ *
+ * @param  target the target to fill
+ * @param  status The track_status
+ * @param  x The position_x
+ * @param  subx The position_subx
+ * @param  y The position_y
+ * @param  suby The position_suby
+ * @param  intensity The intensity
+ * @retval None
+ */
+void IRPACKET_SetTarget(IrPacket_TargetTypeDef *target, int status,
+		int x, int subx, int y, int suby, int intensity) {
+	target->x = IRPACKET_ToFixed(x, subx);
+	target->y = IRPACKET_ToFixed(y, suby);
+	target->status = (uint8_t)status;
+
+	// Limit the intensity to 12 bit
+	intensity >>= IRPACKET_INTENSITY_SHIFT;
+	if (intensity > IRPACKET_INTENSITY_MAX)
+		intensity = IRPACKET_INTENSITY_MAX;
+	if (intensity < 0)
+		intensity = 0;
+	target->intensity = (uint16_t)intensity;
+}
+
+/**
+ * @brief  Build the words of a packet
+ *
+ * @param  packet the packet to encode
+ * @param  words buffer for the words
+ * @param  max_words size of the buffer
+ * @retval number of words, or 0 if the buffer is too small
+ */
+int IRPACKET_Encode(const IrPacket_TypeDef *packet, uint16_t *words, int max_words) {
+	int n, i;
+	int length, latency_words;
+
+	latency_words = (packet->flags & IRPACKET_FLAG_LATENCY) ? IRPACKET_LATENCY_WORDS : 0;
+	length = IRPACKET_HEADER_WORDS + latency_words
+			+ packet->targets * IRPACKET_TARGET_WORDS + IRPACKET_CRC_WORDS;
+	if (packet->targets > IRPACKET_MAX_TARGETS || length > max_words)
+		return 0;
+
+	words[0] = (IRPACKET_VERSION << 12) | ((packet->flags & 0x0F) << 8)
+			| (packet->seq & 0xFF);
+	words[1] = packet->timestamp >> 16;
+	words[2] = packet->timestamp & 0xFFFF;
+	n = IRPACKET_HEADER_WORDS;
+	if (latency_words)
+		words[n++] = packet->latency;
+
+	for (i = 0; i < packet->targets; i++) {
+		words[n++] = packet->target[i].x;
+		words[n++] = packet->target[i].y;
+		words[n++] = ((packet->target[i].status & 0x0F) << 12)
+				| (packet->target[i].intensity & IRPACKET_INTENSITY_MAX);
+	}
+
+	words[n] = IRPACKET_Crc16(words, n);
+	n++;
+
+	return n;
+}
+
+/**
+ * @brief  Parse the words of a received packet. Only the low byte of
+ * 		   the sequence number is sent.
+ *
+ * @param  packet the decoded packet
+ * @param  words received words
+ * @param  n number of received words
+ * @retval IRPACKET_OK or an error code
+ */
+IrPacket_ResultTypeDef IRPACKET_Decode(IrPacket_TypeDef *packet,
+		const uint16_t *words, int n) {
+	int i, w, latency_words;
+
+	if (n < IRPACKET_HEADER_WORDS + IRPACKET_CRC_WORDS)
+		return IRPACKET_ERR_SHORT;
+
+	packet->version = words[0] >> 12;
+	if (packet->version != IRPACKET_VERSION)
+		return IRPACKET_ERR_VERSION;
+
+	// Delta packets need the compact decoder
+	if ((words[0] >> 8) & IRPACKET_FLAG_DELTA)
+		return IRPACKET_ERR_REFERENCE;
+
+	latency_words = ((words[0] >> 8) & IRPACKET_FLAG_LATENCY) ? IRPACKET_LATENCY_WORDS : 0;
+	if (n < IRPACKET_HEADER_WORDS + latency_words + IRPACKET_CRC_WORDS)
+		return IRPACKET_ERR_LENGTH;
+	if ((n - IRPACKET_HEADER_WORDS - latency_words - IRPACKET_CRC_WORDS)
+			% IRPACKET_TARGET_WORDS != 0)
+		return IRPACKET_ERR_LENGTH;
+
+	if (IRPACKET_Crc16(words, n - 1) != words[n - 1])
+		return IRPACKET_ERR_CRC;
+
+	packet->flags = (words[0] >> 8) & 0x0F;
+	packet->seq = words[0] & 0xFF;
+	packet->timestamp = ((uint32_t)words[1] << 16) | words[2];
+	packet->latency = latency_words ? words[IRPACKET_HEADER_WORDS] : 0;
+	packet->targets = (n - IRPACKET_HEADER_WORDS - latency_words
+			- IRPACKET_CRC_WORDS) / IRPACKET_TARGET_WORDS;
+	if (packet->targets > IRPACKET_MAX_TARGETS)
+		return IRPACKET_ERR_LENGTH;
+
+	w = IRPACKET_HEADER_WORDS + latency_words;
+	for (i = 0; i < packet->targets; i++) {
+		packet->target[i].x = words[w++];
+		packet->target[i].y = words[w++];
+		packet->target[i].status = words[w] >> 12;
+		packet->target[i].intensity = words[w++] & IRPACKET_INTENSITY_MAX;
+	}
+
+	return IRPACKET_OK;
+}
+
+/**
+ * @brief  Write bits into the bit stream, MSB first.
+ * 		   Bits beyond the end of the buffer are counted, but not written.
+ *
+ * @param  bits the bit stream
+ * @param  value the bits to write
+ * @param  n number of bits
+ * @retval None
+ */
+static void IRPACKET_PutBits(IrPacket_BitsTypeDef *bits, uint32_t value, int n) {
+	while (n-- > 0) {
+		if (bits->pos < bits->max_bits) {
+			if (value & (1UL << n))
+				bits->words[bits->pos / 16] |= 0x8000 >> (bits->pos % 16);
+			else
+				bits->words[bits->pos / 16] &= ~(0x8000 >> (bits->pos % 16));
+		}
+		bits->pos++;
+	}
+}
+
+/**
+ * @brief  Read bits from the bit stream, MSB first.
+ * 		   Bits beyond the end of the buffer are read as 0.
+ *
+ * @param  bits the bit stream
+ * @param  n number of bits
+ * @retval the bits
+ */
+static uint32_t IRPACKET_GetBits(IrPacket_BitsTypeDef *bits, int n) {
+	uint32_t value = 0;
+
+	while (n-- > 0) {
+		value <<= 1;
+		if (bits->pos < bits->max_bits
+				&& (bits->words[bits->pos / 16] & (0x8000 >> (bits->pos % 16))))
+			value |= 1;
+		bits->pos++;
+	}
+	return value;
+}
+
+/**
+ * @brief  Write a signed number with variable length.
+ * 		   The sign is moved to bit 0 (zigzag), so small differences
+ * 		   need only few groups.
+ *
+ * @param  bits the bit stream
+ * @param  value the number
+ * @retval None
+ */
+static void IRPACKET_PutNumber(IrPacket_BitsTypeDef *bits, int value) {
+	uint32_t u = (value < 0) ? (((uint32_t)(-value) << 1) - 1) : ((uint32_t)value << 1);
+	uint32_t group;
+
+	do {
+		group = u & ((1 << IRPACKET_GROUP_BITS) - 1);
+		u >>= IRPACKET_GROUP_BITS;
+		IRPACKET_PutBits(bits, (u != 0) ? 1 : 0, 1);
+		IRPACKET_PutBits(bits, group, IRPACKET_GROUP_BITS);
+	} while (u != 0);
+}
+
+/**
+ * @brief  Read a signed number with variable length
+ *
+ * @param  bits the bit stream
+ * @retval the number
+ */
+static int IRPACKET_GetNumber(IrPacket_BitsTypeDef *bits) {
+	uint32_t u = 0;
+	int shift = 0;
+	int more;
+
+	do {
+		more = IRPACKET_GetBits(bits, 1);
+		if (shift < 30)
+			u |= IRPACKET_GetBits(bits, IRPACKET_GROUP_BITS) << shift;
+		else
+			IRPACKET_GetBits(bits, IRPACKET_GROUP_BITS);
+		shift += IRPACKET_GROUP_BITS;
+	} while (more && bits->pos < bits->max_bits);
+
+	return (u & 1) ? -(int)((u + 1) >> 1) : (int)(u >> 1);
+}
+
+/**
+ * @brief  Initialize the state of a compact packet encoder or decoder
+ *
+ * @param  delta the state
+ * @param  key_interval maximum number of packets between key packets
+ * @retval None
+ */
+void IRPACKET_DeltaInit(IrPacket_DeltaTypeDef *delta, int key_interval) {
+	delta->key_interval = key_interval;
+	delta->valid = 0;
+	delta->since_key = 0;
+}
+
+/**
+ * @brief  Latency of a reference packet. The difference is coded to 0,
+ * 		   if the reference packet has no latency.
+ *
+ * @param  ref the reference packet
+ * @retval latency in IRPACKET_LATENCY_US
+ */
+static int IRPACKET_RefLatency(const IrPacket_TypeDef *ref) {
+	return (ref->flags & IRPACKET_FLAG_LATENCY) ? ref->latency : 0;
+}
+
+/**
+ * @brief  Build the words of a delta packet
+ *
+ * @param  ref the key packet
+ * @param  packet the packet to encode
+ * @param  words buffer for the words
+ * @param  max_words size of the buffer
+ * @retval number of words, or 0 if the buffer is too small
+ */
+static int IRPACKET_EncodeDelta(const IrPacket_TypeDef *ref,
+		const IrPacket_TypeDef *packet, uint16_t *words, int max_words) {
+	IrPacket_BitsTypeDef bits;
+	const IrPacket_TargetTypeDef *t, *r;
+	int i, n, distance;
+
+	if (max_words < 2)
+		return 0;
+	words[0] = (IRPACKET_VERSION << 12)
+			| (((packet->flags | IRPACKET_FLAG_DELTA) & 0x0F) << 8)
+			| (packet->seq & 0xFF);
+
+	bits.words = &words[1];
+	bits.pos = 0;
+	bits.max_bits = (max_words - 2) * 16;
+	distance = (uint16_t)(packet->seq - ref->seq);
+	IRPACKET_PutNumber(&bits, distance);
+	IRPACKET_PutNumber(&bits, (int32_t)(packet->timestamp - ref->timestamp
+			- distance * IRPACKET_FRAME_US));
+	IRPACKET_PutNumber(&bits, packet->targets);
+	for (i = 0; i < packet->targets; i++) {
+		t = &packet->target[i];
+		r = &ref->target[i];
+		IRPACKET_PutBits(&bits, t->status, 4);
+		IRPACKET_PutNumber(&bits, (int)t->x - (int)r->x);
+		IRPACKET_PutNumber(&bits, (int)t->y - (int)r->y);
+		IRPACKET_PutNumber(&bits, (int)t->intensity - (int)r->intensity);
+	}
+	if (packet->flags & IRPACKET_FLAG_LATENCY)
+		IRPACKET_PutNumber(&bits, (int)packet->latency - IRPACKET_RefLatency(ref));
+
+	// Fill up the last word with 0
+	IRPACKET_PutBits(&bits, 0, (16 - bits.pos % 16) % 16);
+	if (bits.pos > bits.max_bits)
+		return 0;
+
+	n = 1 + bits.pos / 16;
+	words[n] = IRPACKET_Crc16(words, n);
+	return n + 1;
+}
+
+/**
+ * @brief  Build the words of a compact packet. A key packet is sent
+ * 		   after key_interval packets, or if the differences can not
+ * 		   be coded. The delta packets refer to the last key packet.
+ *
+ * @param  delta state of the encoder with the last key packet
+ * @param  packet the packet to encode
+ * @param  words buffer for the words
+ * @param  max_words size of the buffer
+ * @retval number of words, or 0 if the buffer is too small
+ */
+int IRPACKET_EncodeCompact(IrPacket_DeltaTypeDef *delta,
+		const IrPacket_TypeDef *packet, uint16_t *words, int max_words) {
+	uint16_t distance;
+	int n = 0;
+
+	distance = packet->seq - delta->ref.seq;
+
+	if (delta->valid && delta->since_key + 1 < delta->key_interval
+			&& distance != 0 && distance <= IRPACKET_MAX_REF
+			&& packet->targets == delta->ref.targets) {
+		n = IRPACKET_EncodeDelta(&delta->ref, packet, words, max_words);
+	}
+
+	if (n > 0) {
+		delta->since_key++;
+		return n;
+	}
+
+	n = IRPACKET_Encode(packet, words, max_words);
+	if (n > 0) {
+		delta->since_key = 0;
+		delta->ref = *packet;
+		delta->valid = 1;
+	}
+	return n;
+}
+
+/**
+ * @brief  Parse a received compact packet. Delta packets are only
+ * 		   accepted, if their key packet was received. Otherwise
+ * 		   the decoder waits for the next key packet.
+ *
+ * @param  delta state of the decoder with the last received key packet
+ * @param  packet the decoded packet
+ * @param  words received words
+ * @param  n number of received words
+ * @retval IRPACKET_OK or an error code
+ */
+IrPacket_ResultTypeDef IRPACKET_DecodeCompact(IrPacket_DeltaTypeDef *delta,
+		IrPacket_TypeDef *packet, const uint16_t *words, int n) {
+	IrPacket_BitsTypeDef bits;
+	IrPacket_TargetTypeDef *t;
+	IrPacket_ResultTypeDef result;
+	int i, distance;
+
+	if (n < 2)
+		return IRPACKET_ERR_SHORT;
+	if ((words[0] >> 12) != IRPACKET_VERSION)
+		return IRPACKET_ERR_VERSION;
+
+	// Key packet. The high byte of the sequence number is taken from the
+	// last key packet.
+	if (!((words[0] >> 8) & IRPACKET_FLAG_DELTA)) {
+		result = IRPACKET_Decode(packet, words, n);
+		if (result == IRPACKET_OK) {
+			if (delta->valid)
+				packet->seq = delta->ref.seq
+						+ (uint8_t)(packet->seq - delta->ref.seq);
+			delta->ref = *packet;
+			delta->valid = 1;
+		}
+		return result;
+	}
+
+	// Delta packet. The length is given by the number of received words
+	if (IRPACKET_Crc16(words, n - 1) != words[n - 1])
+		return IRPACKET_ERR_CRC;
+
+	bits.words = (uint16_t *)&words[1];
+	bits.pos = 0;
+	bits.max_bits = (n - 2) * 16;
+	distance = IRPACKET_GetNumber(&bits);
+
+	// The reference must be the last received key packet
+	if (!delta->valid || distance <= 0 || distance > IRPACKET_MAX_REF
+			|| (uint8_t)(delta->ref.seq + distance) != (words[0] & 0xFF))
+		return IRPACKET_ERR_REFERENCE;
+
+	*packet = delta->ref;
+	packet->version = IRPACKET_VERSION;
+	packet->flags = (words[0] >> 8) & 0x0F;
+	packet->seq = delta->ref.seq + distance;
+	packet->timestamp = delta->ref.timestamp + distance * IRPACKET_FRAME_US
+			+ IRPACKET_GetNumber(&bits);
+	packet->targets = IRPACKET_GetNumber(&bits);
+	if (packet->targets != delta->ref.targets || bits.pos > bits.max_bits)
+		return IRPACKET_ERR_LENGTH;
+
+	for (i = 0; i < packet->targets; i++) {
+		t = &packet->target[i];
+		t->status = IRPACKET_GetBits(&bits, 4);
+		t->x += IRPACKET_GetNumber(&bits);
+		t->y += IRPACKET_GetNumber(&bits);
+		t->intensity += IRPACKET_GetNumber(&bits);
+	}
+	if (packet->flags & IRPACKET_FLAG_LATENCY)
+		packet->latency = IRPACKET_RefLatency(&delta->ref) + IRPACKET_GetNumber(&bits);
+	else
+		packet->latency = 0;
+	if (bits.pos > bits.max_bits)
+		return IRPACKET_ERR_LENGTH;
+	return IRPACKET_OK;
+}
+
+/**
+ * @brief  CRC-16 (CCITT, 0x1021, start value 0xFFFF) over 16 bit words,
+ * 		   MSB first
+ *
+ * @param  words data
+ * @param  n number of words
+ * @retval CRC
+ */
+uint16_t IRPACKET_Crc16(const uint16_t *words, int n) {
+	return CRC_Crc16(CRC16_INIT, words, n);
+}
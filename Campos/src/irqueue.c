@@ -0,0 +1,133 @@
+/**
+ *  Project     Campos
+ *  @file		irqueue.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Lock-free queue between the main loop and the IR transmitter.
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "irqueue.h"
+
+// The main loop is the only writer. Packets are read by the IR link,
+// either in the frame interrupt or in the main loop. The reader is never
+// interrupted by the writer, but the writer may be interrupted by the
+// reader. So the read index is only changed with compare and swap.
+
+/* local variables ----------------------------------------------------------*/
+IrPacket_TypeDef irqueue[IRQUEUE_SIZE];
+volatile uint32_t irqueue_wr = 0;	// Next packet to write
+volatile uint32_t irqueue_rd = 0;	// Next packet to read
+IrQueue_PolicyTypeDef irqueue_policy = IRQUEUE_DROP_OLDEST;
+IrQueue_CountersTypeDef irqueue_counters;
+
+/**
+ * @brief  Initialize the queue and clear the counters
+ * @param  policy what to do, if the queue is full
+ * @retval None
+ */
+void IRQUEUE_Init(IrQueue_PolicyTypeDef policy) {
+	irqueue_wr = 0;
+	irqueue_rd = 0;
+	irqueue_policy = policy;
+	irqueue_counters.queued = 0;
+	irqueue_counters.sent = 0;
+	irqueue_counters.dropped = 0;
+	irqueue_counters.overwritten = 0;
+	irqueue_counters.skipped = 0;
+	irqueue_counters.stale = 0;
+}
+
+/**
+ * @brief  Select what to do, if the queue is full
+ * @param  policy IRQUEUE_DROP_NEWEST or IRQUEUE_DROP_OLDEST
+ * @retval None
+ */
+void IRQUEUE_SetPolicy(IrQueue_PolicyTypeDef policy) {
+	irqueue_policy = policy;
+}
+
+/**
+ * @brief  Put a packet into the queue. Must only be called by the writer.
+ * @param  packet the packet
+ * @retval 1 if the packet was queued
+ */
+int IRQUEUE_Put(const IrPacket_TypeDef *packet) {
+	uint32_t rd = irqueue_rd;
+
+	if (irqueue_wr - rd >= IRQUEUE_SIZE) {
+		if (irqueue_policy == IRQUEUE_DROP_NEWEST) {
+			irqueue_counters.dropped++;
+			return 0;
+		}
+
+		// Remove the oldest packet, if the reader did not take it meanwhile
+		if (__sync_bool_compare_and_swap(&irqueue_rd, rd, rd + 1))
+			irqueue_counters.overwritten++;
+	}
+
+	irqueue[irqueue_wr & IRQUEUE_MASK] = *packet;
+	__sync_synchronize();
+	irqueue_wr++;
+	irqueue_counters.queued++;
+	return 1;
+}
+
+/**
+ * @brief  Get the oldest packet from the queue
+ * @param  packet buffer for the packet
+ * @retval 1 if there was a packet
+ */
+int IRQUEUE_Get(IrPacket_TypeDef *packet) {
+	uint32_t rd;
+
+	do {
+		rd = irqueue_rd;
+		if (rd == irqueue_wr)
+			return 0;
+		*packet = irqueue[rd & IRQUEUE_MASK];
+	} while (!__sync_bool_compare_and_swap(&irqueue_rd, rd, rd + 1));
+
+	return 1;
+}
+
+/**
+ * @brief  Number of packets in the queue
+ * @param  None
+ * @retval number of packets
+ */
+int IRQUEUE_Count(void) {
+	return (int)(irqueue_wr - irqueue_rd);
+}
+
+/**
+ * @brief  Remove all packets from the queue. They are counted as stale.
+ * @param  None
+ * @retval number of removed packets
+ */
+int IRQUEUE_Flush(void) {
+	uint32_t rd, wr;
+
+	do {
+		rd = irqueue_rd;
+		wr = irqueue_wr;
+	} while (!__sync_bool_compare_and_swap(&irqueue_rd, rd, wr));
+
+	irqueue_counters.stale += wr - rd;
+	return (int)(wr - rd);
+}
@@ -0,0 +1,204 @@
+/**
+ *  Project     Campos
+ *  @file		latency.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Latency from the camera frame to the IR packet
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Each frame gets a time stamp at the VSYNC, when it is captured, when
+ *  the tracking starts and ends, and when its IR packet starts and ends.
+ *  The time stamps are kept by the frame sequence number. When the IR
+ *  packet is sent completely, the latency from the VSYNC is added to a
+ *  histogram, and the time between the points to the stage statistics.
+ *  The debug console prints them with 'L' and clears them with 'Y'.
+ *  The latency of the last packet can also be sent in the next IR packet,
+ *  see the parameter ir_latency.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "latency.h"
+#include "timebase.h"
+#include "printf.h"
+
+/* global variables ---------------------------------------------------------*/
+uint32_t latency_last_us = 0;	// Latency of the last sent IR packet
+uint32_t latency_count = 0;		// Frames in the histogram
+
+/* local variables ----------------------------------------------------------*/
+volatile uint32_t latency_vsync_us;		// Last VSYNC
+volatile uint32_t latency_vsync_prev_us;	// The VSYNC before
+volatile int latency_vsyncs = 0;		// Number of VSYNCs, up to 2
+Latency_FrameTypeDef latency_frames[LATENCY_FRAMES];
+
+uint32_t latency_min = 0xFFFFFFFF;
+uint32_t latency_max = 0;
+uint64_t latency_sum;
+uint32_t latency_histogram[LATENCY_BUCKETS];
+Latency_StageTypeDef latency_stages[LATENCY_POINTS - 1];
+
+static const char * const latency_stage_names[LATENCY_POINTS - 1] = {
+	"capture", "wait", "track", "IR wait", "IR send"
+};
+
+/**
+ * @brief  Clear the statistics
+ * @param  None
+ * @retval None
+ */
+void LATENCY_Reset(void) {
+	int i;
+
+	__disable_irq();
+	latency_count = 0;
+	latency_min = 0xFFFFFFFF;
+	latency_max = 0;
+	latency_sum = 0;
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		latency_histogram[i] = 0;
+	for (i = 0; i < LATENCY_POINTS - 1; i++) {
+		latency_stages[i].count = 0;
+		latency_stages[i].max = 0;
+		latency_stages[i].sum = 0;
+	}
+	__enable_irq();
+}
+
+/**
+ * @brief  Take the time of the VSYNC. Called by the VSYNC interrupt.
+ * @param  None
+ * @retval None
+ */
+void LATENCY_Vsync(void) {
+	latency_vsync_prev_us = latency_vsync_us;
+	latency_vsync_us = TIMEBASE_Us();
+	if (latency_vsyncs < 2)
+		latency_vsyncs++;
+}
+
+/**
+ * @brief  Start the time stamps of a captured frame. Called by the
+ * 		   frame interrupt.
+ * @param  seq frame sequence number
+ * @param  us time of the frame interrupt
+ * @retval None
+ */
+void LATENCY_Frame(uint16_t seq, uint32_t us) {
+	Latency_FrameTypeDef *f = &latency_frames[seq & LATENCY_MASK];
+	int i;
+
+	f->seq = seq;
+	for (i = 0; i < LATENCY_POINTS; i++)
+		f->marked[i] = 0;
+
+	// The VSYNC at the begin of the frame
+	if ((latency_vsyncs > 0) && (us - latency_vsync_us >= LATENCY_VSYNC_GAP_US)) {
+		f->us[LATENCY_VSYNC] = latency_vsync_us;
+		f->marked[LATENCY_VSYNC] = 1;
+	} else if (latency_vsyncs > 1) {
+		f->us[LATENCY_VSYNC] = latency_vsync_prev_us;
+		f->marked[LATENCY_VSYNC] = 1;
+	}
+	f->us[LATENCY_FRAME] = us;
+	f->marked[LATENCY_FRAME] = 1;
+}
+
+/**
+ * @brief  Add the times of a frame, whose IR packet was sent completely
+ * @param  f the frame
+ * @retval None
+ */
+static void LATENCY_Add(const Latency_FrameTypeDef *f) {
+	Latency_StageTypeDef *s;
+	uint32_t us;
+	int i;
+
+	for (i = 0; i < LATENCY_POINTS - 1; i++) {
+		if (!f->marked[i] || !f->marked[i + 1])
+			continue;
+		us = f->us[i + 1] - f->us[i];
+		s = &latency_stages[i];
+		s->count++;
+		s->sum += us;
+		if (us > s->max)
+			s->max = us;
+	}
+
+	if (!f->marked[LATENCY_VSYNC])
+		return;
+	us = f->us[LATENCY_IR_END] - f->us[LATENCY_VSYNC];
+	latency_last_us = us;
+	latency_count++;
+	latency_sum += us;
+	if (us < latency_min)
+		latency_min = us;
+	if (us > latency_max)
+		latency_max = us;
+	us /= LATENCY_BUCKET_US;
+	latency_histogram[(us < LATENCY_BUCKETS) ? us : LATENCY_BUCKETS - 1]++;
+}
+
+/**
+ * @brief  Take a time stamp of a frame. It is ignored, if the frame
+ * 		   is already overwritten by a newer one.
+ * 		   It is called from the main loop and from interrupts.
+ * @param  seq frame sequence number
+ * @param  point the point in the pipeline
+ * @retval None
+ */
+void LATENCY_Mark(uint16_t seq, Latency_PointTypeDef point) {
+	Latency_FrameTypeDef *f = &latency_frames[seq & LATENCY_MASK];
+
+	if (f->seq != seq)
+		return;
+	f->us[point] = TIMEBASE_Us();
+	f->marked[point] = 1;
+	if (point == LATENCY_IR_END)
+		LATENCY_Add(f);
+}
+
+/**
+ * @brief  Print the statistics to the debug port
+ * @param  None
+ * @retval None
+ */
+void LATENCY_Print(void) {
+	Latency_StageTypeDef *s;
+	int i;
+
+	my_printf("Latency from VSYNC to the end of the IR packet, %u frames\r\n",
+			latency_count);
+	if (latency_count == 0)
+		return;
+	my_printf("min %u us, mean %u us, max %u us, last %u us\r\n", latency_min,
+			(uint32_t)(latency_sum / latency_count), latency_max,
+			latency_last_us);
+
+	for (i = 0; i < LATENCY_POINTS - 1; i++) {
+		s = &latency_stages[i];
+		if (s->count > 0)
+			my_printf("%-8s mean %6u us, max %6u us\r\n", latency_stage_names[i],
+					(uint32_t)(s->sum / s->count), s->max);
+	}
+
+	// Histogram in ms
+	my_printf("ms:frames ");
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		if (latency_histogram[i] > 0)
+			my_printf("%u:%u ", i * LATENCY_BUCKET_US / 1000,
+					latency_histogram[i]);
+	my_printf("\r\n");
+}
@@ -25,10 +25,29 @@
 #include "lcd.h"
 #include "track.h"
 #include "logo.h"
+#include "overview.h"
+#include "history.h"
+#include "profile.h"
+#include "lcdline.h"
 
 
 /* local variables -----------------------------------------------------------*/
 uint16_t color_table[256];
+uint32_t color_table2[256];	// color_table with doubled pixels
+
+// One line of the zoomed image
+LcdLine_BufferTypeDef lcd_line;
+
+int lcd_zoom = LCD_ZOOM_2X;			// Magnification of the zoomed image
+int lcd_last_zoom = LCD_ZOOM_2X;	// Magnification of the last drawn image
+int lcd_pan_x = LCD_PAN_AUTO;		// Upper left visible camera pixel
+int lcd_pan_y = LCD_PAN_AUTO;
+
+// Geometry of the last drawn zoomed image
+int lcd_image_pos;		// left and upper LCD pixel
+int lcd_image_size;		// width and height in LCD pixels
+int lcd_image_pan_x;	// upper left visible camera pixel
+int lcd_image_pan_y;
 
 /**
  * @brief Initialize the LCD
@@ -51,6 +70,9 @@ void LCD_Init(void) {
 
 		// Fill the color table with 256 shades of green
 		color_table[x] = ((x / 4) << 5);
+
+		// The same color for 2 neighbor pixels
+		color_table2[x] = (color_table[x] << 16) | color_table[x];
 	}
 
 	// Fill the screen black
@@ -103,6 +125,7 @@ void LCD_Print(int x, int y, char * s, int transparent) {
 	int xx;
 	int ci;
 
+	PROFILE_BEGIN(PROFILE_LCD_PRINT);
 	cx = x;
 	// Get the next character (max 10)
 	for (ci = 0; (ci < 10) && (s[ci]!=0); ci++) {
@@ -128,6 +151,7 @@ void LCD_Print(int x, int y, char * s, int transparent) {
 			}
 		}
 	}
+	PROFILE_END(PROFILE_LCD_PRINT);
 }
 
 /**
@@ -175,72 +199,129 @@ void LCD_MiniWindow(Camera_SizeTypeDef cameraSize) {
 }
 
 
+/**
+ * @brief Set the magnification of the zoomed camera image
+ *
+ * @param zoom LCD_ZOOM_1X, LCD_ZOOM_2X or LCD_ZOOM_4X
+ * @retval None
+ */
+void LCD_SetZoom(int zoom) {
+	if ((zoom == LCD_ZOOM_1X) || (zoom == LCD_ZOOM_2X) || (zoom == LCD_ZOOM_4X))
+		lcd_zoom = zoom;
+}
+
+/**
+ * @brief Set the pan offset of the zoomed camera image
+ * The offset is the upper left camera pixel of the visible area.
+ * With LCD_PAN_AUTO the visible area follows the light point.
+ *
+ * @param x horizontal offset in camera pixels or LCD_PAN_AUTO
+ * @param y vertical offset in camera pixels or LCD_PAN_AUTO
+ * @retval None
+ */
+void LCD_SetPan(int x, int y) {
+	lcd_pan_x = x;
+	lcd_pan_y = y;
+}
+
 /**
  * @brief Draw the content of an pixel array to the LCD
- * Draw one logical pixel of the array as 4 (2x2) pixels
+ * Each camera line is expanded once into a line buffer with the
+ * doubled pixel color table, and the buffer is sent 1, 2 or 4 times.
  * Show also a red cursor
  *
  * @param pixelp pointer to the pixel array
  */
 void LCD_Image_Zoomed(uint8_t* pixelp) {
 
-	int x, y;
-	int v;
-
-	int cursor_x = 120 - position_intx;
-	int cursor_y = 2 * position_inty;
+	int x, y, i;
+	LcdLine_ZoomTypeDef z;
+	uint16_t *bufp;
 
-	//Show or hide the cursor
-	if (track_status != TRACK_CENTER_DETECTED) {
-		cursor_x = -1;
-		cursor_y = -1;
+	// Clear the borders, if the magnification has changed
+	if (lcd_zoom != lcd_last_zoom) {
+		LCD_Clr();
+		lcd_last_zoom = lcd_zoom;
 	}
 
-	// Define the region to draw
-	ili9325_SetDisplayWindow(0, 0, 240, 240);
-	ili9325_SetCursor(0, 0);
+	LCDLINE_Setup(&z, lcd_zoom, lcd_pan_x, lcd_pan_y, position_intx,
+			position_inty, track_status == TRACK_CENTER_DETECTED);
+
+	// Remember the geometry for the trail
+	lcd_image_pos = (240 - z.size) / 2;
+	lcd_image_size = z.size;
+	lcd_image_pan_x = z.pan_x;
+	lcd_image_pan_y = z.pan_y;
+
+	// Define the region to draw in the center of the video area
+	ili9325_SetDisplayWindow(lcd_image_pos, lcd_image_pos, z.size, z.size);
+	ili9325_SetCursor(lcd_image_pos, lcd_image_pos);
 
 	// Prepare to write to the LCD ram
 	LCD_IO_WriteReg(LCD_REG_34);
 	LCD_CD_DATA();
-	for (y = 0; y < 240; y++) {
-		if (y == cursor_y) {
-
-			// Draw the vertical cursor line
-			for (x = 240; x != 0; x--) {
+	for (y = z.pan_y; y < z.pan_y + z.span; y++) {
 
-				// 2 pixels width
-				LCD_IO_WRITE_1xDATA(LCD_RED);
-				LCD_IO_WRITE_1xDATA(LCD_RED);
-			}
-			pixelp += 120;
-			y++;
+		// Expand the camera line into the line buffer
+		LCDLINE_Expand(&z, &lcd_line, pixelp, y, color_table, color_table2);
 
-		} else {
-
-			for (x = 120; x != 0; x--) {
-				// Draw the camera image
-				v = color_table[*pixelp];
-				// Draw the horizontal cursor line
-				if (x == cursor_x)
-					v = LCD_RED;
-				// 2 pixels width
-				LCD_IO_WRITE_1xDATA(v);
-				LCD_IO_WRITE_1xDATA(v);
-				pixelp++;
+		// Send the line buffer once per LCD line
+		for (i = z.zoom; i != 0; i--) {
+			bufp = lcd_line.pixel;
+			for (x = z.size; x != 0; x--) {
+				LCD_IO_WRITE_1xDATA(*bufp++);
 			}
 		}
-		// 2 pixels height
-		if (y % 2 == 0) {
-			pixelp -= 120;
-		}
 	}
 }
 
-void LCD_Image_Total(uint8_t* pixelp) {
+/**
+ * @brief Draw the last positions as trail over the zoomed image.
+ * Only the single trail pixels are written, so this must be called
+ * after LCD_Image_Zoomed.
+ *
+ * @param  None
+ * @retval None
+ */
+void LCD_Trail(void) {
+	int i;
+	int x, y;
+	int zoom = lcd_last_zoom;
+	History_EntryTypeDef *e;
+
+	for (i = 1; i < HISTORY_TRAIL; i++) {
+		e = HISTORY_Get(i);
+		if (e == 0)
+			break;
+		if (e->status != TRACK_CENTER_DETECTED)
+			continue;
+
+		// Position in the actual camera window with sub pixels
+		x = ((e->x - offset_window_x - lcd_image_pan_x) * 1000 + e->subx) * zoom / 1000;
+		y = ((e->y - offset_window_y - lcd_image_pan_y) * 1000 + e->suby) * zoom / 1000;
+
+		// Only pixels inside the image
+		if (x < 0 || x >= lcd_image_size || y < 0 || y >= lcd_image_size)
+			continue;
+
+		ili9325_SetCursor(lcd_image_pos + x, lcd_image_pos + y);
+		LCD_IO_WriteReg(LCD_REG_34);
+		LCD_IO_WriteData(LCD_YELLOW);
+	}
+}
+
+/**
+ * @brief Draw the actual 864x108 pixel tile of the search.
+ * The tile is taken from the overview, so it must be updated first.
+ *
+ * @param  None
+ * @retval None
+ */
+void LCD_Image_Total(void) {
 
 	int x, y;
 	int v;
+	uint8_t *pixelp;
 
 	// Define the region to draw
 	ili9325_SetDisplayWindow(window_x*72+12, window_y*9+39, 72, 9);
@@ -250,19 +331,77 @@ void LCD_Image_Total(uint8_t* pixelp) {
 	LCD_IO_WriteReg(LCD_REG_34);
 	LCD_CD_DATA();
 	for (y = 0; y < 9; y++) {
-
+		pixelp = &overview[window_y * 9 + y][window_x * 72];
 		for (x = 72; x != 0; x--) {
 			// Draw the camera image
-			v = color_table[*pixelp];
-			// 2 pixels width
+			v = color_table[*pixelp++];
 			LCD_IO_WRITE_1xDATA(v);
-			pixelp+=4*3;
 		}
-		pixelp += 864*3*3;
+	}
+}
+
+/**
+ * @brief Draw the overview of the whole camera field into the same area
+ * as the tiles of LCD_Image_Total and highlight the actual camera window
+ *
+ * @param  None
+ * @retval None
+ */
+void LCD_Overview(void) {
+	int x, y;
+	int v;
+	int roi_x1, roi_x2, roi_y1, roi_y2;
+	uint8_t *pixelp;
+
+	// The actual camera window in overview pixels
+	roi_x1 = offset_x / OVERVIEW_SCALE;
+	roi_y1 = offset_y / OVERVIEW_SCALE;
+	if (BSP_CAMERA_GetSize() == CAMERA_ZOOMED) {
+		roi_x2 = roi_x1 + 120 / OVERVIEW_SCALE - 1;
+		roi_y2 = roi_y1 + 120 / OVERVIEW_SCALE - 1;
+	} else {
+		roi_x2 = roi_x1 + 864 / OVERVIEW_SCALE - 1;
+		roi_y2 = roi_y1 + 108 / OVERVIEW_SCALE - 1;
+	}
+
+	// Define the region to draw
+	ili9325_SetDisplayWindow(12, 39, OVERVIEW_W, OVERVIEW_H);
+	ili9325_SetCursor(12, 39);
 
+	// Prepare to write to the LCD ram
+	LCD_IO_WriteReg(LCD_REG_34);
+	LCD_CD_DATA();
+	pixelp = &overview[0][0];
+	for (y = 0; y < OVERVIEW_H; y++) {
+		for (x = 0; x < OVERVIEW_W; x++) {
+			v = color_table[*pixelp++];
+			// Draw the frame of the camera window
+			if (y >= roi_y1 && y <= roi_y2 && x >= roi_x1 && x <= roi_x2) {
+				if (y == roi_y1 || y == roi_y2 || x == roi_x1 || x == roi_x2)
+					v = LCD_RED;
+			}
+			LCD_IO_WRITE_1xDATA(v);
+		}
 	}
 }
 
+/**
+ * @brief Read one line of the whole 320x240 pixel display
+ *
+ * @param y line to read 0..239
+ * @param buf buffer for 320+1 values. The first value is a dummy read,
+ * 			  the pixels start at buf[1]
+ * @retval None
+ */
+void LCD_ReadLine(int y, uint16_t *buf) {
+	ili9325_SetDisplayWindow(0, 0, 320, 240);
+	ili9325_SetCursor(0, y);
+
+	// Prepare to read the LCD ram
+	LCD_IO_WriteReg(LCD_REG_34);
+	LCD_IO_ReadBlock(buf, 320 + 1);
+}
+
 /**
  * @brief Clear the whole 240x240 pixel video area and fill it with black pixels
  *
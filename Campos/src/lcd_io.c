@@ -115,30 +115,37 @@ void LCD_IO_WriteReg(uint8_t value) {
  */
 uint16_t LCD_IO_ReadData(void) {
 	uint16_t data;
-	GPIO_InitTypeDef GPIO_InitStructure;
+
+	LCD_IO_ReadBlock(&data, 1);
+	return data;
+}
+
+/**
+ * @brief  Read a block of data from the LCD
+ * The data port is switched to input only once for the whole block.
+ * @param  buf buffer for the data
+ * @param  n number of 16 bit words to read
+ * @retval None
+ */
+void LCD_IO_ReadBlock(uint16_t *buf, int n) {
+	volatile int wait;
 
 	// Switch all LCD data ports to input
-	GPIO_InitStructure.Pin = GPIO_PIN_All;
-	GPIO_InitStructure.Mode = GPIO_MODE_INPUT;
-	GPIO_InitStructure.Pull = GPIO_NOPULL;
-	GPIO_InitStructure.Speed = GPIO_SPEED_FAST;
-	HAL_GPIO_Init(LCD_DATA_GPIO_PORT, &GPIO_InitStructure);
+	LCD_DATA_INPUT();
 
 	// Set CD to read data
 	LCD_CD_DATA();
 
-	// Short RDX pulse
-	LCD_RDX_LOW();
-	// Read data now
-	data = LCD_DATA_GPIO_PORT->IDR;
-	LCD_RDX_HIGH();
+	for (; n != 0; n--) {
+		// RDX pulse. The controller needs some time to output the data
+		LCD_RDX_LOW();
+		for (wait = LCD_IO_READ_WAIT; wait != 0; wait--)
+			;
+		// Read data now
+		*buf++ = LCD_DATA_GPIO_PORT->IDR;
+		LCD_RDX_HIGH();
+	}
 
 	// Switch back to output
-	GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;
-	HAL_GPIO_Init(LCD_DATA_GPIO_PORT, &GPIO_InitStructure);
-
-	return data;
+	LCD_DATA_OUTPUT();
 }
-
-
-
@@ -0,0 +1,128 @@
+/**
+ *  Project     Campos
+ *  @file		lcdline.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Lines of the zoomed camera image for the LCD.
+ *  			It does not use the HAL, so the host tools compile it, too.
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "lcdline.h"
+
+/**
+ * @brief Calculate the pan offset in one direction
+ *
+ * @param pan the requested pan offset, negative to follow the light point
+ * @param position the position of the light point
+ * @param span the number of visible camera pixels
+ * @retval the offset of the first visible camera pixel
+ */
+static int LCDLINE_PanOffset(int pan, int position, int span) {
+	if (pan < 0)
+		pan = position - span / 2;
+	if (pan > LCDLINE_CAMERA_SIZE - span)
+		pan = LCDLINE_CAMERA_SIZE - span;
+	if (pan < 0)
+		pan = 0;
+	return pan;
+}
+
+/**
+ * @brief Calculate the geometry of the zoomed image
+ *
+ * @param z the geometry
+ * @param zoom LCD pixels per camera pixel: 1, 2 or 4
+ * @param pan_x requested horizontal pan offset, negative to follow the light point
+ * @param pan_y requested vertical pan offset, negative to follow the light point
+ * @param position_x position of the light point in camera pixels
+ * @param position_y position of the light point in camera pixels
+ * @param cursor != 0 to show the cursor at the position
+ * @retval None
+ */
+void LCDLINE_Setup(LcdLine_ZoomTypeDef *z, int zoom, int pan_x, int pan_y,
+		int position_x, int position_y, int cursor) {
+
+	z->zoom = zoom;
+	z->size = LCDLINE_CAMERA_SIZE * zoom;
+	if (z->size > LCDLINE_SIZE)
+		z->size = LCDLINE_SIZE;
+	z->span = z->size / zoom;
+
+	z->pan_x = LCDLINE_PanOffset(pan_x, position_x, z->span);
+	z->pan_y = LCDLINE_PanOffset(pan_y, position_y, z->span);
+
+	//Show or hide the cursor
+	if (cursor) {
+		z->cursor_x = position_x - z->pan_x;
+		z->cursor_y = position_y;
+	} else {
+		z->cursor_x = -1;
+		z->cursor_y = -1;
+	}
+}
+
+/**
+ * @brief Expand one camera line into the line buffer with the doubled
+ * pixel color table. The cursor is drawn into the buffer, too.
+ * The buffer is sent zoom times to the LCD.
+ *
+ * @param z the geometry
+ * @param line the line buffer
+ * @param pixels the pixel array of the camera
+ * @param y the camera line
+ * @param table color table
+ * @param table2 color table with the color in both halves
+ * @retval None
+ */
+void LCDLINE_Expand(const LcdLine_ZoomTypeDef *z, LcdLine_BufferTypeDef *line,
+		const uint8_t *pixels, int y, const uint16_t *table,
+		const uint32_t *table2) {
+	int x;
+	uint32_t v;
+	const uint8_t *p;
+
+	// The horizontal cursor line
+	if (y == z->cursor_y) {
+		v = (LCDLINE_CURSOR << 16) | LCDLINE_CURSOR;
+		for (x = 0; x < z->size / 2; x++)
+			line->pair[x] = v;
+		return;
+	}
+
+	p = pixels + y * LCDLINE_CAMERA_SIZE + z->pan_x;
+	if (z->zoom == 1) {
+		for (x = 0; x < z->span; x++)
+			line->pixel[x] = table[*p++];
+	} else if (z->zoom == 2) {
+		for (x = 0; x < z->span; x++)
+			line->pair[x] = table2[*p++];
+	} else {
+		for (x = 0; x < 2 * z->span; x += 2) {
+			v = table2[*p++];
+			line->pair[x] = v;
+			line->pair[x + 1] = v;
+		}
+	}
+
+	// The vertical cursor line
+	if ((z->cursor_x >= 0) && (z->cursor_x < z->span)) {
+		for (x = z->cursor_x * z->zoom; x < (z->cursor_x + 1) * z->zoom; x++)
+			line->pixel[x] = LCDLINE_CURSOR;
+	}
+}
@@ -29,14 +29,296 @@
 #include "track.h"
 #include "irlink.h"
 #include "power.h"
+#include "boot.h"
+#include "overview.h"
+#include "timebase.h"
+#include "framestream.h"
+#include "trace.h"
+#include "config.h"
+#include "param.h"
+#include "profile.h"
+#include "latency.h"
+#include "sched.h"
+#include "command.h"
 
 /* function prototypes ------------------------------------------------------*/
 void SystemClock_Config(void);
 Camera_SizeTypeDef lastSize = CAMERA_NONE;
 Camera_SizeTypeDef cameraSize = CAMERA_NONE;
+int lastView = 0;
 char txt[20]; // Temporary memory for strings
 int blink = 0;
 int mytick = 0;
+int splash = 1; // The startup logo is visible
+char * state_txt = ""; // Tracking status as text
+uint32_t frame_start_us; // Start of the frame processing
+int lcd_frame = 0; // The new frame can be drawn on the LCD
+/**
+ * @brief  Set the LEDs and the status text by the tracking status
+ * @param  None
+ * @retval None
+ */
+static void MAIN_Status(void) {
+	switch (track_status) {
+	case TRACK_INIT:
+		state_txt = "Init     ";
+		BSP_LED_Off(LED_GREEN);
+		BSP_LED_Off(LED_BLUE);
+		if (blink)
+			BSP_LED_On(LED_RED);	// red blinking
+		else
+			BSP_LED_Off(LED_RED);	// red blinking
+		break;
+	case TRACK_SEARCHING:
+		state_txt = "Searching";
+		BSP_LED_Off(LED_GREEN);
+		BSP_LED_Off(LED_BLUE);
+		if (blink)
+			BSP_LED_On(LED_RED);	// red blinking
+		else
+			BSP_LED_Off(LED_RED);	// red blinking
+
+		break;
+	case TRACK_LIGHT_FOUND:
+		state_txt = "Light    ";
+		BSP_LED_Off(LED_GREEN);
+		BSP_LED_Off(LED_BLUE);
+		if (blink)
+			BSP_LED_On(LED_RED);	// red blinking
+		else
+			BSP_LED_Off(LED_RED);	// red blinking
+		break;
+	case TRACK_CENTER_DETECTED:
+		state_txt = "Center   ";
+		BSP_LED_On(LED_GREEN); // green
+		BSP_LED_Off(LED_BLUE);
+		BSP_LED_Off(LED_RED);
+		break;
+	case TRACK_LOST:
+		state_txt = "Lost     ";
+		BSP_LED_Off(LED_GREEN);
+		BSP_LED_Off(LED_BLUE);
+		BSP_LED_On(LED_RED);	// red
+		break;
+	}
+}
+
+/**
+ * @brief  Track task: search for the light in a new frame.
+ * 		   Started by the frame interrupt.
+ * @param  None
+ * @retval None
+ */
+static void MAIN_TrackTask(void) {
+
+	// The frame may be suppressed after it was posted
+	if (frame_flag == 0)
+		return;
+	frame_flag = 0;
+
+	PROFILE_BEGIN(PROFILE_FRAME);
+	frame_start_us = TIMEBASE_Us();
+	TRACE(TRACE_PROCESS_START, irlink_frame_seq,
+			frame_start_us - irlink_frame_us);
+	BOOT_Mark(BOOT_FIRST_FRAME);
+
+	// Copy the frame for the debug port before it is overwritten
+	PROFILE_BEGIN(PROFILE_FRAME_COPY);
+	FRAMESTREAM_FrameCallback();
+	PROFILE_END(PROFILE_FRAME_COPY);
+
+	// Update the overview of the whole camera field
+	PROFILE_BEGIN(PROFILE_OVERVIEW);
+	if (BSP_CAMERA_GetSize() == CAMERA_ZOOMED)
+		OVERVIEW_UpdateZoomed(&pixels.firstByte, offset_window_x, offset_window_y);
+	else
+		OVERVIEW_UpdateTotal(&pixels.firstByte, window_x, window_y);
+	PROFILE_END(PROFILE_OVERVIEW);
+
+	LATENCY_Mark(irlink_frame_seq, LATENCY_TRACK_START);
+	PROFILE_BEGIN(PROFILE_TRACK);
+	TRACK_Search();
+	PROFILE_END(PROFILE_TRACK);
+	LATENCY_Mark(irlink_frame_seq, LATENCY_TRACK_END);
+	TRACE(TRACE_TRACK, track_status, intensity);
+	PROFILE_END(PROFILE_FRAME);
+
+	// Send the result, then draw the frame
+	SCHED_Post(SCHED_IR);
+	lcd_frame = 1;
+	SCHED_Post(SCHED_LCD);
+}
+
+/**
+ * @brief  IR task: send the tracking result via IR and the telemetry
+ * 		   to the debug port. Started by the track task.
+ * @param  None
+ * @retval None
+ */
+static void MAIN_IrTask(void) {
+
+	PROFILE_BEGIN(PROFILE_IRLINK);
+	IRLINK_Send(track_status ,
+			position_x, position_subx,
+			position_y, position_suby,
+			intensity);
+	PROFILE_END(PROFILE_IRLINK);
+
+	// Debug console
+	TRACE(TRACE_PROCESS_END, irlink_frame_seq,
+			TIMEBASE_Us() - frame_start_us);
+	PROFILE_BEGIN(PROFILE_TELEMETRY);
+	USARTL2_FrameCallback(TIMEBASE_Us() - frame_start_us);
+	PROFILE_END(PROFILE_TELEMETRY);
+}
+
+/**
+ * @brief  Command task: decode the received bytes of the debug port.
+ * 		   Started by the idle line interrupt and the background task.
+ * @param  None
+ * @retval None
+ */
+static void MAIN_CommandTask(void) {
+	int n;
+
+	PROFILE_BEGIN(PROFILE_USART_RX);
+	n = USARTL1_RxBufferTask();
+	PROFILE_END(PROFILE_USART_RX);
+
+	// Only one console character per run, so the other tasks are not blocked.
+	// Bytes that wait for a dump or a response are retried by the background task.
+	if ((n != 0) && USARTL1_RxBufferNotEmpty())
+		SCHED_Post(SCHED_UART_RX);
+}
+
+/**
+ * @brief  LCD task: update the status and draw the last frame.
+ * 		   Started by the track task and the 200ms tick.
+ * @param  None
+ * @retval None
+ */
+static void MAIN_LcdTask(void) {
+
+	// Keep the LCD content, while it is sent as screenshot
+	if (usartl2_dump == USARTL2_DUMP_SCREENSHOT)
+		return;
+
+	PROFILE_BEGIN(PROFILE_LCD);
+
+	// Remove the logo, if the first position was found
+	splash = BOOT_Task();
+	MAIN_Status();
+
+	// Update the LCD, but not while the logo is visible
+	if (lcd_frame && !splash) {
+		cameraSize = BSP_CAMERA_GetSize();
+
+		// Clear the LCD if the size or the view has changed
+		if ((cameraSize != lastSize) || (overview_view != lastView)) {
+			LCD_Clr();
+			// Start the search with the last known overview
+			if (cameraSize == CAMERA_TOTAL)
+				LCD_Overview();
+		}
+		lastSize = cameraSize;
+		lastView = overview_view;
+
+		if (overview_view) {
+			PROFILE_BEGIN(PROFILE_LCD_IMAGE);
+			LCD_Overview();
+			PROFILE_END(PROFILE_LCD_IMAGE);
+		}
+		else if (cameraSize == CAMERA_ZOOMED) {
+			PROFILE_BEGIN(PROFILE_LCD_IMAGE);
+			LCD_Image_Zoomed(&pixels.firstByte);
+			PROFILE_END(PROFILE_LCD_IMAGE);
+			PROFILE_BEGIN(PROFILE_LCD_TRAIL);
+			LCD_Trail();
+			PROFILE_END(PROFILE_LCD_TRAIL);
+		}
+		else {
+			PROFILE_BEGIN(PROFILE_LCD_IMAGE);
+			LCD_Image_Total();
+			PROFILE_END(PROFILE_LCD_IMAGE);
+		}
+	}
+	lcd_frame = 0;
+
+	// Do not draw over the logo
+	if (!splash) {
+		// Update the status window on the right side of the TFT
+		PROFILE_BEGIN(PROFILE_LCD_STATUS);
+		LCD_FocusStatusWindow();
+		LCD_Print(35, LCD_Y_TRACK_STATUS, state_txt, LCD_OPAQUE);
+
+		sprintf_fixed(txt, sizeof(txt), position_x * 1000 + position_subx, 4, 3);
+		LCD_Print(35, LCD_Y_POSX, txt, LCD_OPAQUE);
+
+		sprintf_fixed(txt, sizeof(txt), position_y * 1000 + position_suby, 4, 3);
+		LCD_Print(35, LCD_Y_POSY, txt, LCD_OPAQUE);
+
+		sprintf_fixed(txt, sizeof(txt), intensity, 5, 0);
+		LCD_Print(35, LCD_Y_INTENSITY, txt, LCD_OPAQUE);
+
+		sprintf_fixed(txt, sizeof(txt), batteryFilt, 5, 0);
+		LCD_Print(35, LCD_Y_BATTERY, txt, LCD_OPAQUE);
+
+		// Mini window that shows the position of the actual window
+		PROFILE_BEGIN(PROFILE_LCD_MINIWINDOW);
+		LCD_MiniWindow(BSP_CAMERA_GetSize());
+		PROFILE_END(PROFILE_LCD_MINIWINDOW);
+		PROFILE_END(PROFILE_LCD_STATUS);
+	}
+	PROFILE_END(PROFILE_LCD);
+}
+
+/**
+ * @brief  Power task: battery and blink flag. Started every 200ms.
+ * @param  None
+ * @retval None
+ */
+static void MAIN_PowerTask(void) {
+
+	// Generate a blink flag
+	blink = !blink;
+
+	PROFILE_BEGIN(PROFILE_POWER);
+	POWER_Task();
+	PROFILE_END(PROFILE_POWER);
+
+	// Blink and show the battery also without frames
+	SCHED_Post(SCHED_LCD);
+}
+
+/**
+ * @brief  Background task: streams to the debug port and the flash.
+ * 		   Started every 1ms.
+ * @param  None
+ * @retval None
+ */
+static void MAIN_BackgroundTask(void) {
+
+	// Debug ports
+	USARTL1_Task();
+	COMMAND_Task();
+	USARTL2_DumpTask();
+	PROFILE_BEGIN(PROFILE_FRAMESTREAM);
+	FRAMESTREAM_Task();
+	PROFILE_END(PROFILE_FRAMESTREAM);
+	PROFILE_BEGIN(PROFILE_TRACE);
+	TRACE_Task();
+	PROFILE_END(PROFILE_TRACE);
+
+	// Save changed parameters
+	PROFILE_BEGIN(PROFILE_CONFIG);
+	CONFIG_Task();
+	PROFILE_END(PROFILE_CONFIG);
+
+	// Bytes without an idle line, e.g. a continuous stream
+	if (USARTL1_RxBufferNotEmpty())
+		SCHED_Post(SCHED_UART_RX);
+}
+
 /**
  * @brief  Main program.
  * @param  None
@@ -50,17 +332,45 @@ int main(void) {
 	// Initialize the hardware layer module
 	HAL_Init();
 
-	// Enable systick and configure 500us tick
-	HAL_SYSTICK_Config(168000000/ 2000);
+	// Enable systick and configure 1ms tick
+	HAL_SYSTICK_Config(168000000/ 1000);
+
+	// Record the time stamps of the boot phases
+	BOOT_Init();
+
+	// Start the us time base for the time stamps of the frames
+	TIMEBASE_Init();
+	TRACE_Init();
+	PROFILE_Init();
+
+	// Register the tasks. Their events are ignored until now.
+	SCHED_Init();
+	SCHED_Register(SCHED_FRAME, "track", MAIN_TrackTask, 1, MAIN_TRACK_DEADLINE_US);
+	SCHED_Register(SCHED_IR, "IR", MAIN_IrTask, 0, MAIN_IR_DEADLINE_US);
+	SCHED_Register(SCHED_UART_RX, "command", MAIN_CommandTask, 2, MAIN_COMMAND_DEADLINE_US);
+	SCHED_Register(SCHED_LCD, "LCD", MAIN_LcdTask, 3, MAIN_LCD_DEADLINE_US);
+	SCHED_Register(SCHED_TICK, "power", MAIN_PowerTask, 4, MAIN_POWER_DEADLINE_US);
+	SCHED_Register(SCHED_BACKGROUND, "background", MAIN_BackgroundTask, 4, MAIN_BACKGROUND_DEADLINE_US);
 
 	// Initialize the power module
 	POWER_Init();
+	BOOT_Mark(BOOT_POWER);
+
+	// Switch on the camera. It powers up while the LCD is initialized
+	BSP_CAMERA_PowerOn();
 
 	// Initialize the LCD display
 	LCD_Init();
+	BOOT_Mark(BOOT_LCD);
+
+	// Startup Logo. It stays visible until the first position is found
+	LCD_Logo();
+	LCD_Print(31,14,"1.4.1",LCD_TRANSPARENT);
+	BOOT_Mark(BOOT_LOGO);
 
 	// Initialize the IR link
 	IRLINK_Init();
+	BOOT_Mark(BOOT_IRLINK);
 
 	// Configure LEDs
 	BSP_LED_Init(LED3);
@@ -76,128 +386,25 @@ int main(void) {
 
 	// Initialize the debug port
 	USARTL2_Init();
+	BOOT_Mark(BOOT_USART);
 
-	// Initialize the camera and start video mode
+	// Read the stored parameters. This may erase a flash sector.
+	CONFIG_Init();
+
+	// Initialize the camera and start video mode. The stored parameters
+	// overwrite the default registers before the first frame.
 	BSP_CAMERA_Init();
+	PARAM_Load();
 	BSP_CAMERA_ContinuousStart();
+	BOOT_Mark(BOOT_CAMERA);
 
-	// Initialize the tracking
+	// Initialize the tracking. The search starts behind the logo.
+	OVERVIEW_Init();
 	TRACK_Init();
-
-	// Startup Logo
-	LCD_Logo();
-	LCD_Print(31,14,"1.4.1",LCD_TRANSPARENT);
-	HAL_Delay(5000);
-	LCD_Clr();
-	LCD_DrawInfoWindow();
+	BOOT_Mark(BOOT_TRACK);
 	frame_flag = 0;
 
-
-	// Main loop
-	while (1) {
-
-		// Generate a blink flag
-		if (mytick > 200) {
-			mytick = 0;
-			blink = !blink;
-
-			//200ms Task
-			POWER_Task();
-		}
-
-
-		// Debug ports
-		USARTL1_RxBufferTask();
-
-		// Update the status window on the right side of the TFT
-		LCD_FocusStatusWindow();
-		switch (track_status) {
-		case TRACK_INIT:
-			LCD_Print(35, LCD_Y_TRACK_STATUS, "Init     ", LCD_OPAQUE);
-			BSP_LED_Off(LED_GREEN);
-			BSP_LED_Off(LED_BLUE);
-			if (blink)
-				BSP_LED_On(LED_RED);	// red blinking
-			else
-				BSP_LED_Off(LED_RED);	// red blinking
-			break;
-		case TRACK_SEARCHING:
-			LCD_Print(35, LCD_Y_TRACK_STATUS, "Searching", LCD_OPAQUE);
-			BSP_LED_Off(LED_GREEN);
-			BSP_LED_Off(LED_BLUE);
-			if (blink)
-				BSP_LED_On(LED_RED);	// red blinking
-			else
-				BSP_LED_Off(LED_RED);	// red blinking
-
-			break;
-		case TRACK_LIGHT_FOUND:
-			LCD_Print(35, LCD_Y_TRACK_STATUS, "Light    ", LCD_OPAQUE);
-			BSP_LED_Off(LED_GREEN);
-			BSP_LED_Off(LED_BLUE);
-			if (blink)
-				BSP_LED_On(LED_RED);	// red blinking
-			else
-				BSP_LED_Off(LED_RED);	// red blinking
-			break;
-		case TRACK_CENTER_DETECTED:
-			LCD_Print(35, LCD_Y_TRACK_STATUS, "Center   ", LCD_OPAQUE);
-			BSP_LED_On(LED_GREEN); // green
-			BSP_LED_Off(LED_BLUE);
-			BSP_LED_Off(LED_RED);
-			break;
-		case TRACK_LOST:
-			LCD_Print(35, LCD_Y_TRACK_STATUS, "Lost     ", LCD_OPAQUE);
-			BSP_LED_Off(LED_GREEN);
-			BSP_LED_Off(LED_BLUE);
-			BSP_LED_On(LED_RED);	// red
-			break;
-		}
-		sprintf(txt, "%04d.%03d", position_x, position_subx);
-		LCD_Print(35, LCD_Y_POSX, txt, LCD_OPAQUE);
-
-		sprintf(txt, "%04d.%03d", position_y, position_suby);
-		LCD_Print(35, LCD_Y_POSY, txt, LCD_OPAQUE);
-
-		sprintf(txt, "%05d", intensity);
-		LCD_Print(35, LCD_Y_INTENSITY, txt, LCD_OPAQUE);
-
-		sprintf(txt, "%05d", batteryFilt);
-		LCD_Print(35, LCD_Y_BATTERY, txt, LCD_OPAQUE);
-
-		// Mini window that shows the position of the actual window
-		LCD_MiniWindow(BSP_CAMERA_GetSize());
-
-		// Search for the light
-		if (frame_flag != 0) {
-			frame_flag = 0;
-			TRACK_Search();
-
-			// Send the tracking result via IR
-			IRLINK_Send(track_status ,
-					position_x, position_subx,
-					position_y, position_suby,
-					intensity);
-
-			cameraSize = BSP_CAMERA_GetSize();
-
-			// Clear the LCD if the size has changed
-			if (cameraSize != lastSize)
-				LCD_Clr();
-			lastSize = cameraSize;
-
-			// Update the LCD
-			if (cameraSize == CAMERA_ZOOMED)
-				LCD_Image_Zoomed(&pixels.firstByte);
-			else
-				LCD_Image_Total(&pixels.firstByte);
-			// Debug console
-			USARTL2_FrameCallback();
-		}
-
-	}
-
+	// The interrupts start the tasks, the CPU sleeps in between
+	SCHED_Run();
 }
 
-
-
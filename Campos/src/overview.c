@@ -0,0 +1,164 @@
+/**
+ *  Project     Campos
+ *  @file		overview.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Overview of the whole camera field
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "overview.h"
+#include "camera.h"
+#include "printf.h"
+
+/* global variables ---------------------------------------------------------*/
+// The overview is not accessed by DMA, so it is placed into the CCM RAM.
+// The CCM RAM is not initialized by the startup code.
+uint8_t overview[OVERVIEW_H][OVERVIEW_W] __attribute__((section(".ccmram")));
+int overview_view = 0;
+
+/**
+ * @brief  Initialize the module and clear the overview
+ * @param  None
+ * @retval None
+ */
+void OVERVIEW_Init(void) {
+	int x, y;
+
+	for (y = 0; y < OVERVIEW_H; y++) {
+		for (x = 0; x < OVERVIEW_W; x++) {
+			overview[y][x] = 0;
+		}
+	}
+	overview_view = 0;
+}
+
+/**
+ * @brief  Update the overview with one 864x108 pixel tile of the search.
+ * 		   Each overview pixel is the maximum of 12x12 camera pixels, so
+ * 		   a small light point is not lost.
+ * @param  pixelp pointer to the pixel array
+ * @param  window_x horizontal tile index 0..2
+ * @param  window_y vertical tile index 0..17
+ * @retval None
+ */
+void OVERVIEW_UpdateTotal(uint8_t* pixelp, int window_x, int window_y) {
+	int x, y, xx, yy;
+	uint8_t max;
+	uint8_t *p;
+	uint8_t *dst;
+
+	dst = &overview[window_y * (108 / OVERVIEW_SCALE)][window_x * (864 / OVERVIEW_SCALE)];
+
+	for (y = 0; y < 108 / OVERVIEW_SCALE; y++) {
+		for (x = 0; x < 864 / OVERVIEW_SCALE; x++) {
+			max = 0;
+			p = pixelp + (y * 864 + x) * OVERVIEW_SCALE;
+			for (yy = 0; yy < OVERVIEW_SCALE; yy++) {
+				for (xx = 0; xx < OVERVIEW_SCALE; xx++) {
+					if (p[xx] > max)
+						max = p[xx];
+				}
+				p += 864;
+			}
+			dst[x] = max;
+		}
+		dst += OVERVIEW_W;
+	}
+}
+
+/**
+ * @brief  Update the overview with the zoomed 120x120 pixel window.
+ * 		   Only overview pixels that are completely inside the window
+ * 		   are updated.
+ * @param  pixelp pointer to the pixel array
+ * @param  offset_x offset of the window in camera pixels
+ * @param  offset_y offset of the window in camera pixels
+ * @retval None
+ */
+void OVERVIEW_UpdateZoomed(uint8_t* pixelp, int offset_x, int offset_y) {
+	int x, y, xx, yy;
+	int x1, x2, y1, y2;
+	uint8_t max;
+	uint8_t *p;
+
+	// Overview pixels that are completely inside the window
+	x1 = (offset_x + OVERVIEW_SCALE - 1) / OVERVIEW_SCALE;
+	x2 = (offset_x + 120) / OVERVIEW_SCALE;
+	y1 = (offset_y + OVERVIEW_SCALE - 1) / OVERVIEW_SCALE;
+	y2 = (offset_y + 120) / OVERVIEW_SCALE;
+	if (x2 > OVERVIEW_W)
+		x2 = OVERVIEW_W;
+	if (y2 > OVERVIEW_H)
+		y2 = OVERVIEW_H;
+
+	for (y = y1; y < y2; y++) {
+		for (x = x1; x < x2; x++) {
+			max = 0;
+			p = pixelp + (y * OVERVIEW_SCALE - offset_y) * 120
+					+ x * OVERVIEW_SCALE - offset_x;
+			for (yy = 0; yy < OVERVIEW_SCALE; yy++) {
+				for (xx = 0; xx < OVERVIEW_SCALE; xx++) {
+					if (p[xx] > max)
+						max = p[xx];
+				}
+				p += 120;
+			}
+			overview[y][x] = max;
+		}
+	}
+}
+
+/**
+ * @brief  One line of the overview dump as hex values for the debug port.
+ * 		   The first line contains the size and the actual camera window.
+ * @param  line number of the line, starting with 0
+ * @param  buf output: the text, not terminated
+ * @param  size size of buf, at least OVERVIEW_DUMP_LINE
+ * @retval Length of the line, 0 after the last line
+ */
+int OVERVIEW_DumpLine(int line, char *buf, int size) {
+	static const char hex[] = "0123456789abcdef";
+	int x, w, h;
+	uint8_t *p;
+
+	if (line == 0) {
+		if (BSP_CAMERA_GetSize() == CAMERA_ZOOMED) {
+			w = 120;
+			h = 120;
+		} else {
+			w = 864;
+			h = 108;
+		}
+		return my_snprintf(buf, size, "\r\nOverview %d %d ROI %d %d %d %d\r\n",
+				OVERVIEW_W, OVERVIEW_H,
+				offset_x / OVERVIEW_SCALE, offset_y / OVERVIEW_SCALE,
+				w / OVERVIEW_SCALE, h / OVERVIEW_SCALE);
+	}
+	if (line > OVERVIEW_H)
+		return 0;
+
+	p = overview[line - 1];
+	for (x = 0; x < OVERVIEW_W; x++) {
+		*buf++ = hex[*p >> 4];
+		*buf++ = hex[*p++ & 0x0F];
+	}
+	*buf++ = '\r';
+	*buf = '\n';
+	return OVERVIEW_DUMP_LINE;
+}
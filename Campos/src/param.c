@@ -0,0 +1,239 @@
+/**
+ *  Project     Campos
+ *  @file		param.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Registry of the tunable parameters
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Each parameter has a name, a range and the value after reset. The
+ *  modules keep their own copy of the value in a global variable, so
+ *  the tracking loops read it without a lookup. A parameter is only
+ *  changed with PARAM_Set(), which checks the range and calls the set
+ *  function of the module, e.g. to reprogram a timer.
+ *  The stored parameters are saved in the flash when they are changed,
+ *  and PARAM_Load() sets them again after the next reset.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "param.h"
+#include "camera.h"
+#include "ov5647.h"
+#include "lcd.h"
+#include "overview.h"
+#include "irlink.h"
+#include "track.h"
+#include "config.h"
+
+/* local functions ----------------------------------------------------------*/
+static int32_t PARAM_GetCameraSize(void);
+static void PARAM_SetCameraSize(int32_t value);
+static int32_t PARAM_GetIrFec(void);
+static void PARAM_SetIrFec(int32_t value);
+static void PARAM_SetIrCompact(int32_t value);
+static int32_t PARAM_GetIrPolicy(void);
+static void PARAM_SetIrPolicy(int32_t value);
+static void PARAM_SetIrSymbol(int32_t value);
+static void PARAM_SetLcdZoom(int32_t value);
+static int32_t PARAM_GetExposure(void);
+static void PARAM_SetExposure(int32_t value);
+static int32_t PARAM_GetGain(void);
+static void PARAM_SetGain(int32_t value);
+static void PARAM_SetIrCarrier(int32_t value);
+
+/* local variables ----------------------------------------------------------*/
+extern IrFec_ModeTypeDef irlink_fec;
+extern int irlink_compact;
+extern int irlink_symbol_us;
+extern IrQueue_PolicyTypeDef irqueue_policy;
+extern int lcd_zoom;
+
+// The parameters, index is the Param_IdTypeDef
+static const Param_TypeDef param_table[PARAMS] = {
+	{ "camera_size", PARAM_ENUM, 0, CAMERA_ZOOMED, CAMERA_TOTAL, CAMERA_TOTAL,
+			NULL, PARAM_GetCameraSize, PARAM_SetCameraSize },
+	{ "ir_fec", PARAM_ENUM, 1, IRFEC_NONE, IRFEC_MODES - 1, IRFEC_NONE,
+			NULL, PARAM_GetIrFec, PARAM_SetIrFec },
+	{ "ir_compact", PARAM_BOOL, 1, 0, 1, 0,
+			&irlink_compact, NULL, PARAM_SetIrCompact },
+	{ "ir_policy", PARAM_ENUM, 1, IRQUEUE_DROP_NEWEST, IRQUEUE_DROP_OLDEST,
+			IRQUEUE_DROP_OLDEST, NULL, PARAM_GetIrPolicy, PARAM_SetIrPolicy },
+	{ "ir_symbol_us", PARAM_INT, 1, IRLINK_SYMBOL_MIN_US, IRLINK_SYMBOL_MAX_US,
+			IRLINK_SYMBOL_US, &irlink_symbol_us, NULL, PARAM_SetIrSymbol },
+	{ "lcd_zoom", PARAM_ENUM, 1, LCD_ZOOM_1X, LCD_ZOOM_4X, LCD_ZOOM_2X,
+			&lcd_zoom, NULL, PARAM_SetLcdZoom },
+	{ "overview", PARAM_BOOL, 0, 0, 1, 0,
+			&overview_view, NULL, NULL },
+	{ "exposure", PARAM_INT, 1, 0, 0xFFFFF, OV5647_EXPOSURE,
+			NULL, PARAM_GetExposure, PARAM_SetExposure },
+	{ "gain", PARAM_INT, 1, 0, 0x3FF, OV5647_GAIN,
+			NULL, PARAM_GetGain, PARAM_SetGain },
+	{ "ir_carrier_hz", PARAM_INT, 1, IRLINK_CARRIER_MIN_HZ,
+			IRLINK_CARRIER_MAX_HZ, IRLINK_CARRIER_HZ,
+			&irlink_carrier_hz, NULL, PARAM_SetIrCarrier },
+	{ "track_pixel_min", PARAM_INT, 1, 0, 254, TRACK_PIXEL_MIN,
+			&track_pixel_min, NULL, NULL },
+	{ "track_search_min", PARAM_INT, 1, 0, 254, TRACK_SEARCH_MIN,
+			&track_search_min, NULL, NULL },
+	{ "track_intensity_min", PARAM_INT, 1, 0, 32 * 32 * 255,
+			TRACK_INTENSITY_MIN, &track_intensity_min, NULL, NULL },
+	{ "track_lost_frames", PARAM_INT, 1, 0, 1000, TRACK_LOST_FRAMES,
+			&track_lost_frames, NULL, NULL },
+	{ "track_window_step", PARAM_INT, 1, TRACK_WINDOW_STEP_MIN,
+			TRACK_WINDOW_STEP_MAX, TRACK_WINDOW_STEP,
+			&track_window_step, NULL, NULL },
+	{ "ir_latency", PARAM_BOOL, 1, 0, 1, 0,
+			&irlink_latency, NULL, NULL }
+};
+
+/* Parameters ---------------------------------------------------------------*/
+static int32_t PARAM_GetCameraSize(void) {
+	return BSP_CAMERA_GetSize();
+}
+
+static void PARAM_SetCameraSize(int32_t value) {
+	BSP_CAMERA_SetSize(value);
+}
+
+static int32_t PARAM_GetIrFec(void) {
+	return irlink_fec;
+}
+
+static void PARAM_SetIrFec(int32_t value) {
+	IRLINK_SetFec(value);
+}
+
+static void PARAM_SetIrCompact(int32_t value) {
+	IRLINK_SetCompact(value);
+}
+
+static int32_t PARAM_GetIrPolicy(void) {
+	return irqueue_policy;
+}
+
+static void PARAM_SetIrPolicy(int32_t value) {
+	IRQUEUE_SetPolicy(value);
+}
+
+static void PARAM_SetIrSymbol(int32_t value) {
+	IRLINK_SetSymbolPeriod(value);
+}
+
+static void PARAM_SetLcdZoom(int32_t value) {
+	LCD_SetZoom(value);
+}
+
+static int32_t PARAM_GetExposure(void) {
+	return camera_exposure;
+}
+
+static void PARAM_SetExposure(int32_t value) {
+	BSP_CAMERA_DebugWrite(OV5647_EXPOSURE_H, (value >> 16) & 0x0F);
+	BSP_CAMERA_DebugWrite(OV5647_EXPOSURE_M, (value >> 8) & 0xFF);
+	BSP_CAMERA_DebugWrite(OV5647_EXPOSURE_L, value & 0xFF);
+}
+
+static int32_t PARAM_GetGain(void) {
+	return camera_gain;
+}
+
+static void PARAM_SetGain(int32_t value) {
+	BSP_CAMERA_DebugWrite(OV5647_GAIN_H, (value >> 8) & 0x03);
+	BSP_CAMERA_DebugWrite(OV5647_GAIN_L, value & 0xFF);
+}
+
+static void PARAM_SetIrCarrier(int32_t value) {
+	IRLINK_SetCarrier(value);
+}
+
+/* Registry -----------------------------------------------------------------*/
+
+/**
+ * @brief  Description of a parameter
+ * @param  id Param_IdTypeDef
+ * @retval the parameter, or NULL for an unknown id
+ */
+const Param_TypeDef * PARAM_Info(int id) {
+	if (id < 0 || id >= PARAMS)
+		return NULL;
+	return &param_table[id];
+}
+
+/**
+ * @brief  Read a parameter
+ * @param  id Param_IdTypeDef, it must be valid
+ * @retval the value
+ */
+int32_t PARAM_Get(int id) {
+	const Param_TypeDef *p = &param_table[id];
+
+	if (p->value)
+		return *p->value;
+	return p->get();
+}
+
+/**
+ * @brief  Check a new value
+ * @param  id Param_IdTypeDef
+ * @param  value the new value
+ * @retval 1 if the id is known and the value in range
+ */
+int PARAM_Check(int id, int32_t value) {
+	const Param_TypeDef *p = PARAM_Info(id);
+
+	return p && (value >= p->min) && (value <= p->max);
+}
+
+/**
+ * @brief  Change a parameter
+ * @param  id Param_IdTypeDef
+ * @param  value the new value
+ * @retval 0 on success, -1 if the id is unknown or the value out of range
+ */
+int PARAM_Set(int id, int32_t value) {
+	const Param_TypeDef *p;
+
+	if (!PARAM_Check(id, value))
+		return -1;
+	p = &param_table[id];
+	if (p->set)
+		p->set(value);
+	else
+		*p->value = value;
+
+	// The flash is programmed later by the main loop
+	if (p->stored)
+		CONFIG_Write(PARAM_CONFIG_KEY(id), PARAM_Get(id));
+	return 0;
+}
+
+/**
+ * @brief  Set the parameters that are saved in the flash. Called after
+ * 		   the modules and the camera registers were initialized, and
+ * 		   before the capture is started.
+ * @param  None
+ * @retval None
+ */
+void PARAM_Load(void) {
+	uint32_t value;
+	int id;
+
+	for (id = 0; id < PARAMS; id++) {
+		if (param_table[id].stored
+				&& (CONFIG_Read(PARAM_CONFIG_KEY(id), &value) == 0))
+			PARAM_Set(id, value);
+	}
+}
@@ -27,183 +27,513 @@
 */
 
 /*
-	putchar is the only external dependency for this file,
-	if you have a working putchar, just remove the following
-	define. If the function should be called something else,
-	replace outbyte(c) by your own function call.
+	The arguments are read with va_arg, so it works with any optimization
+	and calling convention.
+	Supported: flags - 0 + space #, width and precision (also *),
+	length modifiers hh h l ll z t j, conversions d i u x X o c s p %.
+	There is no floating point. Fixed point values are printed with
+	sprintf_fixed().
+
+	Decimal numbers are converted 2 digits at a time with a table. The
+	division by 100 is a multiplication with the reciprocal, only 64 bit
+	values use the (slow) library division.
 */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
 #include "printf.h"
 
+/* Defines -------------------------------------------------------------------*/
+#define PAD_RIGHT	0x01	// '-' flag
+#define PAD_ZERO	0x02	// '0' flag
+#define SIGN_PLUS	0x04	// '+' flag
+#define SIGN_SPACE	0x08	// ' ' flag
+#define ALTERNATE	0x10	// '#' flag
+
+// Enough for a 64 bit value in octal
+#define PRINT_BUF_LEN 24
+
+// u / 100 for all 32 bit values of u
+#define DIV100(u)	((uint32_t)(((uint64_t)(u) * 0x51EB851Fu) >> 37))
+
+/* Typedefs ------------------------------------------------------------------*/
+typedef struct {
+	char *buf;		// NULL: output to the debug port
+	size_t size;	// Size of buf including the terminating 0
+	size_t pos;		// Number of characters, also those that did not fit
+} printf_out;
+
+/* local variables -----------------------------------------------------------*/
+static const char digits2[200] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
 /**
- * The printchar function that uses the USART
+ * The printchar function that uses the USART or the buffer
  */
-static void printchar(char **str, int c)
+static void printchar(printf_out *out, char c)
 {
-	extern int putchar(int c);
-	if (str) {
-		**str = c;
-		++(*str);
+	if (out->buf) {
+		if (out->pos + 1 < out->size)
+			out->buf[out->pos] = c;
 	}
 	else
 		USARTL1_PutByte(& UartHandle, c);
+	out->pos++;
 }
 
-#define PAD_RIGHT 1
-#define PAD_ZERO 2
+/**
+ * Print n characters of a string
+ */
+static void printn(printf_out *out, const char *s, int n)
+{
+	size_t i;
+
+	// Copy directly into the buffer
+	if (out->buf) {
+		for (i = out->pos; n > 0 && i + 1 < out->size; n--, i++, s++)
+			out->buf[i] = *s;
+		out->pos = i + n;
+		return;
+	}
+	for ( ; n > 0; n--)
+		printchar (out, *s++);
+}
 
-static int prints(char **out, const char *string, int width, int pad)
+/**
+ * Print a character n times
+ */
+static void printpad(printf_out *out, char c, int n)
 {
-	register int pc = 0, padchar = ' ';
-
-	if (width > 0) {
-		register int len = 0;
-		register const char *ptr;
-		for (ptr = string; *ptr; ++ptr) ++len;
-		if (len >= width) width = 0;
-		else width -= len;
-		if (pad & PAD_ZERO) padchar = '0';
+	size_t i;
+
+	if (out->buf) {
+		for (i = out->pos; n > 0 && i + 1 < out->size; n--, i++)
+			out->buf[i] = c;
+		out->pos = i + (n > 0 ? n : 0);
+		return;
 	}
-	if (!(pad & PAD_RIGHT)) {
-		for ( ; width > 0; --width) {
-			printchar (out, padchar);
-			++pc;
-		}
+	for ( ; n > 0; n--)
+		printchar (out, c);
+}
+
+/**
+ * Convert a 32 bit value to decimal, 2 digits at a time.
+ * The digits are written in front of end.
+ * Returns the first digit.
+ */
+static char *utoa10(uint32_t u, char *end)
+{
+	uint32_t q;
+
+	while (u >= 100) {
+		q = DIV100(u);
+		end -= 2;
+		end[0] = digits2[2 * (u - q * 100)];
+		end[1] = digits2[2 * (u - q * 100) + 1];
+		u = q;
 	}
-	for ( ; *string ; ++string) {
-		printchar (out, *string);
-		++pc;
+	if (u >= 10) {
+		end -= 2;
+		end[0] = digits2[2 * u];
+		end[1] = digits2[2 * u + 1];
 	}
-	for ( ; width > 0; --width) {
-		printchar (out, padchar);
-		++pc;
+	else
+		*--end = '0' + u;
+	return end;
+}
+
+/**
+ * Convert a value to decimal, hexadecimal or octal.
+ * Returns the first digit.
+ */
+static char *utoa(unsigned long long u, int base, int letbase, char *end)
+{
+	if (base == 10) {
+		// Only values above 32 bit need the 64 bit division
+		while (u > 0xFFFFFFFFu) {
+			*--end = '0' + (int)(u % 10);
+			u /= 10;
+		}
+		return utoa10((uint32_t) u, end);
 	}
 
-	return pc;
+	do {
+		if (base == 16)
+			*--end = (u & 15) < 10 ? '0' + (u & 15) : letbase + (u & 15) - 10;
+		else
+			*--end = '0' + (u & 7);
+		u = (base == 16) ? u >> 4 : u >> 3;
+	} while (u);
+	return end;
 }
 
-/* the following should be enough for 32 bit int */
-#define PRINT_BUF_LEN 12
+/**
+ * Print a string with padding. precision < 0: the whole string
+ */
+static void prints(printf_out *out, const char *string, int width, int precision, int pad)
+{
+	int len = 0;
+
+	while ((precision < 0 || len < precision) && string[len])
+		len++;
+	width -= len;
+
+	if (!(pad & PAD_RIGHT))
+		printpad (out, ' ', width);
+	printn (out, string, len);
+	if (pad & PAD_RIGHT)
+		printpad (out, ' ', width);
+}
 
-static int printi(char **out, int i, int b, int sg, int width, int pad, int letbase)
+/**
+ * Print an integer with sign or prefix, precision and padding
+ */
+static void printi(printf_out *out, unsigned long long u, int neg, int base,
+		int width, int precision, int pad, int letbase)
 {
 	char print_buf[PRINT_BUF_LEN];
-	register char *s;
-	register int t, neg = 0, pc = 0;
-	register unsigned int u = i;
-
-	if (i == 0) {
-		print_buf[0] = '0';
-		print_buf[1] = '\0';
-		return prints (out, print_buf, width, pad);
-	}
+	char prefix[2];
+	char *s, *end = print_buf + PRINT_BUF_LEN;
+	int len, plen = 0, zeros = 0;
 
-	if (sg && b == 10 && i < 0) {
-		neg = 1;
-		u = -i;
+	// Precision 0 and value 0 print no digits
+	if (u == 0 && precision == 0)
+		s = end;
+	else
+		s = utoa (u, base, letbase, end);
+	len = end - s;
+
+	if (neg)
+		prefix[plen++] = '-';
+	else if (pad & SIGN_PLUS)
+		prefix[plen++] = '+';
+	else if (pad & SIGN_SPACE)
+		prefix[plen++] = ' ';
+	if ((pad & ALTERNATE) && u != 0 && base == 16) {
+		prefix[plen++] = '0';
+		prefix[plen++] = letbase + 'x' - 'a';
 	}
+	if ((pad & ALTERNATE) && base == 8 && (len == 0 || *s != '0'))
+		zeros = 1;
 
-	s = print_buf + PRINT_BUF_LEN-1;
-	*s = '\0';
+	if (precision > len)
+		zeros = precision - len;
+	width -= plen + zeros + len;
 
-	while (u) {
-		t = u % b;
-		if( t >= 10 )
-			t += letbase - '0' - 10;
-		*--s = t + '0';
-		u /= b;
+	// The 0 flag is ignored with a precision
+	if ((pad & PAD_ZERO) && !(pad & PAD_RIGHT) && precision < 0 && width > 0) {
+		zeros += width;
+		width = 0;
 	}
 
-	if (neg) {
-		if( width && (pad & PAD_ZERO) ) {
-			printchar (out, '-');
-			++pc;
-			--width;
-		}
-		else {
-			*--s = '-';
-		}
+	if (!(pad & PAD_RIGHT))
+		printpad (out, ' ', width);
+	printn (out, prefix, plen);
+	printpad (out, '0', zeros);
+	printn (out, s, len);
+	if (pad & PAD_RIGHT)
+		printpad (out, ' ', width);
+}
+
+/**
+ * Fast path for %d and %u with flags and width, but without precision
+ * and length modifier. That are nearly all formats of the firmware.
+ */
+static void printd(printf_out *out, uint32_t u, int neg, int width, int pad)
+{
+	char print_buf[PRINT_BUF_LEN];
+	char *s, *end = print_buf + PRINT_BUF_LEN;
+	char sign = 0;
+	int len;
+
+	// The buffer is too small for the zeros
+	if (width >= PRINT_BUF_LEN) {
+		printi (out, u, neg, 10, width, -1, pad, 'a');
+		return;
 	}
 
-	return pc + prints (out, s, width, pad);
+	if (neg)
+		sign = '-';
+	else if (pad & SIGN_PLUS)
+		sign = '+';
+	else if (pad & SIGN_SPACE)
+		sign = ' ';
+
+	s = utoa10 (u, end);
+
+	// The zeros are between the sign and the digits
+	if ((pad & (PAD_ZERO | PAD_RIGHT)) == PAD_ZERO)
+		while (end - s < width - (sign != 0))
+			*--s = '0';
+	if (sign)
+		*--s = sign;
+	len = end - s;
+
+	if (!(pad & PAD_RIGHT))
+		printpad (out, ' ', width - len);
+	printn (out, s, len);
+	if (pad & PAD_RIGHT)
+		printpad (out, ' ', width - len);
 }
 
-static int print(char **out, int *varg)
+/**
+ * The format interpreter
+ */
+static int print(printf_out *out, const char *format, va_list args)
 {
-	register int width, pad;
-	register int pc = 0;
-	register char *format = (char *)(*varg++);
-	char scr[2];
+	int width, precision, pad, length;
+	unsigned long long u;
+	long long i;
+	const char *start;
+	char c;
 
 	for (; *format != 0; ++format) {
-		if (*format == '%') {
+
+		// Copy the text up to the next conversion at once
+		if (*format != '%') {
+			start = format;
+			while (format[1] != '%' && format[1] != 0)
+				format++;
+			printn (out, start, format - start + 1);
+			continue;
+		}
+
+		start = format++;
+		width = pad = 0;
+		precision = -1;
+
+		// Flags
+		for ( ; ; ++format) {
+			if (*format == '-') pad |= PAD_RIGHT;
+			else if (*format == '0') pad |= PAD_ZERO;
+			else if (*format == '+') pad |= SIGN_PLUS;
+			else if (*format == ' ') pad |= SIGN_SPACE;
+			else if (*format == '#') pad |= ALTERNATE;
+			else break;
+		}
+
+		// Width
+		if (*format == '*') {
+			width = va_arg(args, int);
+			if (width < 0) {
+				pad |= PAD_RIGHT;
+				width = -width;
+			}
+			++format;
+		}
+		for ( ; *format >= '0' && *format <= '9'; ++format)
+			width = width * 10 + *format - '0';
+
+		// Precision
+		if (*format == '.') {
 			++format;
-			width = pad = 0;
-			if (*format == '\0') break;
-			if (*format == '%') goto out;
-			if (*format == '-') {
+			precision = 0;
+			if (*format == '*') {
+				precision = va_arg(args, int);
+				if (precision < 0)
+					precision = -1;
 				++format;
-				pad = PAD_RIGHT;
 			}
-			while (*format == '0') {
+			for ( ; *format >= '0' && *format <= '9'; ++format)
+				precision = precision * 10 + *format - '0';
+		}
+
+		// Fast path for the plain decimal integers
+		if ((*format == 'd' || *format == 'u') && precision < 0) {
+			i = va_arg(args, int);
+			if (*format == 'd' && i < 0)
+				printd (out, -(uint32_t) i, 1, width, pad);
+			else
+				printd (out, (uint32_t) i, 0, width,
+						*format == 'd' ? pad : pad & ~(SIGN_PLUS | SIGN_SPACE));
+			continue;
+		}
+
+		// Length modifier: 2 = long long, 1 = long, 0 = int, -1 = short, -2 = char
+		length = 0;
+		if (*format == 'h') {
+			length = -1;
+			if (*++format == 'h') {
+				length = -2;
 				++format;
-				pad |= PAD_ZERO;
-			}
-			for ( ; *format >= '0' && *format <= '9'; ++format) {
-				width *= 10;
-				width += *format - '0';
 			}
-			if( *format == 's' ) {
-				register char *s = *((char **)varg++);
-				pc += prints (out, s?s:"(null)", width, pad);
-				continue;
-			}
-			if( *format == 'd' ) {
-				pc += printi (out, *varg++, 10, 1, width, pad, 'a');
-				continue;
-			}
-			if( *format == 'x' ) {
-				pc += printi (out, *varg++, 16, 0, width, pad, 'a');
-				continue;
-			}
-			if( *format == 'X' ) {
-				pc += printi (out, *varg++, 16, 0, width, pad, 'A');
-				continue;
-			}
-			if( *format == 'u' ) {
-				pc += printi (out, *varg++, 10, 0, width, pad, 'a');
-				continue;
-			}
-			if( *format == 'c' ) {
-				/* char are converted to int then pushed on the stack */
-				scr[0] = *varg++;
-				scr[1] = '\0';
-				pc += prints (out, scr, width, pad);
-				continue;
+		}
+		else if (*format == 'l') {
+			length = 1;
+			if (*++format == 'l') {
+				length = 2;
+				++format;
 			}
 		}
-		else {
-		out:
-			printchar (out, *format);
-			++pc;
+		else if (*format == 'z' || *format == 't') {
+			length = sizeof(size_t) > sizeof(int) ? 1 : 0;
+			++format;
+		}
+		else if (*format == 'j') {
+			length = 2;
+			++format;
+		}
+
+		c = *format;
+		switch (c) {
+		case 'd':
+		case 'i':
+			if (length == 2) i = va_arg(args, long long);
+			else if (length == 1) i = va_arg(args, long);
+			else i = va_arg(args, int);
+			if (length == -1) i = (short) i;
+			if (length == -2) i = (signed char) i;
+			u = i < 0 ? -(unsigned long long) i : (unsigned long long) i;
+			printi (out, u, i < 0, 10, width, precision, pad, 'a');
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			if (length == 2) u = va_arg(args, unsigned long long);
+			else if (length == 1) u = va_arg(args, unsigned long);
+			else u = va_arg(args, unsigned int);
+			if (length == -1) u = (unsigned short) u;
+			if (length == -2) u = (unsigned char) u;
+			printi (out, u, 0, c == 'u' ? 10 : (c == 'o' ? 8 : 16),
+					width, precision, pad & ~(SIGN_PLUS | SIGN_SPACE),
+					c == 'X' ? 'A' : 'a');
+			break;
+		case 'p':
+			u = (uintptr_t) va_arg(args, void *);
+			printi (out, u, 0, 16, width, precision, ALTERNATE | (pad & PAD_RIGHT), 'a');
+			break;
+		case 's':
+			start = va_arg(args, const char *);
+			prints (out, start ? start : "(null)", width, precision, pad);
+			break;
+		case 'c':
+			/* char are converted to int then pushed on the stack */
+			c = (char) va_arg(args, int);
+			if (!(pad & PAD_RIGHT))
+				printpad (out, ' ', width - 1);
+			printchar (out, c);
+			if (pad & PAD_RIGHT)
+				printpad (out, ' ', width - 1);
+			break;
+		case '%':
+			printchar (out, '%');
+			break;
+		default:
+			// Unknown conversion: print it as it is
+			if (c == 0)
+				--format;
+			printn (out, start, format - start + 1);
+			break;
 		}
 	}
-	if (out) **out = '\0';
-	return pc;
-}
 
-/* assuming sizeof(void *) == sizeof(int) */
+	// Terminate the string, also if it was truncated
+	if (out->buf && out->size > 0)
+		out->buf[out->pos < out->size ? out->pos : out->size - 1] = '\0';
+	return out->pos;
+}
 
+/**
+ * Print to the debug port
+ */
 int my_printf(const char *format, ...)
 {
-	register int *varg = (int *)(&format);
-	return print(0, varg);
+	printf_out out = { NULL, 0, 0 };
+	va_list args;
+	int n;
+
+	va_start(args, format);
+	n = print(&out, format, args);
+	va_end(args);
+	return n;
+}
+
+/**
+ * Print into a string. Use my_snprintf, if the length is not known.
+ */
+int sprintf(char *buf, const char *format, ...)
+{
+	printf_out out = { buf, SIZE_MAX, 0 };
+	va_list args;
+	int n;
+
+	va_start(args, format);
+	n = print(&out, format, args);
+	va_end(args);
+	return n;
 }
 
-int sprintf(char *out, const char *format, ...)
+/**
+ * Print into a string of size bytes. The string is always terminated.
+ * Returns the length of the complete output, it was truncated, if it is
+ * size or more.
+ */
+int my_vsnprintf(char *buf, size_t size, const char *format, va_list args)
 {
-	register int *varg = (int *)(&format);
-	return print(&out, varg);
+	printf_out out = { buf, size, 0 };
+
+	return print(&out, format, args);
 }
 
+/**
+ * Print into a string of size bytes, see my_vsnprintf
+ */
+int my_snprintf(char *buf, size_t size, const char *format, ...)
+{
+	va_list args;
+	int n;
+
+	va_start(args, format);
+	n = my_vsnprintf(buf, size, format, args);
+	va_end(args);
+	return n;
+}
+
+/**
+ * Print a fixed point value like "%0*d.%0*d" with the integer and the
+ * fractional part. value is the number multiplied by 10^frac_digits.
+ * The integer part has at least int_digits digits.
+ * sprintf_fixed(s, n, 12345, 4, 3) gives "0012.345"
+ * Returns the length like my_snprintf.
+ */
+int sprintf_fixed(char *buf, size_t size, int32_t value, int int_digits, int frac_digits)
+{
+	char print_buf[PRINT_BUF_LEN];
+	printf_out out = { buf, size, 0 };
+	char *s, *end = print_buf + PRINT_BUF_LEN;
+	uint32_t u;
+	int len;
+
+	if (value < 0)
+		printchar (&out, '-');
+	u = value < 0 ? -(uint32_t) value : (uint32_t) value;
+
+	// The fractional part are the last frac_digits digits
+	if (int_digits < 1)
+		int_digits = 1;
+	if (frac_digits < 0)
+		frac_digits = 0;
+	len = int_digits + frac_digits;
+	if (len > PRINT_BUF_LEN)
+		len = PRINT_BUF_LEN;
+	s = utoa10 (u, end);
+	while (end - s < len)
+		*--s = '0';
+	len = end - s;
+	if (frac_digits > len - 1)
+		frac_digits = len - 1;
+	printn (&out, s, len - frac_digits);
+	if (frac_digits > 0) {
+		printchar (&out, '.');
+		printn (&out, end - frac_digits, frac_digits);
+	}
+
+	if (out.size > 0)
+		buf[out.pos < out.size ? out.pos : out.size - 1] = '\0';
+	return out.pos;
+}
@@ -0,0 +1,176 @@
+/**
+ *  Project     Campos
+ *  @file		profile.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Run time statistics of the main loop stages and interrupts
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  PROFILE_BEGIN() and PROFILE_END() read the CPU cycle counter, so a
+ *  zone is measured with 6ns resolution. Each zone has a count, min, max
+ *  and mean value and a histogram, so rare long runs are also visible.
+ *  PROFILE_END() costs about 50 cycles. The debug console sends the
+ *  statistics with 'Z' in the background, line by line like the other
+ *  dumps, and clears them with 'Y', together with the latency statistics.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "profile.h"
+
+#ifdef PROFILE
+#include "printf.h"
+
+/* global variables ---------------------------------------------------------*/
+uint32_t profile_start[PROFILE_ZONE_IDS];	// Cycle counter at PROFILE_BEGIN()
+
+/* local variables ----------------------------------------------------------*/
+// The statistics are only accessed by the CPU, so they can be in the CCM
+Profile_ZoneTypeDef profile_zones[PROFILE_ZONE_IDS] __attribute__((section(".ccmram")));
+
+#define PROFILE_NAME(id, name)	name,
+static const char * const profile_names[PROFILE_ZONE_IDS] = {
+	PROFILE_ZONES(PROFILE_NAME)
+};
+#undef PROFILE_NAME
+
+/**
+ * @brief  Clear the statistics. The cycle counter must already run,
+ * 		   it is started by TRACE_Init().
+ * @param  None
+ * @retval None
+ */
+void PROFILE_Init(void) {
+	PROFILE_Reset();
+}
+
+/**
+ * @brief  Clear the statistics of all zones
+ * @param  None
+ * @retval None
+ */
+void PROFILE_Reset(void) {
+	Profile_ZoneTypeDef *z;
+	uint32_t primask;
+	int i, b;
+
+	for (i = 0; i < PROFILE_ZONE_IDS; i++) {
+		z = &profile_zones[i];
+		primask = __get_PRIMASK();
+		__disable_irq();
+		z->count = 0;
+		z->min = 0xFFFFFFFF;
+		z->max = 0;
+		z->sum = 0;
+		for (b = 0; b < PROFILE_BUCKETS; b++)
+			z->histogram[b] = 0;
+		__set_PRIMASK(primask);
+	}
+}
+
+/**
+ * @brief  Add a measured duration. Use the PROFILE_END() macro.
+ * 		   It is called from interrupts, but a zone is only measured
+ * 		   in one context.
+ * @param  zone the zone
+ * @param  cycles duration in CPU cycles
+ * @retval None
+ */
+void PROFILE_Add(Profile_ZoneIdTypeDef zone, uint32_t cycles) {
+	Profile_ZoneTypeDef *z = &profile_zones[zone];
+	uint32_t b;
+
+	z->count++;
+	z->sum += cycles;
+	if (cycles < z->min)
+		z->min = cycles;
+	if (cycles > z->max)
+		z->max = cycles;
+
+	// The bucket is the position of the highest bit
+	b = 32 - __CLZ(cycles >> PROFILE_BUCKET_SHIFT);
+	if (b >= PROFILE_BUCKETS)
+		b = PROFILE_BUCKETS - 1;
+	z->histogram[b]++;
+}
+
+/**
+ * @brief  Convert a duration into 1/10 us
+ * @param  cycles duration in CPU cycles
+ * @retval the duration in 1/10 us
+ */
+static uint32_t PROFILE_Us10(uint32_t cycles) {
+	return (uint64_t) cycles * 10 / (SystemCoreClock / 1000000);
+}
+
+/**
+ * @brief  Format a duration in us with 1 decimal place
+ * @param  buf the buffer
+ * @param  size size of buf
+ * @param  cycles duration in CPU cycles
+ * @retval length of the text
+ */
+static int PROFILE_FormatUs(char *buf, int size, uint32_t cycles) {
+	uint32_t us10 = PROFILE_Us10(cycles);
+
+	return my_snprintf(buf, size, " %7u.%u", us10 / 10, us10 % 10);
+}
+
+/**
+ * @brief  Format one line of the statistics for USARTL2_DumpTask().
+ * 		   Line 0 is the heading, then one line per zone with the
+ * 		   values in us and a second line with the histogram buckets
+ * 		   as lower limit:count.
+ * @param  line the line
+ * @param  buf the buffer
+ * @param  size size of buf, at least PROFILE_DUMP_LINE
+ * @retval length of the line, 0 after the last one
+ */
+int PROFILE_DumpLine(int line, char *buf, int size) {
+	Profile_ZoneTypeDef z;
+	uint32_t primask;
+	uint32_t us10;
+	int b, len;
+
+	if (line == 0)
+		return my_snprintf(buf, size, "\r\n%-16s %8s %9s %9s %9s\r\n", "zone",
+				"count", "min us", "mean us", "max us");
+	if (line > PROFILE_ZONE_IDS)
+		return 0;
+
+	// Copy the zone, it may be changed by an interrupt
+	primask = __get_PRIMASK();
+	__disable_irq();
+	z = profile_zones[line - 1];
+	__set_PRIMASK(primask);
+
+	len = my_snprintf(buf, size, "%-16s %8u", profile_names[line - 1], z.count);
+	if (z.count == 0)
+		return len + my_snprintf(buf + len, size - len, "\r\n");
+	len += PROFILE_FormatUs(buf + len, size - len, z.min);
+	len += PROFILE_FormatUs(buf + len, size - len, z.sum / z.count);
+	len += PROFILE_FormatUs(buf + len, size - len, z.max);
+	len += my_snprintf(buf + len, size - len, "\r\n                ");
+	for (b = 0; b < PROFILE_BUCKETS; b++) {
+		if (z.histogram[b] == 0)
+			continue;
+		us10 = PROFILE_Us10(b ? 1 << (b + PROFILE_BUCKET_SHIFT - 1) : 0);
+		len += my_snprintf(buf + len, size - len, " %u.%u:%u", us10 / 10,
+				us10 % 10, z.histogram[b]);
+	}
+	return len + my_snprintf(buf + len, size - len, "\r\n");
+}
+
+#endif /* PROFILE */
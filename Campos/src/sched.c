@@ -0,0 +1,255 @@
+/**
+ *  Project     Campos
+ *  @file		sched.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Event driven scheduler of the main loop
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The interrupts post events, each event starts its task. There is one
+ *  queue per priority, the oldest event of the highest priority is taken
+ *  next. A task is not interrupted by another task, so a task with a
+ *  high priority waits at most until the running task has finished.
+ *  Long tasks, like the LCD update, have a low priority.
+ *  If no event is queued, the CPU sleeps until the next interrupt.
+ *
+ *  The statistics show the delay from the event to the start of the task
+ *  and its jitter, the run time and the missed deadlines. The debug
+ *  console prints them with 'T' and clears them with 'Y'.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "sched.h"
+#include "timebase.h"
+#include "printf.h"
+
+/* local variables ----------------------------------------------------------*/
+Sched_TaskTypeDef sched_tasks[SCHED_EVENTS];
+
+// One queue of events per priority
+uint8_t sched_queue[SCHED_PRIORITIES][SCHED_QUEUE_SIZE];
+uint32_t sched_queue_rd[SCHED_PRIORITIES];
+uint32_t sched_queue_wr[SCHED_PRIORITIES];
+
+uint32_t sched_start_us;	// Start of the statistics
+uint32_t sched_idle_us;		// Time in sleep mode
+
+/**
+ * @brief  Clear the queues and the tasks. Events posted before their
+ * 		   task is registered are ignored.
+ * @param  None
+ * @retval None
+ */
+void SCHED_Init(void) {
+	int i;
+
+	__disable_irq();
+	for (i = 0; i < SCHED_EVENTS; i++) {
+		sched_tasks[i].name = "";
+		sched_tasks[i].task = 0;
+		sched_tasks[i].pending = 0;
+	}
+	for (i = 0; i < SCHED_PRIORITIES; i++) {
+		sched_queue_rd[i] = 0;
+		sched_queue_wr[i] = 0;
+	}
+	__enable_irq();
+	SCHED_Reset();
+}
+
+/**
+ * @brief  Register the task of an event
+ * @param  event the event
+ * @param  name name for the statistics
+ * @param  task the task
+ * @param  priority 0 (highest) .. SCHED_PRIORITIES - 1
+ * @param  deadline_us maximum time from the event to the end of the task
+ * @retval None
+ */
+void SCHED_Register(Sched_EventTypeDef event, const char *name,
+		void (*task)(void), uint8_t priority, uint32_t deadline_us) {
+	Sched_TaskTypeDef *t = &sched_tasks[event];
+
+	if (priority >= SCHED_PRIORITIES)
+		priority = SCHED_PRIORITIES - 1;
+	__disable_irq();
+	t->name = name;
+	t->priority = priority;
+	t->deadline_us = deadline_us;
+	t->task = task;
+	__enable_irq();
+}
+
+/**
+ * @brief  Post an event. It is only queued once, an event that is
+ * 		   posted again before its task started counts as overrun.
+ * 		   It may be called from interrupts.
+ * @param  event the event
+ * @retval None
+ */
+void SCHED_Post(Sched_EventTypeDef event) {
+	Sched_TaskTypeDef *t = &sched_tasks[event];
+	uint32_t primask;
+	int p;
+
+	// Restore the interrupt state, it may be called with disabled interrupts
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (t->task) {
+		t->posts++;
+		if (t->pending) {
+			t->overruns++;
+		} else {
+			t->pending = 1;
+			t->post_us = TIMEBASE_Us();
+			p = t->priority;
+			sched_queue[p][sched_queue_wr[p] & SCHED_QUEUE_MASK] = event;
+			sched_queue_wr[p]++;
+		}
+	}
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief  Take the next event out of the queues.
+ * 		   Must be called with disabled interrupts.
+ * @param  None
+ * @retval the event, or -1 if all queues are empty
+ */
+static int SCHED_Next(void) {
+	int p, event;
+
+	for (p = 0; p < SCHED_PRIORITIES; p++) {
+		if (sched_queue_rd[p] != sched_queue_wr[p]) {
+			event = sched_queue[p][sched_queue_rd[p] & SCHED_QUEUE_MASK];
+			sched_queue_rd[p]++;
+			return event;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief  Run the task of an event and update its statistics
+ * @param  t the task
+ * @retval None
+ */
+static void SCHED_Dispatch(Sched_TaskTypeDef *t) {
+	uint32_t post_us, start_us, end_us, delay;
+
+	// The event may be posted again, while the task runs
+	post_us = t->post_us;
+	t->pending = 0;
+
+	start_us = TIMEBASE_Us();
+	t->task();
+	end_us = TIMEBASE_Us();
+
+	delay = start_us - post_us;
+	t->runs++;
+	t->delay_sum += delay;
+	if (delay < t->delay_min)
+		t->delay_min = delay;
+	if (delay > t->delay_max)
+		t->delay_max = delay;
+	if (end_us - start_us > t->run_max)
+		t->run_max = end_us - start_us;
+	if (end_us - post_us > t->deadline_us)
+		t->misses++;
+}
+
+/**
+ * @brief  The main loop: run the tasks in the order of their priority,
+ * 		   sleep if there is nothing to do. It never returns.
+ * @param  None
+ * @retval None
+ */
+void SCHED_Run(void) {
+	uint32_t sleep_us;
+	int event;
+
+	while (1) {
+		__disable_irq();
+		event = SCHED_Next();
+		if (event < 0) {
+			// WFI also wakes up with disabled interrupts. So an event
+			// that is posted after the queues were checked is not missed.
+			sleep_us = TIMEBASE_Us();
+			__WFI();
+			sched_idle_us += TIMEBASE_Us() - sleep_us;
+			__enable_irq();
+			continue;
+		}
+		__enable_irq();
+		SCHED_Dispatch(&sched_tasks[event]);
+	}
+}
+
+/**
+ * @brief  Clear the statistics
+ * @param  None
+ * @retval None
+ */
+void SCHED_Reset(void) {
+	Sched_TaskTypeDef *t;
+	int i;
+
+	__disable_irq();
+	for (i = 0; i < SCHED_EVENTS; i++) {
+		t = &sched_tasks[i];
+		t->posts = 0;
+		t->overruns = 0;
+		t->runs = 0;
+		t->misses = 0;
+		t->delay_min = 0xFFFFFFFF;
+		t->delay_max = 0;
+		t->delay_sum = 0;
+		t->run_max = 0;
+	}
+	sched_start_us = TIMEBASE_Us();
+	sched_idle_us = 0;
+	__enable_irq();
+}
+
+/**
+ * @brief  Print the statistics to the debug port. The times are in us.
+ * @param  None
+ * @retval None
+ */
+void SCHED_Print(void) {
+	Sched_TaskTypeDef *t;
+	uint32_t total;
+	int i;
+
+	total = TIMEBASE_Us() - sched_start_us;
+	my_printf("CPU load %u%%\r\n", total ?
+			(uint32_t)(100 - (uint64_t) sched_idle_us * 100 / total) : 0);
+	my_printf("%-10s %4s %8s %8s %8s %6s %6s %6s %6s %6s %8s\r\n", "task",
+			"prio", "deadline", "events", "overrun", "missed", "delay",
+			"mean", "max", "jitter", "run max");
+	for (i = 0; i < SCHED_EVENTS; i++) {
+		t = &sched_tasks[i];
+		if (!t->task)
+			continue;
+		my_printf("%-10s %4u %8u %8u %8u %6u", t->name, t->priority,
+				t->deadline_us, t->posts, t->overruns, t->misses);
+		if (t->runs > 0)
+			my_printf(" %6u %6u %6u %6u %8u", t->delay_min,
+					(uint32_t)(t->delay_sum / t->runs), t->delay_max,
+					t->delay_max - t->delay_min, t->run_max);
+		my_printf("\r\n");
+	}
+}
@@ -63,6 +63,9 @@
 #include "stm32f4xx_it.h"
 #include "usartl1.h"
 #include "irlink.h"
+#include "trace.h"
+#include "profile.h"
+#include "sched.h"
 
 
 extern int mytick;
@@ -167,18 +170,16 @@ void PendSV_Handler(void) {
  * @retval None
  */
 void SysTick_Handler(void) {
-	static int cnt1ms = 0;
-	IRLINK_500usTask();
-	cnt1ms++;
-
-	// Generate a 1ms Task
-	if (cnt1ms >= 2) {
-		cnt1ms = 0;
-
-		HAL_IncTick();
-		mytick ++;
+	PROFILE_BEGIN(PROFILE_IRQ_SYSTICK);
+	HAL_IncTick();
+	SCHED_Post(SCHED_BACKGROUND);
+	if (++mytick >= 200) {
+		mytick = 0;
+		SCHED_Post(SCHED_TICK);
 	}
-
+	if ((HAL_GetTick() % TRACE_TICK_MS) == 0)
+		TRACE(TRACE_TICK, HAL_GetTick(), 0);
+	PROFILE_END(PROFILE_IRQ_SYSTICK);
 }
 /**
  * @brief  DMA interrupt handler.
@@ -186,7 +187,20 @@ void SysTick_Handler(void) {
  * @retval None
  */
 void DMA2_Stream1_IRQHandler(void) {
+	PROFILE_BEGIN(PROFILE_IRQ_CAMERA_DMA);
 	BSP_CAMERA_DMA_IRQHandler();
+	PROFILE_END(PROFILE_IRQ_CAMERA_DMA);
+}
+
+/**
+ * @brief  DMA interrupt handler of the IR link.
+ * @param  None
+ * @retval None
+ */
+void DMA1_Stream1_IRQHandler(void) {
+	PROFILE_BEGIN(PROFILE_IRQ_IRLINK_DMA);
+	IRLINK_DMA_IRQHandler();
+	PROFILE_END(PROFILE_IRQ_IRLINK_DMA);
 }
 
 /**
@@ -195,7 +209,9 @@ void DMA2_Stream1_IRQHandler(void) {
  * @retval None
  */
 void DCMI_IRQHandler(void) {
+	PROFILE_BEGIN(PROFILE_IRQ_DCMI);
 	BSP_CAMERA_IRQHandler();
+	PROFILE_END(PROFILE_IRQ_DCMI);
 }
 /******************************************************************************/
 /*                 STM32F4xx Peripherals Interrupt Handlers                   */
@@ -209,7 +225,20 @@ void DCMI_IRQHandler(void) {
  * @retval None
  */
 void USARTx_IRQHandler(void) {
+	PROFILE_BEGIN(PROFILE_IRQ_USART);
 	USARTL1_IRQHandler(&UartHandle);
+	PROFILE_END(PROFILE_IRQ_USART);
+}
+
+/**
+ * @brief  This function handles the UART transmit DMA interrupt request.
+ * @param  None
+ * @retval None
+ */
+void USARTx_DMA_TX_IRQHandler(void) {
+	PROFILE_BEGIN(PROFILE_IRQ_USART_DMA);
+	USARTL1_DMA_TX_IRQHandler();
+	PROFILE_END(PROFILE_IRQ_USART_DMA);
 }
 
 /**
@@ -0,0 +1,412 @@
+/**
+ *  Project     Campos
+ *  @file		stream.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Binary packets on the debug port
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The packets are COBS coded and protected by a CRC-16. This module does
+ *  not use the HAL, so the host tools use it, too.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <string.h>
+#include "stream.h"
+#include "crc.h"
+
+/* local variables ----------------------------------------------------------*/
+
+// Packet before the COBS coding: type, payload and CRC
+static uint8_t stream_raw[1 + STREAM_MAX_PAYLOAD + 2];
+// Payload of a frame packet
+static uint8_t stream_payload[STREAM_MAX_PAYLOAD];
+
+/**
+ * @brief  Write a 16 bit value little endian
+ */
+static void STREAM_Put16(uint8_t *p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+/**
+ * @brief  Write a 32 bit value little endian
+ */
+static void STREAM_Put32(uint8_t *p, uint32_t v) {
+	STREAM_Put16(p, v & 0xFFFF);
+	STREAM_Put16(p + 2, v >> 16);
+}
+
+/**
+ * @brief  Read a 16 bit value little endian
+ */
+static uint16_t STREAM_Get16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * @brief  Read a 32 bit value little endian
+ */
+static uint32_t STREAM_Get32(const uint8_t *p) {
+	return STREAM_Get16(p) | ((uint32_t) STREAM_Get16(p + 2) << 16);
+}
+
+/**
+ * @brief  Build a packet: add type and CRC, COBS code it and add the
+ * 		   delimiters.
+ * @param  type the packet type STREAM_TYPE_xx
+ * @param  payload the payload
+ * @param  n length of the payload, max. STREAM_MAX_PAYLOAD
+ * @param  packet output, STREAM_MAX_PACKET bytes
+ * @retval Number of bytes to send or 0, if the payload is too long
+ */
+int STREAM_Pack(uint8_t type, const uint8_t *payload, int n, uint8_t *packet) {
+	int len;
+
+	if (n > STREAM_MAX_PAYLOAD)
+		return 0;
+
+	stream_raw[0] = type;
+	memcpy(&stream_raw[1], payload, n);
+	STREAM_Put16(&stream_raw[1 + n], CRC_Crc16Bytes(CRC16_INIT, stream_raw, 1 + n));
+
+	packet[0] = COBS_DELIMITER;
+	len = COBS_Encode(stream_raw, 1 + n + 2, &packet[1]);
+	packet[1 + len] = COBS_DELIMITER;
+
+	return len + 2;
+}
+
+/**
+ * @brief  Check and decode a received packet
+ * @param  coded the bytes between two delimiters
+ * @param  n number of bytes
+ * @param  type the packet type STREAM_TYPE_xx
+ * @param  payload output
+ * @param  max size of the output buffer
+ * @retval Length of the payload or Stream_ResultTypeDef error code
+ */
+int STREAM_Unpack(const uint8_t *coded, int n, uint8_t *type,
+		uint8_t *payload, int max) {
+	int len;
+
+	len = COBS_Decode(coded, n, stream_raw, sizeof(stream_raw));
+	if (len < 0)
+		return STREAM_ERR_COBS;
+	if (len < 3)
+		return STREAM_ERR_SHORT;
+	if (CRC_Crc16Bytes(CRC16_INIT, stream_raw, len - 2)
+			!= STREAM_Get16(&stream_raw[len - 2]))
+		return STREAM_ERR_CRC;
+
+	len -= 3;
+	if (len > max)
+		return STREAM_ERR_FORMAT;
+	*type = stream_raw[0];
+	memcpy(payload, &stream_raw[1], len);
+
+	return len;
+}
+
+/**
+ * @brief  Difference coding of pixels with 4 bit per pixel
+ * @param  pixels the pixels
+ * @param  n number of pixels
+ * @param  out output
+ * @param  max size of the output buffer
+ * @retval Number of bytes or -1, if it does not fit into the buffer
+ */
+int STREAM_DeltaEncode(const uint8_t *pixels, int n, uint8_t *out, int max) {
+	int i, d, nibbles = 0;
+	uint8_t prev = 0;
+
+	// Put one nibble, high nibble first
+#define STREAM_PUT_NIBBLE(v) do { \
+		if (nibbles >= max * 2) \
+			return -1; \
+		if (nibbles & 1) \
+			out[nibbles >> 1] |= (v); \
+		else \
+			out[nibbles >> 1] = (v) << 4; \
+		nibbles++; \
+	} while (0)
+
+	for (i = 0; i < n; i++) {
+		d = pixels[i] - prev;
+		if ((d >= -7) && (d <= 7)) {
+			STREAM_PUT_NIBBLE(d & 0x0F);
+		} else {
+			STREAM_PUT_NIBBLE(STREAM_DELTA_ESCAPE);
+			STREAM_PUT_NIBBLE(pixels[i] >> 4);
+			STREAM_PUT_NIBBLE(pixels[i] & 0x0F);
+		}
+		prev = pixels[i];
+	}
+#undef STREAM_PUT_NIBBLE
+
+	return (nibbles + 1) >> 1;
+}
+
+/**
+ * @brief  Decode difference coded pixels
+ * @param  data the coded data
+ * @param  len number of bytes
+ * @param  pixels output
+ * @param  n number of pixels
+ * @retval 0 or -1, if the data is too short
+ */
+int STREAM_DeltaDecode(const uint8_t *data, int len, uint8_t *pixels, int n) {
+	int i, v, nibbles = 0;
+	uint8_t prev = 0;
+
+	// Get one nibble, high nibble first
+#define STREAM_GET_NIBBLE(v) do { \
+		if (nibbles >= len * 2) \
+			return -1; \
+		v = (nibbles & 1) ? (data[nibbles >> 1] & 0x0F) : (data[nibbles >> 1] >> 4); \
+		nibbles++; \
+	} while (0)
+
+	for (i = 0; i < n; i++) {
+		STREAM_GET_NIBBLE(v);
+		if (v == STREAM_DELTA_ESCAPE) {
+			STREAM_GET_NIBBLE(v);
+			prev = v << 4;
+			STREAM_GET_NIBBLE(v);
+			prev |= v;
+		} else {
+			// Sign extension of the 4 bit difference
+			prev += (v & 0x08) ? v - 16 : v;
+		}
+		pixels[i] = prev;
+	}
+#undef STREAM_GET_NIBBLE
+
+	return 0;
+}
+
+/**
+ * @brief  Build a frame packet.
+ * 		   If the difference coding is requested, but the coded pixels
+ * 		   are longer than the raw ones, the pixels are sent uncoded and
+ * 		   the flag in the chunk is cleared.
+ * @param  chunk frame information and the part of the frame
+ * @param  pixels the first pixel of the part
+ * @param  packet output, STREAM_MAX_PACKET bytes
+ * @retval Number of bytes to send
+ */
+int STREAM_EncodeChunk(Stream_ChunkTypeDef *chunk, const uint8_t *pixels,
+		uint8_t *packet) {
+	uint8_t *p = stream_payload;
+	int len = -1;
+
+	if (chunk->count > STREAM_CHUNK_PIXELS)
+		chunk->count = STREAM_CHUNK_PIXELS;
+
+	if (chunk->flags & STREAM_FLAG_DELTA)
+		len = STREAM_DeltaEncode(pixels, chunk->count,
+				&stream_payload[STREAM_FRAME_HEADER], chunk->count);
+	if (len < 0) {
+		chunk->flags &= ~STREAM_FLAG_DELTA;
+		len = chunk->count;
+		memcpy(&stream_payload[STREAM_FRAME_HEADER], pixels, len);
+	}
+
+	*p++ = chunk->flags;
+	STREAM_Put16(p, chunk->frame.frame);
+	p[2] = chunk->frame.size;
+	p[3] = chunk->frame.tile;
+	STREAM_Put16(p + 4, chunk->frame.width);
+	STREAM_Put16(p + 6, chunk->frame.height);
+	STREAM_Put16(p + 8, chunk->frame.x);
+	STREAM_Put16(p + 10, chunk->frame.y);
+	STREAM_Put32(p + 12, chunk->frame.exposure);
+	STREAM_Put32(p + 16, chunk->frame.timestamp);
+	STREAM_Put32(p + 20, chunk->offset);
+	STREAM_Put16(p + 24, chunk->count);
+
+	return STREAM_Pack(STREAM_TYPE_FRAME, stream_payload,
+			STREAM_FRAME_HEADER + len, packet);
+}
+
+/**
+ * @brief  Decode the payload of a frame packet
+ * @param  chunk output: frame information and the part of the frame
+ * @param  payload the payload from STREAM_Unpack()
+ * @param  n length of the payload
+ * @param  pixels output, STREAM_CHUNK_PIXELS bytes
+ * @retval STREAM_OK or an error code
+ */
+Stream_ResultTypeDef STREAM_DecodeChunk(Stream_ChunkTypeDef *chunk,
+		const uint8_t *payload, int n, uint8_t *pixels) {
+	const uint8_t *p = payload;
+
+	if (n < STREAM_FRAME_HEADER)
+		return STREAM_ERR_SHORT;
+
+	chunk->flags = *p++;
+	chunk->frame.frame = STREAM_Get16(p);
+	chunk->frame.size = p[2];
+	chunk->frame.tile = p[3];
+	chunk->frame.width = STREAM_Get16(p + 4);
+	chunk->frame.height = STREAM_Get16(p + 6);
+	chunk->frame.x = STREAM_Get16(p + 8);
+	chunk->frame.y = STREAM_Get16(p + 10);
+	chunk->frame.exposure = STREAM_Get32(p + 12);
+	chunk->frame.timestamp = STREAM_Get32(p + 16);
+	chunk->offset = STREAM_Get32(p + 20);
+	chunk->count = STREAM_Get16(p + 24);
+
+	if (chunk->count > STREAM_CHUNK_PIXELS)
+		return STREAM_ERR_FORMAT;
+
+	payload += STREAM_FRAME_HEADER;
+	n -= STREAM_FRAME_HEADER;
+	if (chunk->flags & STREAM_FLAG_DELTA) {
+		if (STREAM_DeltaDecode(payload, n, pixels, chunk->count) != 0)
+			return STREAM_ERR_FORMAT;
+	} else {
+		if (n != chunk->count)
+			return STREAM_ERR_FORMAT;
+		memcpy(pixels, payload, n);
+	}
+
+	return STREAM_OK;
+}
+
+/**
+ * @brief  Build a telemetry packet
+ * @param  t the telemetry data of one frame
+ * @param  packet output, STREAM_MAX_PACKET bytes
+ * @retval Number of bytes to send
+ */
+int STREAM_EncodeTelemetry(const Stream_TelemetryTypeDef *t, uint8_t *packet) {
+	uint8_t *p = stream_payload;
+
+	STREAM_Put16(p, t->frame);
+	STREAM_Put32(p + 2, t->timestamp);
+	p[6] = t->status;
+	STREAM_Put16(p + 7, t->x);
+	STREAM_Put16(p + 9, t->subx);
+	STREAM_Put16(p + 11, t->y);
+	STREAM_Put16(p + 13, t->suby);
+	STREAM_Put32(p + 15, t->intensity);
+	STREAM_Put32(p + 19, t->exposure);
+	STREAM_Put32(p + 23, t->process_us);
+	STREAM_Put32(p + 27, t->frames_dropped);
+	STREAM_Put32(p + 31, t->telemetry_dropped);
+	STREAM_Put32(p + 35, t->uart_dropped);
+	STREAM_Put32(p + 39, t->ir_dropped);
+
+	return STREAM_Pack(STREAM_TYPE_TELEMETRY, stream_payload,
+			STREAM_TELEMETRY_SIZE, packet);
+}
+
+/**
+ * @brief  Decode the payload of a telemetry packet
+ * @param  t output: the telemetry data of one frame
+ * @param  payload the payload from STREAM_Unpack()
+ * @param  n length of the payload
+ * @retval STREAM_OK or an error code
+ */
+Stream_ResultTypeDef STREAM_DecodeTelemetry(Stream_TelemetryTypeDef *t,
+		const uint8_t *payload, int n) {
+	const uint8_t *p = payload;
+
+	if (n != STREAM_TELEMETRY_SIZE)
+		return STREAM_ERR_FORMAT;
+
+	t->frame = STREAM_Get16(p);
+	t->timestamp = STREAM_Get32(p + 2);
+	t->status = p[6];
+	t->x = STREAM_Get16(p + 7);
+	t->subx = STREAM_Get16(p + 9);
+	t->y = STREAM_Get16(p + 11);
+	t->suby = STREAM_Get16(p + 13);
+	t->intensity = STREAM_Get32(p + 15);
+	t->exposure = STREAM_Get32(p + 19);
+	t->process_us = STREAM_Get32(p + 23);
+	t->frames_dropped = STREAM_Get32(p + 27);
+	t->telemetry_dropped = STREAM_Get32(p + 31);
+	t->uart_dropped = STREAM_Get32(p + 35);
+	t->ir_dropped = STREAM_Get32(p + 39);
+
+	return STREAM_OK;
+}
+
+/**
+ * @brief  Build a trace packet
+ * @param  events the trace events
+ * @param  count number of events, max. STREAM_TRACE_EVENTS
+ * @param  dropped events that were dropped since the start of the trace
+ * @param  packet output, STREAM_MAX_PACKET bytes
+ * @retval Number of bytes to send
+ */
+int STREAM_EncodeTrace(const Stream_TraceEventTypeDef *events, int count,
+		uint32_t dropped, uint8_t *packet) {
+	uint8_t *p = stream_payload;
+	int i;
+
+	if (count > STREAM_TRACE_EVENTS)
+		count = STREAM_TRACE_EVENTS;
+
+	STREAM_Put32(p, dropped);
+	p += STREAM_TRACE_HEADER;
+	for (i = 0; i < count; i++) {
+		STREAM_Put32(p, events[i].cycles);
+		STREAM_Put16(p + 4, events[i].id);
+		STREAM_Put32(p + 6, events[i].arg[0]);
+		STREAM_Put32(p + 10, events[i].arg[1]);
+		p += STREAM_TRACE_EVENT;
+	}
+
+	return STREAM_Pack(STREAM_TYPE_TRACE, stream_payload,
+			STREAM_TRACE_HEADER + count * STREAM_TRACE_EVENT, packet);
+}
+
+/**
+ * @brief  Decode the payload of a trace packet
+ * @param  events output: the trace events
+ * @param  max size of the events array
+ * @param  dropped output: events dropped since the start of the trace
+ * @param  payload the payload from STREAM_Unpack()
+ * @param  n length of the payload
+ * @retval Number of events or STREAM_ERR_FORMAT
+ */
+int STREAM_DecodeTrace(Stream_TraceEventTypeDef *events, int max,
+		uint32_t *dropped, const uint8_t *payload, int n) {
+	const uint8_t *p = payload + STREAM_TRACE_HEADER;
+	int i, count;
+
+	if ((n < STREAM_TRACE_HEADER)
+			|| ((n - STREAM_TRACE_HEADER) % STREAM_TRACE_EVENT) != 0)
+		return STREAM_ERR_FORMAT;
+	count = (n - STREAM_TRACE_HEADER) / STREAM_TRACE_EVENT;
+	if (count > max)
+		return STREAM_ERR_FORMAT;
+
+	*dropped = STREAM_Get32(payload);
+	for (i = 0; i < count; i++) {
+		events[i].cycles = STREAM_Get32(p);
+		events[i].id = STREAM_Get16(p + 4);
+		events[i].arg[0] = STREAM_Get32(p + 6);
+		events[i].arg[1] = STREAM_Get32(p + 10);
+		p += STREAM_TRACE_EVENT;
+	}
+
+	return count;
+}
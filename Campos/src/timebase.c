@@ -0,0 +1,44 @@
+/**
+ *  Project     Campos
+ *  @file		timebase.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Free running microsecond time base for time stamps
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "timebase.h"
+
+/* local variables ----------------------------------------------------------*/
+TIM_HandleTypeDef htim5;
+
+/**
+ * @brief  Start the free running us timer
+ * @param  None
+ * @retval None
+ */
+void TIMEBASE_Init(void) {
+	__TIM5_CLK_ENABLE();
+	htim5.Instance = TIMEBASE_TIM;
+	htim5.Init.Period = 0xFFFFFFFF;
+	htim5.Init.Prescaler = TIMEBASE_PRESCALER - 1;
+	htim5.Init.ClockDivision = 0;
+	htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+	HAL_TIM_Base_Init(&htim5);
+	HAL_TIM_Base_Start(&htim5);
+}
@@ -0,0 +1,135 @@
+/**
+ *  Project     Campos
+ *  @file		trace.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Binary trace log with deferred formatting
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  An event is only the message id, 2 arguments and the CPU cycle counter.
+ *  It is written into a ring buffer, also from interrupts. The main loop
+ *  sends the events as trace packets, if there is space in the transmit
+ *  buffer. The host tool tracedump formats the texts.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "trace.h"
+#include "stm32f4xx_hal.h"
+#include "usartl1.h"
+
+/* local variables ----------------------------------------------------------*/
+volatile int trace_on = 0;
+uint32_t trace_dropped = 0;
+volatile uint32_t trace_wr = 0;	// Next free event, only incremented
+volatile uint32_t trace_rd = 0;	// Oldest event that was not sent
+uint32_t trace_flush_tick;		// Time of the last packet
+
+// The ring buffer is only accessed by the CPU, so it can be in the CCM
+Stream_TraceEventTypeDef trace_events[TRACE_SIZE] __attribute__((section(".ccmram")));
+uint8_t trace_packet[STREAM_MAX_PACKET];
+
+/**
+ * @brief  Enable the cycle counter of the DWT for the time stamps
+ * @param  None
+ * @retval None
+ */
+void TRACE_Init(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief  Start or stop the trace. Starting clears the ring buffer.
+ * @param  on 1 to start the trace
+ * @retval None
+ */
+void TRACE_SetOn(int on) {
+	trace_on = 0;
+	if (on) {
+		trace_rd = trace_wr;
+		trace_dropped = 0;
+		trace_flush_tick = HAL_GetTick();
+		trace_on = 1;
+		TRACE(TRACE_START, HAL_GetTick(), 0);
+	}
+}
+
+/**
+ * @brief  Record an event. Use the TRACE() macro, it does not call this
+ * 		   function, if the trace is off.
+ * 		   It may be called from interrupts.
+ * @param  id the message id
+ * @param  a first argument of the message
+ * @param  b second argument of the message
+ * @retval None
+ */
+void TRACE_Event(Trace_IdTypeDef id, uint32_t a, uint32_t b) {
+	Stream_TraceEventTypeDef *e;
+	uint32_t primask;
+
+	// Restore the interrupt state, it may be called with disabled interrupts
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (trace_wr - trace_rd >= TRACE_SIZE) {
+		trace_dropped++;
+	} else {
+		e = &trace_events[trace_wr & TRACE_MASK];
+		e->cycles = DWT->CYCCNT;
+		e->id = id;
+		e->arg[0] = a;
+		e->arg[1] = b;
+		trace_wr++;
+	}
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief  Cyclic task. Sends the events, if a packet is full or the
+ * 		   events are waiting for TRACE_FLUSH_MS. A packet is only written,
+ * 		   if it fits completely into the transmit buffer.
+ * @param  None
+ * @retval None
+ */
+void TRACE_Task(void) {
+	uint32_t rd, count;
+	int len;
+
+	if (!trace_on || USARTL2_TxPaused())
+		return;
+
+	while (USARTL1_TxFree() >= STREAM_MAX_PACKET) {
+		rd = trace_rd;
+		count = trace_wr - rd;
+		if (count == 0)
+			return;
+		if ((count < STREAM_TRACE_EVENTS)
+				&& (HAL_GetTick() - trace_flush_tick < TRACE_FLUSH_MS))
+			return;
+
+		// Only the events up to the end of the ring buffer
+		if (count > STREAM_TRACE_EVENTS)
+			count = STREAM_TRACE_EVENTS;
+		if (count > TRACE_SIZE - (rd & TRACE_MASK))
+			count = TRACE_SIZE - (rd & TRACE_MASK);
+
+		len = STREAM_EncodeTrace(&trace_events[rd & TRACE_MASK], count,
+				trace_dropped, trace_packet);
+		USARTL1_Write(trace_packet, len);
+		trace_rd = rd + count;
+		trace_flush_tick = HAL_GetTick();
+	}
+}
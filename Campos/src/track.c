@@ -25,6 +25,7 @@
 #include "track.h"
 #include "camera.h"
 #include "irlink.h"
+#include "history.h"
 
 /* global variables ---------------------------------------------------------*/
 int position_x = 0; 	// position in sensor pixels
@@ -36,6 +37,13 @@ int position_suby = 0; 	// sub pixel position from 0..999
 int intensity = 0; 		// intensity (integral of all pixel values)
 Track_StatusTypeDef track_status = TRACK_INIT; // Status of tracking
 
+// Tuning parameters, they are changed by the parameter registry
+int track_pixel_min = TRACK_PIXEL_MIN;
+int track_search_min = TRACK_SEARCH_MIN;
+int track_intensity_min = TRACK_INTENSITY_MIN;
+int track_lost_frames = TRACK_LOST_FRAMES;
+int track_window_step = TRACK_WINDOW_STEP;
+
 /* local variables ----------------------------------------------------------*/
 uint16_t intensity_x[32];
 uint16_t intensity_y[32];
@@ -50,6 +58,7 @@ int maxx,maxy,max;
  */
 void TRACK_Init(void) {
 	track_status = TRACK_INIT;
+	HISTORY_Init();
 }
 
 /**
@@ -64,6 +73,10 @@ void TRACK_Search(void) {
 	int x, y, v;
 	int maxx_start,maxy_start,maxx_end,maxy_end;
 
+	// Local copies of the parameters for the pixel loops
+	int pixel_min = track_pixel_min;
+	int step = track_window_step;
+
 	if (track_status == TRACK_INIT) {
 
 		// Reset position to 0
@@ -97,19 +110,19 @@ void TRACK_Search(void) {
 		// A light point was found when the complete camera field was scanned
 		if ((window_x == 2) && (window_y == 17)) {
 //			if (0) {
-			if (max > 128) {
+			if (max > track_search_min) {
 				position_x = maxx;
 				position_y = maxy;
 				intensity  = max;
 
 				// Zoom in to search the whole camera area
 				BSP_CAMERA_SetSize(CAMERA_ZOOMED);
-				x = position_x / 60 * 60 - 30;
+				x = position_x / step * step - step / 2;
 				if (x<0)
 					x = 0;
 				if (x > (2592-120))
 					x = (2592-120);
-				y = position_y / 60 * 60 - 30;
+				y = position_y / step * step - step / 2;
 				if (y<0)
 					y = 0;
 				if (y > (1944-120))
@@ -159,14 +172,14 @@ void TRACK_Search(void) {
 				intensity_x[x] = 0;
 				for (y = 0; y < 32; y++) {
 					v = pixels.zoomed[position_inty+y-16][position_intx+x-16];
-					if (v > 40) {
+					if (v > pixel_min) {
 						intensity_x[x] += v;
 						integral += v;
 					}
 				}
 			}
 
-			if (integral >= 2000) {
+			if (integral >= track_intensity_min) {
 				integral_l = 0;
 				maxx = 16;
 				for (x = 0; x < 32; x++) {
@@ -198,7 +211,7 @@ void TRACK_Search(void) {
 					intensity_y[y] = 0;
 					for (x = 0; x < 32; x++) {
 						v = pixels.zoomed[position_inty+y-16][position_intx+x-16];
-						if (v > 40) {
+						if (v > pixel_min) {
 							intensity_y[y] += v;
 							integral += v;
 						}
@@ -232,12 +245,12 @@ void TRACK_Search(void) {
 				position_y = position_inty + offset_window_y;
 
 				// Check, whether the window has to move
-				x = position_x / 60 * 60 - 30;
+				x = position_x / step * step - step / 2;
 				if (x<0)
 					x = 0;
 				if (x > (2592-120))
 					x = (2592-120);
-				y = position_y / 60 * 60 - 30;
+				y = position_y / step * step - step / 2;
 				if (y<0)
 					y = 0;
 				if (y > (1944-120))
@@ -252,11 +265,11 @@ void TRACK_Search(void) {
 			}
 		}
 		intensity = integral;
-		if (intensity < 2000 ) {
+		if (intensity < track_intensity_min) {
 			lost_cnt ++;
 			track_status = TRACK_LOST;
-			// Timeout of 50 frames = about 5sec
-			if (lost_cnt>50) {
+			// Timeout, 50 frames = about 5sec
+			if (lost_cnt > track_lost_frames) {
 				track_status = TRACK_INIT;
 			}
 		} else {
@@ -265,5 +278,9 @@ void TRACK_Search(void) {
 		}
 
 	}
+
+	// Remember the position for the trail and the debug port
+	HISTORY_Add(track_status, position_x, position_subx, position_y,
+			position_suby, intensity);
 }
 
@@ -22,29 +22,44 @@
  */
 
 /* Includes -----------------------------------------------------------------*/
+#include <string.h>
 #include "usartl1.h"
 #include "main.h"
+#include "command.h"
+#include "sched.h"
 
 /* local functions ----------------------------------------------------------*/
-static void USARTL1_Transmit(UART_HandleTypeDef *huart);
-static void USARTL1_Receive(UART_HandleTypeDef *huart);
+static void USARTL1_StartTx(void);
+static void USARTL1_TxComplete(DMA_HandleTypeDef *hdma);
 
 /* local variables ----------------------------------------------------------*/
 UART_HandleTypeDef UartHandle;
+DMA_HandleTypeDef hdma_usartl1_tx;
+DMA_HandleTypeDef hdma_usartl1_rx;
 
-// Transmit buffer with read and write pointer
+// Transmit buffer with read and write pointer.
+// The write pointer is the next free byte, the read pointer the first byte
+// that was not yet sent. Bytes from rd to rd+len are in the DMA.
 uint8_t USARTL1_tx_buffer[USARTL1_TX_SIZE];
-uint8_t USARTL1_txen = 0;
-uint16_t USARTL1_tx_wr_pointer = 0;
-uint16_t USARTL1_tx_rd_pointer = 0;
-
-// Receive buffer with read and write pointer
+volatile uint16_t USARTL1_tx_wr_pointer = 0;
+volatile uint16_t USARTL1_tx_rd_pointer = 0;
+volatile uint16_t USARTL1_tx_len = 0;
+uint32_t USARTL1_baudrate_pending = 0;	// New baud rate, after all is sent
+uint32_t USARTL1_tx_dropped = 0;	// Bytes that did not fit into the buffer
+
+// Receive buffer with read and write pointer.
+// The circular DMA writes into the buffer, the write pointer is taken
+// from the DMA counter.
 uint8_t USARTL1_rx_buffer[USARTL1_RX_SIZE];
-int USARTL1_rx_wr_pointer = 0;
+volatile int USARTL1_rx_wr_pointer = 0;
 int USARTL1_rx_rd_pointer = 0;
+volatile uint32_t USARTL1_rx_idle = 0;	// Number of idle line events
 
 /**
  * @brief  Initialize the USART
+ * 		   The receiver writes with a circular DMA into the receive buffer,
+ * 		   the transmitter sends the transmit buffer with a DMA.
+ * 		   DMA1 stream 5 channel 4 is USART2_RX, stream 6 channel 4 USART2_TX
  * @param  None
  * @retval None
  */
@@ -52,7 +67,9 @@ void USARTL1_Init(void) {
 
 	USARTL1_rx_wr_pointer = 0;
 	USARTL1_rx_rd_pointer = 0;
-	USARTL1_txen = 0;
+	USARTL1_tx_wr_pointer = 0;
+	USARTL1_tx_rd_pointer = 0;
+	USARTL1_tx_len = 0;
 
 	UartHandle.Instance = USARTx;
 	UartHandle.Init.BaudRate = 115200;
@@ -62,29 +79,109 @@ void USARTL1_Init(void) {
 	UartHandle.Init.HwFlowCtl = UART_HWCONTROL_NONE;
 	UartHandle.Init.Mode = UART_MODE_TX_RX;
 	HAL_UART_Init(&UartHandle);
-	HAL_UART_Receive_IT(&UartHandle, (uint8_t *) USARTL1_rx_buffer,
-			USARTL1_RX_SIZE);
+
+	__DMA1_CLK_ENABLE();
+
+	// Transmitter: one DMA transfer per contiguous part of the buffer
+	hdma_usartl1_tx.Instance = DMA1_Stream6;
+	hdma_usartl1_tx.Init.Channel = DMA_CHANNEL_4;
+	hdma_usartl1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_usartl1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usartl1_tx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usartl1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usartl1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usartl1_tx.Init.Mode = DMA_NORMAL;
+	hdma_usartl1_tx.Init.Priority = DMA_PRIORITY_LOW;
+	hdma_usartl1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	hdma_usartl1_tx.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+	hdma_usartl1_tx.Init.MemBurst = DMA_MBURST_SINGLE;
+	hdma_usartl1_tx.Init.PeriphBurst = DMA_PBURST_SINGLE;
+	HAL_DMA_Init(&hdma_usartl1_tx);
+	hdma_usartl1_tx.XferCpltCallback = USARTL1_TxComplete;
+
+	// Receiver: circular, it never stops
+	hdma_usartl1_rx.Instance = DMA1_Stream5;
+	hdma_usartl1_rx.Init = hdma_usartl1_tx.Init;
+	hdma_usartl1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_usartl1_rx.Init.Mode = DMA_CIRCULAR;
+	HAL_DMA_Init(&hdma_usartl1_rx);
+	HAL_DMA_Start(&hdma_usartl1_rx, (uint32_t) &USARTx->DR,
+			(uint32_t) USARTL1_rx_buffer, USARTL1_RX_SIZE);
+
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+
+	UartHandle.Instance->CR3 |= USART_CR3_DMAR | USART_CR3_DMAT;
+	__HAL_UART_ENABLE_IT(&UartHandle, UART_IT_PE);
+	__HAL_UART_ENABLE_IT(&UartHandle, UART_IT_ERR);
+	__HAL_UART_ENABLE_IT(&UartHandle, UART_IT_IDLE);
 }
 
 /**
- * @brief  Check, if there is something in the receive buffer to decode
+ * @brief  Change the baud rate, after all data in the transmit buffer is
+ * 		   sent. Until then, the buffer is reported as full.
+ * 		   The change is done by USARTL1_Task().
+ * @param  baudrate the new baud rate. Max. 2625000 with 42MHz APB1 clock
+ * @retval None
+ */
+void USARTL1_SetBaudrate(uint32_t baudrate) {
+
+	USARTL1_baudrate_pending = baudrate;
+}
+
+/**
+ * @brief  Cyclic task. Changes the baud rate, if the last byte was sent.
  * @param  None
  * @retval None
  */
-void USARTL1_RxBufferTask(void) {
+void USARTL1_Task(void) {
+
+	if (USARTL1_baudrate_pending == 0)
+		return;
+	if ((USARTL1_tx_len != 0)
+			|| (__HAL_UART_GET_FLAG(&UartHandle, UART_FLAG_TC) == RESET))
+		return;
+
+	UartHandle.Init.BaudRate = USARTL1_baudrate_pending;
+	UartHandle.Instance->BRR = __UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(),
+			USARTL1_baudrate_pending);
+	USARTL1_baudrate_pending = 0;
+}
+
+/**
+ * @brief  Check, if there is something in the receive buffer to decode.
+ * 		   The bytes wait in the buffer, while a dump or a response is
+ * 		   sent, so the answers are not mixed into it.
+ * @param  None
+ * @retval Number of decoded bytes
+ */
+int USARTL1_RxBufferTask(void) {
 
 	char c;
+	int n = 0;
+
 	//Increment the read pointer of the RX buffer
-	if (USARTL1_RxBufferNotEmpty()) {
+	while (!USARTL2_TxPaused() && USARTL1_RxBufferNotEmpty()) {
+		c = USARTL1_rx_buffer[USARTL1_rx_rd_pointer];
 		USARTL1_rx_rd_pointer++;
 		USARTL1_rx_rd_pointer &= USARTL1_RX_MASK;
-		c = USARTL1_rx_buffer[USARTL1_rx_rd_pointer];
+
+		// Binary requests are not echoed. All their bytes are processed
+		// at once, the ASCII console only one character per call.
+		n++;
+		if ((c == COBS_DELIMITER) || COMMAND_Receiving()) {
+			COMMAND_Receive(c);
+			continue;
+		}
+
 		// echo
 		if (c != 27)
 			USARTL1_PutByte(&UartHandle, c);
 		//Decode the received byte
 		USARTL2_Decode(c);
+		break;
 	}
+	return n;
 }
 
 /**
@@ -96,47 +193,122 @@ void USARTL1_RxBufferTask(void) {
  */
 int USARTL1_RxBufferNotEmpty(void) {
 
+	USARTL1_rx_wr_pointer = USARTL1_RX_POS();
 	return USARTL1_rx_wr_pointer != USARTL1_rx_rd_pointer;
 }
 
+/**
+ * @brief  Returns the free space in the transmit buffer
+ *
+ * @param  None
+ * @retval Number of bytes that can be written without waiting
+ */
+int USARTL1_TxFree(void) {
+
+	// Nothing more before the baud rate is changed
+	if (USARTL1_baudrate_pending != 0)
+		return 0;
+	return (USARTL1_tx_rd_pointer - USARTL1_tx_wr_pointer - 1)
+			& USARTL1_TX_MASK;
+}
+
+/**
+ * @brief  Write data into the transmit buffer and start the DMA.
+ * 		   This function never waits. If the buffer is full, only the
+ * 		   first bytes are accepted.
+ *
+ * @param  data the bytes to send
+ * @param  n number of bytes
+ * @retval Number of bytes that were accepted
+ */
+int USARTL1_Write(const uint8_t *data, int n) {
+	int free, wr, part;
+
+	free = USARTL1_TxFree();
+	if (n > free) {
+		USARTL1_tx_dropped += n - free;
+		n = free;
+	}
+	if (n <= 0)
+		return 0;
+
+	// Copy up to the end of the buffer and the rest to the begin
+	wr = USARTL1_tx_wr_pointer;
+	part = USARTL1_TX_SIZE - wr;
+	if (part > n)
+		part = n;
+	memcpy(&USARTL1_tx_buffer[wr], data, part);
+	memcpy(USARTL1_tx_buffer, data + part, n - part);
+	USARTL1_tx_wr_pointer = (wr + n) & USARTL1_TX_MASK;
+
+	__disable_irq();
+	if (USARTL1_tx_len == 0)
+		USARTL1_StartTx();
+	__enable_irq();
+
+	return n;
+}
+
 /**
  * @brief  Write a new character into the transmit buffer
- *         This function is called by the printf function
+ *         This function is called by the printf function. It never
+ *         waits, if the buffer is full the character is dropped.
  *
  * @param  huart handle to uart driver
  * @param  b character to send
+ * @retval 1, if the byte was accepted
  */
-void USARTL1_PutByte(UART_HandleTypeDef *huart, uint8_t b) {
-
-	// Send the byte
-	if (!USARTL1_txen) {
-		// Write the first byte directly into the USART
-		USARTL1_txen = 1;
-
-		huart->Instance->DR = b;
-		__HAL_UART_ENABLE_IT(huart, UART_IT_TXE);
-	} else {
-
-		while (((USARTL1_tx_wr_pointer + 1) & USARTL1_TX_MASK)
-				== USARTL1_tx_rd_pointer)
-			;
-		__HAL_UART_DISABLE_IT(huart, UART_IT_TXE);
-
-		// Write the next character into the buffer
-		USARTL1_tx_wr_pointer++;
-		USARTL1_tx_wr_pointer &= USARTL1_TX_MASK;
-		if (USARTL1_tx_wr_pointer == USARTL1_tx_rd_pointer) {
-			USARTL1_tx_wr_pointer--;
-			USARTL1_tx_wr_pointer &= USARTL1_TX_MASK;
-		}
+int USARTL1_PutByte(UART_HandleTypeDef *huart, uint8_t b) {
 
-		USARTL1_tx_buffer[USARTL1_tx_wr_pointer] = b;
-		__HAL_UART_ENABLE_IT(huart, UART_IT_TXE);
+	return USARTL1_Write(&b, 1);
+}
+
+/**
+ * @brief  Start the DMA with the contiguous part of the transmit buffer.
+ * 		   Must be called with disabled interrupts or from the DMA interrupt.
+ * @param  None
+ * @retval None
+ */
+static void USARTL1_StartTx(void) {
+	int rd, wr;
+
+	rd = USARTL1_tx_rd_pointer;
+	wr = USARTL1_tx_wr_pointer;
+	if (wr == rd) {
+		USARTL1_tx_len = 0;
+		return;
 	}
+
+	// Up to the write pointer or the end of the buffer
+	USARTL1_tx_len = (wr > rd ? wr : USARTL1_TX_SIZE) - rd;
+	HAL_DMA_Start_IT(&hdma_usartl1_tx, (uint32_t) &USARTL1_tx_buffer[rd],
+			(uint32_t) &UartHandle.Instance->DR, USARTL1_tx_len);
+}
+
+/**
+ * @brief  DMA transfer complete callback. Send the next part, if there is one.
+ * @param  hdma DMA handle
+ * @retval None
+ */
+static void USARTL1_TxComplete(DMA_HandleTypeDef *hdma) {
+	USARTL1_tx_rd_pointer = (USARTL1_tx_rd_pointer + USARTL1_tx_len)
+			& USARTL1_TX_MASK;
+	USARTL1_StartTx();
+}
+
+/**
+ * @brief  Handles the interrupt request of the transmit DMA
+ * @param  None
+ * @retval None
+ */
+void USARTL1_DMA_TX_IRQHandler(void) {
+	HAL_DMA_IRQHandler(&hdma_usartl1_tx);
 }
 
 /**
  * @brief  This function handles UART interrupt request.
+ * 		   Only errors and the idle line are handled here, the data
+ * 		   is transfered by the DMA.
  * @param  huart: UART handle
  * @retval None
  */
@@ -179,20 +351,16 @@ void USARTL1_IRQHandler(UART_HandleTypeDef *huart) {
 		huart->ErrorCode |= HAL_UART_ERROR_ORE;
 	}
 
-	tmp1 = __HAL_UART_GET_FLAG(huart, UART_FLAG_RXNE);
-	tmp2 = __HAL_UART_GET_IT_SOURCE(huart, UART_IT_RXNE);
-	/* UART in mode Receiver ---------------------------------------------------*/
+	tmp1 = __HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE);
+	tmp2 = __HAL_UART_GET_IT_SOURCE(huart, UART_IT_IDLE);
+	/* UART idle line: the sender made a pause ---------------------------------*/
 	if ((tmp1 != RESET) && (tmp2 != RESET)) {
-		USARTL1_Receive(huart);
-		__HAL_UART_CLEAR_FLAG(huart, UART_FLAG_RXNE);
-	}
-
-	tmp1 = __HAL_UART_GET_FLAG(huart, UART_FLAG_TXE);
-	tmp2 = __HAL_UART_GET_IT_SOURCE(huart, UART_IT_TXE);
-	/* UART in mode Transmitter ------------------------------------------------*/
-	if ((tmp1 != RESET) && (tmp2 != RESET)) {
-		USARTL1_Transmit(huart);
-		__HAL_UART_CLEAR_FLAG(huart, UART_FLAG_TXE);
+		// The flag is cleared by reading SR and then DR
+		tmp1 = huart->Instance->SR;
+		tmp1 = huart->Instance->DR;
+		USARTL1_rx_wr_pointer = USARTL1_RX_POS();
+		USARTL1_rx_idle++;
+		SCHED_Post(SCHED_UART_RX);
 	}
 
 	if (huart->ErrorCode != HAL_UART_ERROR_NONE) {
@@ -203,48 +371,6 @@ void USARTL1_IRQHandler(UART_HandleTypeDef *huart) {
 	}
 }
 
-/**
- * @brief  Transmit an amount of data in non blocking mode
- * @param  huart: UART handle
- * @retval None
- */
-static void USARTL1_Transmit(UART_HandleTypeDef *huart) {
-	//Increment the read pointer of the TX buffer
-	if (USARTL1_tx_wr_pointer != USARTL1_tx_rd_pointer) {
-		USARTL1_tx_rd_pointer++;
-		USARTL1_tx_rd_pointer &= USARTL1_TX_MASK;
-
-		//send the next byte
-		huart->Instance->DR = USARTL1_tx_buffer[USARTL1_tx_rd_pointer];
-	} else {
-		// This was the last byte to send, disable the transmission.
-		USARTL1_txen = 0;
-		/* Disable the UART Transmit Complete Interrupt */
-		__HAL_UART_DISABLE_IT(huart, UART_IT_TXE);
-	}
-}
-
-/**
- * @brief  Receives an amount of data in non blocking mode
- * @param  huart: UART handle
- * @retval HAL status
- */
-static void USARTL1_Receive(UART_HandleTypeDef *huart) {
-	uint8_t c;
-
-	// Increment the buffer pointer, if it's possible
-	USARTL1_rx_wr_pointer++;
-	USARTL1_rx_wr_pointer &= USARTL1_RX_MASK;
-	if (USARTL1_rx_wr_pointer == USARTL1_rx_rd_pointer) {
-		USARTL1_rx_wr_pointer--;
-		USARTL1_rx_wr_pointer &= USARTL1_RX_MASK;
-	}
-
-	// Write the received byte
-	c = (uint8_t) (huart->Instance->DR & (uint8_t) 0x00FF);
-	USARTL1_rx_buffer[USARTL1_rx_wr_pointer] = c;
-}
-
 /**
  * @brief  UART error callbacks
  * @param  UartHandle: UART handle
@@ -22,9 +22,22 @@
  */
 
 /* Includes -----------------------------------------------------------------*/
+#include <string.h>
 #include "usartl2.h"
 #include "camera.h"
+#include "ov5647.h"
 #include "track.h"
+#include "lcd.h"
+#include "overview.h"
+#include "history.h"
+#include "irlink.h"
+#include "framestream.h"
+#include "trace.h"
+#include "profile.h"
+#include "latency.h"
+#include "sched.h"
+#include "command.h"
+#include "param.h"
 
 /* local variables ----------------------------------------------------------*/
 enDecodeState decodeState;
@@ -33,7 +46,37 @@ uint32_t decodePos;
 uint32_t decodeAddress;
 uint32_t decodeData;
 extern DCMI_HandleTypeDef  hdcmi_eval;
+
+// Baud rates of the 'b' command
+static const uint32_t baudrates[USARTL2_BAUDRATES] = {
+	115200, 230400, 460800, 921600, 1000000, 2000000
+};
 int debug_on;
+uint16_t telemetry_seq;				// Frame number of the last processed frame
+uint32_t telemetry_skipped;			// camera_skipped at the last processed frame
+uint32_t telemetry_frames_dropped;	// Frames that were lost
+uint32_t telemetry_dropped;			// Packets that did not fit into the buffer
+uint8_t telemetry_packet[STREAM_MAX_PACKET];
+uint16_t screenshot_line[320 + 1]; // One line of the LCD with a dummy value
+
+// Dump, that is sent in the background line by line
+Usartl2_DumpTypeDef usartl2_dump = USARTL2_DUMP_NONE;
+int usartl2_dump_line;		// Next line to format, -1 after the prompt
+int usartl2_dump_len;		// Length of the formatted line, 0 if it was sent
+char usartl2_dump_buffer[USARTL2_DUMP_LINE];
+
+static int USARTL2_ScreenshotLine(int line, char *buf, int size);
+
+// Formats the lines of each dump
+static int (* const usartl2_dump_lines[USARTL2_DUMPS])(int line, char *buf,
+		int size) = {
+	0, USARTL2_ScreenshotLine, OVERVIEW_DumpLine, HISTORY_DumpLine,
+#ifdef PROFILE
+	PROFILE_DumpLine
+#else
+	0
+#endif
+};
 
 /**
  * @brief  Initialize the module
@@ -66,14 +109,204 @@ uint32_t hex2dec(char c) {
 }
 
 /**
- * @brief This function is called, when a complete frame was decoded
+ * @brief  Write one 16 bit value little endian
+ *
+ * @param  p the buffer
+ * @param  v the value
+ * @retval The position after the value
+ */
+static char* USARTL2_PutWord(char *p, uint16_t v) {
+	*p++ = v & 0xFF;
+	*p++ = v >> 8;
+	return p;
+}
+
+/**
+ * @brief One line of the whole 320x240 pixel display as binary RGB565 image.
+ * Format (all values 16 bit little endian):
+ *   "CSCR" width height
+ *   height times: line_number width*pixel sum_of_pixels
+ * @param  line number of the line, starting with 0
+ * @param  buf output: the data
+ * @param  size size of buf, at least USARTL2_DUMP_LINE
+ * @retval Length of the line, 0 after the last line
+ */
+static int USARTL2_ScreenshotLine(int line, char *buf, int size) {
+	int x;
+	uint16_t sum;
+	char *p = buf;
+
+	if (line == 0) {
+		memcpy(p, "CSCR", 4);
+		p = USARTL2_PutWord(p + 4, 320);
+		p = USARTL2_PutWord(p, 240);
+		return p - buf;
+	}
+	if (line > 240)
+		return 0;
+
+	LCD_ReadLine(line - 1, screenshot_line);
+	p = USARTL2_PutWord(p, line - 1);
+	sum = 0;
+	for (x = 1; x <= 320; x++) {
+		p = USARTL2_PutWord(p, screenshot_line[x]);
+		sum += screenshot_line[x];
+	}
+	p = USARTL2_PutWord(p, sum);
+	return p - buf;
+}
+
+/**
+ * @brief Start to send a screenshot or the dump of a module in the
+ * background. The console input waits until it's sent.
+ * @param dump the dump
+ * @retval none
+ */
+void USARTL2_StartDump(Usartl2_DumpTypeDef dump) {
+	usartl2_dump_line = 0;
+	usartl2_dump_len = 0;
+	usartl2_dump = dump;
+}
+
+/**
+ * @brief Cyclic task. Sends the next lines of the dump and then the
+ * prompt, as long as they fit into the transmit buffer.
  * @param none
  * @retval none
  */
-void USARTL2_FrameCallback(void) {
-	if (debug_on) {
-		my_printf("%04d.%03d;%04d.%03d;%05d\r\n", position_x, position_subx, position_y, position_suby, intensity);
+void USARTL2_DumpTask(void) {
+
+	while (usartl2_dump != USARTL2_DUMP_NONE) {
+		// Format the next line, if the last one was sent
+		if (usartl2_dump_len == 0) {
+			if (usartl2_dump_line < 0) {
+				usartl2_dump = USARTL2_DUMP_NONE;
+				break;
+			}
+			usartl2_dump_len = usartl2_dump_lines[usartl2_dump](usartl2_dump_line,
+					usartl2_dump_buffer, sizeof(usartl2_dump_buffer));
+			usartl2_dump_line++;
+			if (usartl2_dump_len == 0) {
+				usartl2_dump_len = my_snprintf(usartl2_dump_buffer,
+						sizeof(usartl2_dump_buffer), "\r\n>");
+				usartl2_dump_line = -1;
+			}
+		}
+		if (USARTL1_TxFree() < usartl2_dump_len)
+			break;
+		USARTL1_Write((const uint8_t*) usartl2_dump_buffer, usartl2_dump_len);
+		usartl2_dump_len = 0;
+	}
+}
+
+/**
+ * @brief The frame stream, the trace and the telemetry pause, while
+ * a dump or the response to a request is sent.
+ * @param none
+ * @retval 1, if the output is paused
+ */
+int USARTL2_TxPaused(void) {
+	return (usartl2_dump != USARTL2_DUMP_NONE) || COMMAND_Pending();
+}
+
+/**
+ * @brief Start the telemetry and reset its counters, or stop it
+ * @param on 1 to start the telemetry
+ * @retval none
+ */
+void USARTL2_SetTelemetry(int on) {
+	if (on) {
+		telemetry_seq = irlink_frame_seq;
+		telemetry_skipped = camera_skipped;
+		telemetry_frames_dropped = 0;
+		telemetry_dropped = 0;
 	}
+	debug_on = on;
+}
+
+/**
+ * @brief This function is called, when a complete frame was decoded.
+ * Sends the telemetry packet, if it's on. The packet is only written, if
+ * it fits completely into the transmit buffer and no dump or response
+ * is sent.
+ * @param process_us processing time of the frame
+ * @retval none
+ */
+void USARTL2_FrameCallback(uint32_t process_us) {
+	Stream_TelemetryTypeDef t;
+	int len;
+	uint16_t seq;
+	uint32_t gap, skipped;
+
+	// Both are changed by the frame interrupt
+	__disable_irq();
+	seq = irlink_frame_seq;
+	skipped = camera_skipped;
+	__enable_irq();
+
+	// Frames between the last processed one and this one were lost, if
+	// the camera did not skip them on purpose after a hold or a restart
+	gap = (uint16_t)(seq - telemetry_seq - 1);
+	skipped -= telemetry_skipped;
+	if (gap > skipped)
+		telemetry_frames_dropped += gap - skipped;
+	telemetry_seq = seq;
+	telemetry_skipped += skipped;
+
+	if (!debug_on)
+		return;
+
+	t.frame = seq;
+	t.timestamp = irlink_frame_us;
+	t.status = track_status;
+	t.x = position_x;
+	t.subx = position_subx;
+	t.y = position_y;
+	t.suby = position_suby;
+	t.intensity = intensity;
+	t.exposure = camera_exposure;
+	t.process_us = process_us;
+	t.frames_dropped = telemetry_frames_dropped;
+	t.telemetry_dropped = telemetry_dropped;
+	t.uart_dropped = USARTL1_tx_dropped;
+	t.ir_dropped = irqueue_counters.dropped + irqueue_counters.overwritten
+			+ irqueue_counters.stale;
+
+	len = STREAM_EncodeTelemetry(&t, telemetry_packet);
+	if (!USARTL2_TxPaused() && (USARTL1_TxFree() >= len))
+		USARTL1_Write(telemetry_packet, len);
+	else
+		telemetry_dropped++;
+}
+
+/**
+ * @brief  Write a register of the camera. Exposure time and gain are
+ * 		   parameters, they are set with PARAM_Set(), so they are also
+ * 		   saved in the flash like with the remote commands.
+ *
+ * @param  reg the register
+ * @param  value the new value
+ * @retval None
+ */
+static void USARTL2_WriteRegister(uint16_t reg, uint8_t value) {
+	BSP_CAMERA_DebugWrite(reg, value);
+	if (reg == OV5647_EXPOSURE_H || reg == OV5647_EXPOSURE_M
+			|| reg == OV5647_EXPOSURE_L)
+		PARAM_Set(PARAM_EXPOSURE, camera_exposure);
+	if (reg == OV5647_GAIN_H || reg == OV5647_GAIN_L)
+		PARAM_Set(PARAM_GAIN, camera_gain);
+}
+
+/**
+ * @brief  Change a parameter from the console
+ *
+ * @param  id Param_IdTypeDef
+ * @param  value the new value
+ * @retval None
+ */
+static void USARTL2_SetParam(int id, int32_t value) {
+	if (PARAM_Set(id, value) != 0)
+		my_printf(" out of range");
 }
 
 /**
@@ -85,6 +318,7 @@ void USARTL2_FrameCallback(void) {
 void USARTL2_Decode(char c) {
 	uint8_t b;
 	int x,y;
+	uint32_t baudrate = 0;
 
 	if (c == '\r' || c == '\n') {
 		decodeState = DECODE_ENTER;
@@ -97,36 +331,76 @@ void USARTL2_Decode(char c) {
 
 	switch (decodeState) {
 	case DECODE_CMD:
+		TRACE(TRACE_COMMAND, c, 0);
 		// Write a I2C address with data
 		decodeCmd = c;
-		if ((c == 'w') || (c == 'r')|| (c == 'c'))  {
+		if ((c == 'w') || (c == 'r')|| (c == 'c') || (c == 'p') || (c == 'f')
+				|| (c == 'm') || (c == 'l') || (c == 's') || (c == 'b'))  {
 			decodeState = DECODE_ADDRESS;
 			decodePos = 0;
 			decodeAddress = 0;
 			decodeData = 0;
 		}
-		if (c == 's') {
+		if (c == 't') {
+			PARAM_Set(PARAM_CAMERA_SIZE, CAMERA_TOTAL);
+		}
+		if (c == 'z') {
+			PARAM_Set(PARAM_CAMERA_SIZE, CAMERA_ZOOMED);
+		}
+		if (c == 'S') {
+			USARTL2_StartDump(USARTL2_DUMP_SCREENSHOT);
+		}
+		if (c == 'o') {
+			USARTL2_StartDump(USARTL2_DUMP_OVERVIEW);
+		}
+		if (c == 'h') {
+			USARTL2_StartDump(USARTL2_DUMP_HISTORY);
+		}
+		if (c == 'q') {
 			my_printf("\r\n");
-			for (y=0; y<120; y++) {
-				for (x=0; x<120; x++) {
-					my_printf("%03d ",pixels.zoomed[y][x]);
-				}
-				my_printf("\r\n");
-			}
+			IRLINK_PrintCounters();
 			my_printf("\r\n>");
 		}
-
-		if (c == 't') {
-			BSP_CAMERA_SetSize(CAMERA_TOTAL);
+		if (c == 'v') {
+			PARAM_Set(PARAM_OVERVIEW, !overview_view);
 		}
-		if (c == 'z') {
-			BSP_CAMERA_SetSize(CAMERA_ZOOMED);
+		if ((c == '1') || (c == '2') || (c == '4')) {
+			PARAM_Set(PARAM_LCD_ZOOM, c - '0');
+		}
+		if (c == 'P') {
+			LCD_SetPan(LCD_PAN_AUTO, LCD_PAN_AUTO);
 		}
 		if (c == 'd') {
 			debug_on = 0;
 		}
 		if (c == 'D') {
-			debug_on = 1;
+			USARTL2_SetTelemetry(1);
+		}
+		if (c == 'x') {
+			TRACE_SetOn(0);
+		}
+		if (c == 'X') {
+			TRACE_SetOn(1);
+		}
+#ifdef PROFILE
+		if (c == 'Z') {
+			USARTL2_StartDump(USARTL2_DUMP_PROFILE);
+		}
+#endif
+		if (c == 'L') {
+			my_printf("\r\n");
+			LATENCY_Print();
+			my_printf(">");
+		}
+		if (c == 'T') {
+			my_printf("\r\n");
+			SCHED_Print();
+			my_printf(">");
+		}
+		if (c == 'Y') {
+			PROFILE_Reset();
+			LATENCY_Reset();
+			SCHED_Reset();
 		}
 		break;
 	case DECODE_ADDRESS:
@@ -151,7 +425,7 @@ void USARTL2_Decode(char c) {
 				}
 				else if (decodeCmd == 'w') {
 					my_printf("Write %x to %x", decodeData, decodeAddress );
-					BSP_CAMERA_DebugWrite(decodeAddress , decodeData);
+					USARTL2_WriteRegister(decodeAddress , decodeData);
 				}
 				else if (decodeCmd == 'c') {
 					x = decodeAddress;
@@ -159,6 +433,37 @@ void USARTL2_Decode(char c) {
 					my_printf("Crop 0x%x,0x%x %d,%d", x,y,x,y );
 					HAL_DCMI_ConfigCROP(&hdcmi_eval, x,y,120-1,120-1);
 				}
+				else if (decodeCmd == 'p') {
+					x = decodeAddress;
+					y = decodeData;
+					my_printf("Pan %d,%d", x,y );
+					LCD_SetPan(x, y);
+				}
+				else if (decodeCmd == 'f') {
+					my_printf("IR FEC mode %d", decodeAddress );
+					USARTL2_SetParam(PARAM_IR_FEC, decodeAddress);
+				}
+				else if (decodeCmd == 'm') {
+					my_printf("IR compact packets %d", decodeAddress );
+					USARTL2_SetParam(PARAM_IR_COMPACT, decodeAddress != 0);
+				}
+				else if (decodeCmd == 'l') {
+					my_printf("IR queue policy %d", decodeAddress );
+					USARTL2_SetParam(PARAM_IR_POLICY, decodeAddress != 0 ?
+							IRQUEUE_DROP_OLDEST : IRQUEUE_DROP_NEWEST);
+				}
+				else if (decodeCmd == 's') {
+					my_printf("Frame stream mode %d, %d frames sent, %d skipped",
+							decodeAddress, framestream_sent, framestream_skipped);
+					FRAMESTREAM_SetMode(decodeAddress);
+					// A recording needs the tracking result of each frame
+					if (decodeAddress == FRAMESTREAM_RECORD)
+						USARTL2_SetTelemetry(1);
+				}
+				else if ((decodeCmd == 'b') && (decodeAddress < USARTL2_BAUDRATES)) {
+					baudrate = baudrates[decodeAddress];
+					my_printf("Baud rate %d", baudrate);
+				}
 				else {
 					my_printf("Unknown command");
 				}
@@ -171,6 +476,9 @@ void USARTL2_Decode(char c) {
 			my_printf("Address out of range");
 		}
 		my_printf("\r\n>");
+		// The answer is sent with the old baud rate
+		if (baudrate != 0)
+			USARTL1_SetBaudrate(baudrate);
 		decodeState = DECODE_CMD;
 		break;
 	default:
@@ -0,0 +1,327 @@
+/**
+ *  Project     Campos
+ *  @file		camposctl.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: registers, parameters and streams of the tracker
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o camposctl camposctl.c client.c \
+ *             ../Campos/src/stream.c ../Campos/src/cobs.c ../Campos/src/crc.c
+ *
+ *  Usage: camposctl [-b baud index] <serial port> <command> [arguments]
+ *         camposctl [-b baud index] -f <script> <serial port>
+ *
+ *  Commands (register addresses and values are hex, like on the console):
+ *    ping                          protocol version, frame number, uptime
+ *    read <addr> [<addr> ..]       read sensor registers in one request
+ *    write <addr>=<val> [..]       write sensor registers in one request
+ *    get <param> [<param> ..]      read parameters
+ *    set <param>=<val> [..]        set parameters
+ *    stream <mode> [<telemetry> [<trace>]]
+ *                                  0/1/2/3 and 0/1, '-' keeps the setting
+ *    params                        list the parameters with range and value
+ *    sleep <ms>                    wait, e.g. for the exposure to settle
+ *  A script has one command per line, '#' starts a comment. It stops at
+ *  the first error. The parameter names are read from the tracker, a
+ *  parameter may also be given by its id.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "client.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define MAX_ARGS		(4 * COMMAND_MAX_ITEMS)
+#define MAX_PARAMS		256
+
+/* local variables ----------------------------------------------------------*/
+static Client_TypeDef client;
+
+// The parameters of the tracker, they are read with the first get or set
+static Client_ParamTypeDef params[MAX_PARAMS];
+static int param_count = -1;
+
+static const char * const type_names[] = { "int", "bool", "enum" };
+
+/**
+ * @brief  Print the error of a request
+ */
+static int error(const char *cmd, int ret) {
+	static const char * const status_names[] = {
+		"ok", "unknown command", "wrong length", "out of range"
+	};
+
+	if (ret == CLIENT_ERR_STATUS)
+		fprintf(stderr, "%s: %s\n", cmd, client.status < 4 ?
+				status_names[client.status] : "error");
+	else if (ret == CLIENT_ERR_TIMEOUT)
+		fprintf(stderr, "%s: no response\n", cmd);
+	else
+		fprintf(stderr, "%s: communication error %d\n", cmd, ret);
+	return ret;
+}
+
+/**
+ * @brief  Read the parameter names, if they are not read yet
+ * @retval 0 on success
+ */
+static int load_params(const char *cmd) {
+	int ret;
+
+	if (param_count >= 0)
+		return 0;
+	ret = CLIENT_ParamInfo(&client, params, MAX_PARAMS);
+	if (ret < 0)
+		return error(cmd, ret);
+	param_count = ret;
+	return 0;
+}
+
+/**
+ * @brief  Parameter id from a name or a number
+ * @retval id or -1
+ */
+static int param_id(const char *name) {
+	char *end;
+	int i;
+
+	for (i = 0; i < param_count; i++)
+		if (strcmp(name, params[i].name) == 0)
+			return i;
+	i = strtol(name, &end, 0);
+	return (*end == 0 && end != name && i >= 0 && i < 256) ? i : -1;
+}
+
+/**
+ * @brief  Name of a parameter
+ */
+static const char *param_name(int id) {
+	return id < param_count ? params[id].name : "?";
+}
+
+/**
+ * @brief  Split "a=b" into 2 numbers
+ * @retval 0 on success
+ */
+static int split(const char *arg, char *left, int size, long *value, int base) {
+	const char *eq = strchr(arg, '=');
+	char *end;
+
+	if (!eq || eq - arg >= size)
+		return -1;
+	memcpy(left, arg, eq - arg);
+	left[eq - arg] = 0;
+	*value = strtol(eq + 1, &end, base);
+	return (*end == 0 && end != eq + 1) ? 0 : -1;
+}
+
+/**
+ * @brief  Execute one command
+ * @retval 0 on success
+ */
+static int execute(int argc, char *argv[]) {
+	static uint16_t addr[MAX_ARGS];
+	static uint8_t val[MAX_ARGS];
+	static uint8_t id[MAX_ARGS];
+	static int32_t value[MAX_ARGS];
+	Client_StreamTypeDef counters;
+	int i, n = argc - 1, ret, version, s[3];
+	uint16_t frame;
+	uint32_t tick;
+	char left[32];
+	long v;
+
+	if (argc < 1)
+		return 0;
+	if (n > MAX_ARGS) {
+		fprintf(stderr, "%s: more than %d arguments\n", argv[0], MAX_ARGS);
+		return -1;
+	}
+
+	if (strcmp(argv[0], "ping") == 0) {
+		ret = CLIENT_Ping(&client, &version, &frame, &tick);
+		if (ret < 0)
+			return error(argv[0], ret);
+		printf("protocol %d, frame %u, %u ms after reset\n", version, frame, tick);
+
+	} else if (strcmp(argv[0], "read") == 0) {
+		for (i = 0; i < n; i++)
+			addr[i] = strtol(argv[i + 1], NULL, 16);
+		ret = CLIENT_ReadRegs(&client, addr, val, n);
+		if (ret < 0)
+			return error(argv[0], ret);
+		for (i = 0; i < n; i++)
+			printf("%04x %02x\n", addr[i], val[i]);
+
+	} else if (strcmp(argv[0], "write") == 0) {
+		for (i = 0; i < n; i++) {
+			if (split(argv[i + 1], left, sizeof(left), &v, 16) != 0) {
+				fprintf(stderr, "write: %s is not <addr>=<value>\n", argv[i + 1]);
+				return -1;
+			}
+			addr[i] = strtol(left, NULL, 16);
+			val[i] = v;
+		}
+		ret = CLIENT_WriteRegs(&client, addr, val, n);
+		if (ret < 0)
+			return error(argv[0], ret);
+
+	} else if (strcmp(argv[0], "get") == 0) {
+		if (load_params(argv[0]) != 0)
+			return -1;
+		for (i = 0; i < n; i++) {
+			if (param_id(argv[i + 1]) < 0) {
+				fprintf(stderr, "get: unknown parameter %s\n", argv[i + 1]);
+				return -1;
+			}
+			id[i] = param_id(argv[i + 1]);
+		}
+		ret = CLIENT_GetParams(&client, id, value, n);
+		if (ret < 0)
+			return error(argv[0], ret);
+		for (i = 0; i < n; i++)
+			printf("%s %d\n", param_name(id[i]), value[i]);
+
+	} else if (strcmp(argv[0], "set") == 0) {
+		if (load_params(argv[0]) != 0)
+			return -1;
+		for (i = 0; i < n; i++) {
+			if (split(argv[i + 1], left, sizeof(left), &v, 0) != 0
+					|| param_id(left) < 0) {
+				fprintf(stderr, "set: %s is not <param>=<value>\n", argv[i + 1]);
+				return -1;
+			}
+			id[i] = param_id(left);
+			value[i] = v;
+		}
+		ret = CLIENT_SetParams(&client, id, value, n);
+		if (ret < 0)
+			return error(argv[0], ret);
+		for (i = 0; i < n; i++)
+			printf("%s %d\n", param_name(id[i]), value[i]);
+
+	} else if (strcmp(argv[0], "stream") == 0) {
+		for (i = 0; i < 3; i++)
+			s[i] = (i < n && strcmp(argv[i + 1], "-") != 0) ? atoi(argv[i + 1]) : -1;
+		ret = CLIENT_Stream(&client, s[0], s[1], s[2], &counters);
+		if (ret < 0)
+			return error(argv[0], ret);
+		printf("frames sent %u, skipped %u, dropped: telemetry %u, trace %u, "
+				"port %u bytes\n", counters.frames_sent, counters.frames_skipped,
+				counters.telemetry_dropped, counters.trace_dropped,
+				counters.uart_dropped);
+
+	} else if (strcmp(argv[0], "params") == 0) {
+		if (load_params(argv[0]) != 0)
+			return -1;
+		for (i = 0; i < param_count; i++)
+			id[i] = i;
+		ret = CLIENT_GetParams(&client, id, value, param_count);
+		if (ret < 0)
+			return error(argv[0], ret);
+		for (i = 0; i < param_count; i++)
+			printf("%2d %-24s %-4s %d..%d, reset %d: %d\n", i, params[i].name,
+					params[i].type < 3 ? type_names[params[i].type] : "?",
+					params[i].min, params[i].max, params[i].def, value[i]);
+
+	} else if (strcmp(argv[0], "sleep") == 0 && n == 1) {
+		usleep(atoi(argv[1]) * 1000);
+
+	} else {
+		fprintf(stderr, "Unknown command %s\n", argv[0]);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Execute the commands of a script
+ * @retval 0 on success
+ */
+static int script(const char *name) {
+	char line[1024], *argv[MAX_ARGS + 1], *p;
+	int argc, line_number = 0;
+	FILE *f;
+
+	f = fopen(name, "r");
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		line_number++;
+		p = strchr(line, '#');
+		if (p)
+			*p = 0;
+		argc = 0;
+		for (p = strtok(line, " \t\r\n"); p && argc <= MAX_ARGS; p = strtok(NULL, " \t\r\n"))
+			argv[argc++] = p;
+		if (execute(argc, argv) != 0) {
+			fprintf(stderr, "%s:%d: stopped\n", name, line_number);
+			fclose(f);
+			return -1;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	const char *script_name = NULL;
+	int opt, baud = 0, ret;
+
+	while ((opt = getopt(argc, argv, "+b:f:")) != -1) {
+		switch (opt) {
+		case 'b':
+			baud = atoi(optarg);
+			break;
+		case 'f':
+			script_name = optarg;
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if ((argc - optind < 1) || (!script_name && argc - optind < 2)) {
+		fprintf(stderr, "Usage: %s [-b baud index] <serial port> <command> [arguments]\n"
+				"       %s [-b baud index] -f <script> <serial port>\n",
+				argv[0], argv[0]);
+		return 1;
+	}
+
+	if (CLIENT_Open(&client, argv[optind], baud) != CLIENT_OK) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	if (script_name)
+		ret = script(script_name);
+	else
+		ret = execute(argc - optind - 1, &argv[optind + 1]);
+
+	CLIENT_Close(&client);
+	if (client.retries)
+		fprintf(stderr, "%u requests sent again\n", client.retries);
+	return ret != 0;
+}
@@ -0,0 +1,462 @@
+/**
+ *  Project     Campos
+ *  @file		client.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tools: client of the binary command protocol
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Each request gets a new sequence number and waits for the response
+ *  with the same number. Other packets and the ASCII output of the debug
+ *  console are skipped, so the stream can keep running. Without a
+ *  response, the request is sent again. Batches with more than
+ *  COMMAND_MAX_ITEMS registers or parameters are split into several
+ *  requests. The parameter names and ranges are read from the tracker,
+ *  so the host tools do not need a list of the parameters.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include "client.h"
+
+/* local variables ----------------------------------------------------------*/
+static const speed_t speeds[] = {
+	B115200, B230400, B460800, B921600, B1000000, B2000000
+};
+
+/**
+ * @brief  Write a 16 bit value little endian
+ */
+static void put16(uint8_t *p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+/**
+ * @brief  Write a 32 bit value little endian
+ */
+static void put32(uint8_t *p, uint32_t v) {
+	put16(p, v & 0xFFFF);
+	put16(p + 2, v >> 16);
+}
+
+/**
+ * @brief  Read a 16 bit value little endian
+ */
+static uint16_t get16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * @brief  Read a 32 bit value little endian
+ */
+static uint32_t get32(const uint8_t *p) {
+	return get16(p) | ((uint32_t) get16(p + 2) << 16);
+}
+
+/**
+ * @brief  Time in ms
+ */
+static long now_ms(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+ * @brief  Configure a serial port, 8N1, raw
+ * @retval 0 on success
+ */
+static int serial_setup(int fd, speed_t speed) {
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) != 0)
+		return -1;
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	return tcsetattr(fd, TCSADRAIN, &tio);
+}
+
+/**
+ * @brief  Send an ASCII command to the debug console
+ */
+static int send_text(Client_TypeDef *c, const char *cmd) {
+	if (write(c->fd, cmd, strlen(cmd)) != (ssize_t) strlen(cmd))
+		return -1;
+	tcdrain(c->fd);
+	usleep(100000);
+	return 0;
+}
+
+/**
+ * @brief  Open the connection to the tracker
+ * @param  c the client
+ * @param  port serial port, or any other file that can be read and written
+ * @param  baud baud index of the 'b' command (0: 115200 .. 5: 2000000)
+ * @retval CLIENT_OK or CLIENT_ERR_IO
+ */
+int CLIENT_Open(Client_TypeDef *c, const char *port, int baud) {
+	char cmd[16];
+
+	memset(c, 0, sizeof(*c));
+	c->timeout_ms = CLIENT_TIMEOUT_MS;
+	c->seq = (uint16_t) now_ms();
+	if (baud < 0 || baud >= (int) (sizeof(speeds) / sizeof(speeds[0])))
+		return CLIENT_ERR_IO;
+
+	c->fd = open(port, O_RDWR | O_NOCTTY);
+	if (c->fd < 0)
+		return CLIENT_ERR_IO;
+
+	c->tty = isatty(c->fd);
+	if (c->tty) {
+		if (serial_setup(c->fd, B115200) != 0)
+			return CLIENT_ERR_IO;
+		if (baud != 0) {
+			snprintf(cmd, sizeof(cmd), "b%d\r", baud);
+			if (send_text(c, cmd) != 0 || serial_setup(c->fd, speeds[baud]) != 0)
+				return CLIENT_ERR_IO;
+			c->baud = baud;
+		}
+		tcflush(c->fd, TCIOFLUSH);
+	}
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Close the connection, the baud rate is set back to 115200
+ * @param  c the client
+ * @retval None
+ */
+void CLIENT_Close(Client_TypeDef *c) {
+	if (c->tty && c->baud != 0)
+		send_text(c, "b0\r");
+	close(c->fd);
+	c->fd = -1;
+}
+
+/**
+ * @brief  Wait for the response to the last request
+ * @param  c the client
+ * @param  payload output: the response payload
+ * @retval Length of the payload or CLIENT_ERR_xx
+ */
+static int CLIENT_Receive(Client_TypeDef *c, uint8_t *payload) {
+	static uint8_t coded[STREAM_MAX_PACKET];
+	static int n = 0, overflow = 0;
+	struct pollfd pfd;
+	long timeout = now_ms() + c->timeout_ms, remaining;
+	uint8_t buf[256], type;
+	int i, len, got;
+
+	while ((remaining = timeout - now_ms()) > 0) {
+		pfd.fd = c->fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, remaining) <= 0)
+			continue;
+		got = read(c->fd, buf, sizeof(buf));
+		if (got < 0)
+			return CLIENT_ERR_IO;
+
+		for (i = 0; i < got; i++) {
+			if (buf[i] != COBS_DELIMITER) {
+				if (n < (int) sizeof(coded))
+					coded[n++] = buf[i];
+				else
+					overflow = 1;
+				continue;
+			}
+			len = -1;
+			if (n > 0 && !overflow)
+				len = STREAM_Unpack(coded, n, &type, payload, STREAM_MAX_PAYLOAD);
+			n = 0;
+			overflow = 0;
+			if ((len >= COMMAND_RESPONSE_HEADER) && (type == STREAM_TYPE_RESPONSE)
+					&& (get16(payload) == c->seq))
+				return len;
+		}
+	}
+	return CLIENT_ERR_TIMEOUT;
+}
+
+/**
+ * @brief  Send a request and wait for the response
+ * @param  c the client
+ * @param  cmd COMMAND_xx
+ * @param  args the arguments
+ * @param  n length of the arguments
+ * @param  result output: the result of the command
+ * @param  max size of result
+ * @retval Length of the result or CLIENT_ERR_xx
+ */
+int CLIENT_Request(Client_TypeDef *c, uint8_t cmd, const uint8_t *args, int n,
+		uint8_t *result, int max) {
+	uint8_t request[STREAM_MAX_PAYLOAD];
+	uint8_t response[STREAM_MAX_PAYLOAD];
+	uint8_t packet[STREAM_MAX_PACKET];
+	int len, try;
+
+	if (n > STREAM_MAX_PAYLOAD - COMMAND_REQUEST_HEADER)
+		return CLIENT_ERR_FORMAT;
+
+	c->seq++;
+	put16(request, c->seq);
+	request[2] = cmd;
+	memcpy(&request[COMMAND_REQUEST_HEADER], args, n);
+	len = STREAM_Pack(STREAM_TYPE_REQUEST, request, COMMAND_REQUEST_HEADER + n,
+			packet);
+
+	for (try = 0; try <= CLIENT_RETRIES; try++) {
+		if (try > 0)
+			c->retries++;
+		if (write(c->fd, packet, len) != len)
+			return CLIENT_ERR_IO;
+		n = CLIENT_Receive(c, response);
+		if (n == CLIENT_ERR_TIMEOUT)
+			continue;
+		if (n < 0)
+			return n;
+
+		if (response[2] != cmd)
+			return CLIENT_ERR_FORMAT;
+		c->status = response[3];
+		if (c->status != COMMAND_OK)
+			return CLIENT_ERR_STATUS;
+		n -= COMMAND_RESPONSE_HEADER;
+		if (n > max)
+			return CLIENT_ERR_FORMAT;
+		memcpy(result, &response[COMMAND_RESPONSE_HEADER], n);
+		return n;
+	}
+	return CLIENT_ERR_TIMEOUT;
+}
+
+/**
+ * @brief  Check the connection
+ * @param  c the client
+ * @param  version output: protocol version of the firmware
+ * @param  frame output: frame number
+ * @param  tick_ms output: time since reset in ms
+ * @retval CLIENT_OK or CLIENT_ERR_xx
+ */
+int CLIENT_Ping(Client_TypeDef *c, int *version, uint16_t *frame, uint32_t *tick_ms) {
+	uint8_t result[7];
+	int n;
+
+	n = CLIENT_Request(c, COMMAND_PING, NULL, 0, result, sizeof(result));
+	if (n < 0)
+		return n;
+	if (n != 7)
+		return CLIENT_ERR_FORMAT;
+	*version = result[0];
+	*frame = get16(&result[1]);
+	*tick_ms = get32(&result[3]);
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Read sensor registers
+ * @param  c the client
+ * @param  addr register addresses
+ * @param  value output: register values
+ * @param  n number of registers
+ * @retval CLIENT_OK or CLIENT_ERR_xx
+ */
+int CLIENT_ReadRegs(Client_TypeDef *c, const uint16_t *addr, uint8_t *value, int n) {
+	uint8_t args[2 * COMMAND_MAX_ITEMS];
+	int i, count, ret;
+
+	for ( ; n > 0; n -= count, addr += count, value += count) {
+		count = n > COMMAND_MAX_ITEMS ? COMMAND_MAX_ITEMS : n;
+		for (i = 0; i < count; i++)
+			put16(&args[2 * i], addr[i]);
+		ret = CLIENT_Request(c, COMMAND_REG_READ, args, 2 * count, value, count);
+		if (ret < 0)
+			return ret;
+		if (ret != count)
+			return CLIENT_ERR_FORMAT;
+	}
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Write sensor registers, in the order of the array
+ * @param  c the client
+ * @param  addr register addresses
+ * @param  value register values
+ * @param  n number of registers
+ * @retval CLIENT_OK or CLIENT_ERR_xx
+ */
+int CLIENT_WriteRegs(Client_TypeDef *c, const uint16_t *addr, const uint8_t *value,
+		int n) {
+	uint8_t args[3 * COMMAND_MAX_ITEMS];
+	int i, count, ret;
+
+	for ( ; n > 0; n -= count, addr += count, value += count) {
+		count = n > COMMAND_MAX_ITEMS ? COMMAND_MAX_ITEMS : n;
+		for (i = 0; i < count; i++) {
+			put16(&args[3 * i], addr[i]);
+			args[3 * i + 2] = value[i];
+		}
+		ret = CLIENT_Request(c, COMMAND_REG_WRITE, args, 3 * count, NULL, 0);
+		if (ret < 0)
+			return ret;
+	}
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Read parameters
+ * @param  c the client
+ * @param  id parameter ids Param_IdTypeDef
+ * @param  value output: parameter values
+ * @param  n number of parameters
+ * @retval CLIENT_OK or CLIENT_ERR_xx
+ */
+int CLIENT_GetParams(Client_TypeDef *c, const uint8_t *id, int32_t *value, int n) {
+	uint8_t result[4 * COMMAND_MAX_ITEMS];
+	int i, count, ret;
+
+	for ( ; n > 0; n -= count, id += count, value += count) {
+		count = n > COMMAND_MAX_ITEMS ? COMMAND_MAX_ITEMS : n;
+		ret = CLIENT_Request(c, COMMAND_PARAM_GET, id, count, result, sizeof(result));
+		if (ret < 0)
+			return ret;
+		if (ret != 4 * count)
+			return CLIENT_ERR_FORMAT;
+		for (i = 0; i < count; i++)
+			value[i] = (int32_t) get32(&result[4 * i]);
+	}
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Set parameters. Nothing is set, if one value is out of range.
+ * @param  c the client
+ * @param  id parameter ids Param_IdTypeDef
+ * @param  value the values, they are replaced by the values that were set
+ * @param  n number of parameters
+ * @retval CLIENT_OK or CLIENT_ERR_xx
+ */
+int CLIENT_SetParams(Client_TypeDef *c, const uint8_t *id, int32_t *value, int n) {
+	uint8_t args[5 * COMMAND_MAX_ITEMS];
+	uint8_t result[4 * COMMAND_MAX_ITEMS];
+	int i, count, ret;
+
+	for ( ; n > 0; n -= count, id += count, value += count) {
+		count = n > COMMAND_MAX_ITEMS ? COMMAND_MAX_ITEMS : n;
+		for (i = 0; i < count; i++) {
+			args[5 * i] = id[i];
+			put32(&args[5 * i + 1], value[i]);
+		}
+		ret = CLIENT_Request(c, COMMAND_PARAM_SET, args, 5 * count, result,
+				sizeof(result));
+		if (ret < 0)
+			return ret;
+		if (ret != 4 * count)
+			return CLIENT_ERR_FORMAT;
+		for (i = 0; i < count; i++)
+			value[i] = (int32_t) get32(&result[4 * i]);
+	}
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Control the streams. A negative value keeps the setting.
+ * @param  c the client
+ * @param  mode frame stream mode (0: off, 1: raw, 2: delta, 3: record)
+ * @param  telemetry 1: telemetry on
+ * @param  trace 1: trace on
+ * @param  counters output: counters before the change, may be NULL
+ * @retval CLIENT_OK or CLIENT_ERR_xx
+ */
+int CLIENT_Stream(Client_TypeDef *c, int mode, int telemetry, int trace,
+		Client_StreamTypeDef *counters) {
+	uint8_t args[3], result[20];
+	int ret;
+
+	args[0] = mode < 0 ? COMMAND_UNCHANGED : mode;
+	args[1] = telemetry < 0 ? COMMAND_UNCHANGED : telemetry;
+	args[2] = trace < 0 ? COMMAND_UNCHANGED : trace;
+	ret = CLIENT_Request(c, COMMAND_STREAM, args, sizeof(args), result,
+			sizeof(result));
+	if (ret < 0)
+		return ret;
+	if (ret != sizeof(result))
+		return CLIENT_ERR_FORMAT;
+	if (counters) {
+		counters->frames_sent = get32(&result[0]);
+		counters->frames_skipped = get32(&result[4]);
+		counters->telemetry_dropped = get32(&result[8]);
+		counters->trace_dropped = get32(&result[12]);
+		counters->uart_dropped = get32(&result[16]);
+	}
+	return CLIENT_OK;
+}
+
+/**
+ * @brief  Read the names and ranges of all parameters
+ * @param  c the client
+ * @param  param output: the parameters, index is the id
+ * @param  max size of param
+ * @retval number of parameters, up to max, or CLIENT_ERR_xx
+ */
+int CLIENT_ParamInfo(Client_TypeDef *c, Client_ParamTypeDef *param, int max) {
+	uint8_t result[1 + COMMAND_MAX_INFO * COMMAND_PARAM_INFO_SIZE];
+	uint8_t id[COMMAND_MAX_INFO];
+	const uint8_t *info;
+	int i, n, first, count, ret;
+
+	// The first request only asks for the number of parameters
+	ret = CLIENT_Request(c, COMMAND_PARAM_INFO, NULL, 0, result, sizeof(result));
+	if (ret < 0)
+		return ret;
+	if (ret != 1)
+		return CLIENT_ERR_FORMAT;
+	n = result[0] < max ? result[0] : max;
+
+	for (first = 0; first < n; first += count) {
+		count = n - first > COMMAND_MAX_INFO ? COMMAND_MAX_INFO : n - first;
+		for (i = 0; i < count; i++)
+			id[i] = first + i;
+		ret = CLIENT_Request(c, COMMAND_PARAM_INFO, id, count, result,
+				sizeof(result));
+		if (ret < 0)
+			return ret;
+		if (ret != 1 + count * COMMAND_PARAM_INFO_SIZE)
+			return CLIENT_ERR_FORMAT;
+		for (i = 0; i < count; i++) {
+			info = &result[1 + i * COMMAND_PARAM_INFO_SIZE];
+			param[first + i].type = info[0];
+			param[first + i].min = (int32_t) get32(&info[1]);
+			param[first + i].max = (int32_t) get32(&info[5]);
+			param[first + i].def = (int32_t) get32(&info[9]);
+			memcpy(param[first + i].name, &info[13], PARAM_NAME_LEN);
+			param[first + i].name[PARAM_NAME_LEN] = 0;
+		}
+	}
+	return n;
+}
@@ -0,0 +1,86 @@
+/**
+ *  Project     Campos
+ *  @file		client.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for client.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CLIENT_H_
+#define CLIENT_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "command.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define CLIENT_TIMEOUT_MS		500
+#define CLIENT_RETRIES			2
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	CLIENT_OK = 0,
+	CLIENT_ERR_IO = -1,			// The port could not be opened or written
+	CLIENT_ERR_TIMEOUT = -2,	// No response
+	CLIENT_ERR_STATUS = -3,		// The tracker answered with an error status
+	CLIENT_ERR_FORMAT = -4		// The response does not fit to the request
+} Client_ResultTypeDef;
+
+typedef struct {
+	int fd;
+	int tty;					// It's a serial port
+	int baud;					// Baud index that was set, see usartl2.c
+	uint16_t seq;				// Sequence number of the last request
+	int timeout_ms;
+	Command_StatusTypeDef status;	// Status of the last response
+	uint32_t retries;			// Requests that were sent again
+} Client_TypeDef;
+
+typedef struct {
+	uint32_t frames_sent;
+	uint32_t frames_skipped;
+	uint32_t telemetry_dropped;
+	uint32_t trace_dropped;
+	uint32_t uart_dropped;
+} Client_StreamTypeDef;
+
+typedef struct {
+	char name[PARAM_NAME_LEN + 1];
+	Param_TypeTypeDef type;
+	int32_t min;
+	int32_t max;
+	int32_t def;				// Value after reset
+} Client_ParamTypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+int CLIENT_Open(Client_TypeDef *c, const char *port, int baud);
+void CLIENT_Close(Client_TypeDef *c);
+int CLIENT_Request(Client_TypeDef *c, uint8_t cmd, const uint8_t *args, int n,
+		uint8_t *result, int max);
+int CLIENT_Ping(Client_TypeDef *c, int *version, uint16_t *frame, uint32_t *tick_ms);
+int CLIENT_ReadRegs(Client_TypeDef *c, const uint16_t *addr, uint8_t *value, int n);
+int CLIENT_WriteRegs(Client_TypeDef *c, const uint16_t *addr, const uint8_t *value,
+		int n);
+int CLIENT_GetParams(Client_TypeDef *c, const uint8_t *id, int32_t *value, int n);
+int CLIENT_SetParams(Client_TypeDef *c, const uint8_t *id, int32_t *value, int n);
+int CLIENT_Stream(Client_TypeDef *c, int mode, int telemetry, int trace,
+		Client_StreamTypeDef *counters);
+int CLIENT_ParamInfo(Client_TypeDef *c, Client_ParamTypeDef *param, int max);
+
+#endif /* CLIENT_H_ */
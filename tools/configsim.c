@@ -0,0 +1,201 @@
+/**
+ *  Project     Campos
+ *  @file		configsim.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: key value store on a simulated flash with power fails
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o configsim configsim.c \
+ *             ../Campos/src/config.c ../Campos/src/crc.c
+ *
+ *  Usage: configsim [-n writes] [-k keys] [-p power fail probability]
+ *
+ *  Runs config.c of the firmware on 2 small simulated sectors, so the
+ *  sectors fill up and are copied often. Random values are written and
+ *  the power fails at random flash operations: a word is only partly
+ *  programmed, or a sector only partly erased. After each reset, every
+ *  key must have its last completely written value, or the value that
+ *  was being written. The number of wrong values is printed, and the
+ *  erase count of the sectors.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include "config.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SECTOR_WORDS	64		// 31 records per sector
+
+/* global variables ---------------------------------------------------------*/
+// The simulated flash driver
+static uint32_t flash[CONFIG_SECTORS][SECTOR_WORDS];
+volatile uint32_t * const config_sectors[CONFIG_SECTORS] = {
+	flash[0], flash[1]
+};
+const uint32_t config_sector_words = SECTOR_WORDS;
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+static uint32_t fail_threshold;		// Power fail probability * 2^32
+static jmp_buf power_fail;
+static long erases[CONFIG_SECTORS];
+static long programs;
+static long power_fails;
+
+// The test state is static, so it is kept by longjmp()
+static uint32_t durable[CONFIG_MAX_KEYS];	// Last completely written values
+static int known[CONFIG_MAX_KEYS];			// The key was written
+static int flight_key = -1;					// Key that is being written
+static uint32_t flight_value;
+static long writes = 100000, n, wrong, resets, full_resets;
+static int keys = 20;
+
+/**
+ * @brief  Pseudo random number (xorshift32), reproducible on all hosts
+ * @retval random number
+ */
+static uint32_t rnd(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/**
+ * @brief  Erase a simulated sector. A power fail leaves some words.
+ */
+int CONFIG_FlashErase(int sector) {
+	int i;
+
+	erases[sector]++;
+	if (rnd() < fail_threshold) {
+		for (i = 0; i < SECTOR_WORDS; i++)
+			if (rnd() & 1)
+				flash[sector][i] = CONFIG_ERASED;
+		power_fails++;
+		longjmp(power_fail, 1);
+	}
+	for (i = 0; i < SECTOR_WORDS; i++)
+		flash[sector][i] = CONFIG_ERASED;
+	return 0;
+}
+
+/**
+ * @brief  Program a simulated word. Bits can only be cleared. A power
+ * 		   fail clears only some of the bits.
+ */
+int CONFIG_FlashProgram(volatile uint32_t *address, uint32_t value) {
+	programs++;
+	if (rnd() < fail_threshold) {
+		*address &= value | rnd();
+		power_fails++;
+		longjmp(power_fail, 1);
+	}
+	*address &= value;
+	return (*address == value) ? 0 : -1;
+}
+
+/**
+ * @brief  Reset: read the store again and compare the values
+ */
+static void reset(void) {
+	uint32_t value;
+	int k, found;
+
+	resets++;
+	if (config_full)
+		full_resets++;
+	CONFIG_Init();
+
+	for (k = 0; k < keys; k++) {
+		found = (CONFIG_Read(k, &value) == 0);
+		if (k == flight_key && found && value == flight_value) {
+			durable[k] = value;
+			known[k] = 1;
+		} else if (found != known[k] || (found && value != durable[k])) {
+			wrong++;
+			printf("write %ld: key %d is %s%u, expected %s%u\n", n, k,
+					found ? "" : "missing ", found ? value : 0,
+					known[k] ? "" : "missing ", known[k] ? durable[k] : 0);
+			durable[k] = value;
+			known[k] = found;
+		}
+	}
+	flight_key = -1;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	double probability = 0.002;
+	int i, k, restart = 1;
+
+	for (i = 1; i < argc - 1; i += 2) {
+		if (strcmp(argv[i], "-n") == 0)
+			writes = atol(argv[i + 1]);
+		else if (strcmp(argv[i], "-k") == 0)
+			keys = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-p") == 0)
+			probability = atof(argv[i + 1]);
+	}
+	if (keys < 1 || keys > CONFIG_MAX_KEYS || writes < 1 || probability < 0
+			|| probability >= 1 || (argc % 2) == 0) {
+		fprintf(stderr, "Usage: %s [-n writes] [-k keys 1..%d] "
+				"[-p power fail probability]\n", argv[0], CONFIG_MAX_KEYS);
+		return 1;
+	}
+	fail_threshold = probability * 4294967296.0;
+	memset(flash, 0xFF, sizeof(flash));
+
+	for (n = 0; n < writes; n++) {
+
+		// Reset after a power fail, or if there is no space
+		if (setjmp(power_fail))
+			restart = 1;
+		if (restart || config_full) {
+			restart = 0;
+			reset();
+		}
+
+		// Write a value and wait until it is programmed
+		k = rnd() % keys;
+		flight_key = k;
+		flight_value = rnd();
+		CONFIG_Write(k, flight_value);
+		while (CONFIG_Pending() && !config_full)
+			CONFIG_Task();
+		if (!config_full) {
+			durable[k] = flight_value;
+			known[k] = 1;
+			flight_key = -1;
+		}
+	}
+
+	printf("%ld writes, %d keys, %ld word programs, %ld power fails\n",
+			writes, keys, programs, power_fails);
+	printf("%ld resets, %ld of them because both sectors were used\n",
+			resets, full_resets);
+	printf("sector erases: %ld %ld, flash errors %u\n", erases[0], erases[1],
+			config_errors);
+	printf("%ld wrong values\n", wrong);
+	return wrong != 0;
+}
@@ -0,0 +1,136 @@
+/**
+ *  Project     Campos
+ *  @file		crcbench.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: throughput of the table driven CRC against a bitwise one
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o crcbench crcbench.c ../Campos/src/crc.c
+ *
+ *  Usage: crcbench [MBytes]
+ *
+ *  Checks crc.c against bitwise reference implementations and the
+ *  check values of CRC-32/MPEG-2 and CRC-16/CCITT-FALSE, then prints
+ *  the throughput of both.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "crc.h"
+
+/**
+ * @brief  Bitwise CRC-32 like the STM32 CRC unit
+ */
+static uint32_t crc32_bitwise(uint32_t crc, const uint32_t *data, int n) {
+	int bit;
+
+	while (n-- > 0) {
+		crc ^= *data++;
+		for (bit = 0; bit < 32; bit++)
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+	}
+	return crc;
+}
+
+/**
+ * @brief  Bitwise CRC-16 CCITT over 16 bit words
+ */
+static uint16_t crc16_bitwise(uint16_t crc, const uint16_t *data, int n) {
+	int bit;
+
+	while (n-- > 0) {
+		crc ^= *data++;
+		for (bit = 0; bit < 16; bit++)
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+	}
+	return crc;
+}
+
+/**
+ * @brief  Time in seconds
+ */
+static double now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	const uint8_t check[] = "123456789";
+	uint32_t *buf, c1, c2;
+	uint16_t s1, s2;
+	int mbytes = 16, words, i, errors = 0;
+	double t0, t_bit32, t_tab32, t_bit16, t_tab16;
+
+	if (argc > 1)
+		mbytes = atoi(argv[1]);
+	if (mbytes < 1)
+		mbytes = 1;
+	words = mbytes * 1024 * 1024 / 4;
+	buf = malloc(words * sizeof(uint32_t));
+	if (buf == NULL)
+		return 1;
+	srand(1);
+	for (i = 0; i < words; i++)
+		buf[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+
+	// Check values
+	c1 = CRC_Crc32Bytes(CRC32_INIT, check, 9);
+	s1 = CRC_Crc16Bytes(CRC16_INIT, check, 9);
+	printf("CRC-32/MPEG-2 check:      %08X %s\n", c1, c1 == 0x0376E6E7 ? "ok" : "FAIL");
+	printf("CRC-16/CCITT-FALSE check: %04X %s\n", s1, s1 == 0x29B1 ? "ok" : "FAIL");
+	errors += (c1 != 0x0376E6E7) + (s1 != 0x29B1);
+
+	// All lengths up to 64 words
+	for (i = 0; i < 64; i++) {
+		if (CRC_Crc32(CRC32_INIT, buf, i) != crc32_bitwise(CRC32_INIT, buf, i))
+			errors++;
+		if (CRC_Crc16(CRC16_INIT, (uint16_t *)buf, i) != crc16_bitwise(CRC16_INIT, (uint16_t *)buf, i))
+			errors++;
+	}
+
+	t0 = now();
+	c1 = crc32_bitwise(CRC32_INIT, buf, words);
+	t_bit32 = now() - t0;
+	t0 = now();
+	c2 = CRC_Crc32(CRC32_INIT, buf, words);
+	t_tab32 = now() - t0;
+	t0 = now();
+	s1 = crc16_bitwise(CRC16_INIT, (uint16_t *)buf, words * 2);
+	t_bit16 = now() - t0;
+	t0 = now();
+	s2 = CRC_Crc16(CRC16_INIT, (uint16_t *)buf, words * 2);
+	t_tab16 = now() - t0;
+	errors += (c1 != c2) + (s1 != s2);
+
+	printf("%d MB\n", mbytes);
+	printf("CRC-32 bitwise:     %8.1f MB/s\n", mbytes / t_bit32);
+	printf("CRC-32 slice-by-4:  %8.1f MB/s (%.1fx)\n", mbytes / t_tab32, t_bit32 / t_tab32);
+	printf("CRC-16 bitwise:     %8.1f MB/s\n", mbytes / t_bit16);
+	printf("CRC-16 slice-by-2:  %8.1f MB/s (%.1fx)\n", mbytes / t_tab16, t_bit16 / t_tab16);
+	printf("%s\n", errors ? "MISMATCH" : "results are equal");
+
+	free(buf);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,33 @@
+/**
+ *  Project     Campos
+ *  @file		stm32f4_discovery.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tools: replaces the board support header of the firmware
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The host tools compile some firmware modules, e.g. track.c for the
+ *  replay. Their headers include the HAL, but only need the integer types.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HOST_STM32F4_DISCOVERY_H_
+#define HOST_STM32F4_DISCOVERY_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#endif /* HOST_STM32F4_DISCOVERY_H_ */
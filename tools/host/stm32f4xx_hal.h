@@ -0,0 +1,43 @@
+/**
+ *  Project     Campos
+ *  @file		stm32f4xx_hal.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tools: replaces the HAL header of the firmware
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The host tools compile some firmware modules, e.g. track.c for the
+ *  replay. Their headers include the HAL, but only need the integer types
+ *  and the handles of the debug port.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HOST_STM32F4XX_HAL_H_
+#define HOST_STM32F4XX_HAL_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Type defs -----------------------------------------------------------------*/
+typedef struct {
+	int dummy;
+} UART_HandleTypeDef;
+
+typedef struct {
+	int dummy;
+} DMA_HandleTypeDef;
+
+#endif /* HOST_STM32F4XX_HAL_H_ */
@@ -0,0 +1,170 @@
+/**
+ *  Project     Campos
+ *  @file		irdeltabench.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: airtime benchmark of the compact IR packets
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o irdeltabench irdeltabench.c \
+ *             ../Campos/src/irpacket.c ../Campos/src/crc.c
+ *
+ *  Usage: irdeltabench [-k key interval] [-l loss rate] [-s symbol us]
+ *                      < trajectory
+ *
+ *  The trajectory is the output of the 'h' debug command, one frame per
+ *  line: time;status;x.xxx;y.yyy;intensity
+ *  The time is given in ms, so the time stamp of a packet is the frame
+ *  number times the nominal frame period with a jitter of +-10us.
+ *  Each frame is sent as normal and as compact packet. Compact packets
+ *  are lost with the given rate. The tool prints the average bits per
+ *  frame and the worst case latency from the capture of a frame to the
+ *  next position the receiver can decode.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "irpacket.h"
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+
+/**
+ * @brief  Pseudo random number from 0 to 1 (xorshift32)
+ */
+static double rnd_unit(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return (rnd_state >> 8) / 16777216.0;
+}
+
+/**
+ * @brief  Compare two targets field by field
+ * @retval 1 if they are equal
+ */
+static int same_target(const IrPacket_TargetTypeDef *a,
+		const IrPacket_TargetTypeDef *b) {
+	return a->x == b->x && a->y == b->y && a->status == b->status
+			&& a->intensity == b->intensity;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	IrPacket_DeltaTypeDef encoder, decoder;
+	IrPacket_TypeDef packet, received;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	char line[256];
+	int key_interval = IRPACKET_KEY_INTERVAL, symbol_us = 100;
+	double loss = 0.0;
+	unsigned long time, first_time = 0, last_ok_time = 0, frame;
+	int status, x, subx, y, suby, intensity;
+	int i, n, frames = 0, lost = 0, errors = 0, waiting = 0;
+	long bits_normal = 0, bits_compact = 0, n_key = 0;
+	long airtime_us, latency_us, worst_us = 0;
+
+	for (i = 1; i < argc - 1; i += 2) {
+		if (strcmp(argv[i], "-k") == 0)
+			key_interval = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-l") == 0)
+			loss = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-s") == 0)
+			symbol_us = atoi(argv[i + 1]);
+	}
+	if (key_interval < 1 || symbol_us < 1 || (argc % 2) == 0) {
+		fprintf(stderr, "Usage: %s [-k key interval] [-l loss rate] [-s symbol us]"
+				" < trajectory\n", argv[0]);
+		return 1;
+	}
+
+	IRPACKET_DeltaInit(&encoder, key_interval);
+	IRPACKET_DeltaInit(&decoder, key_interval);
+	memset(&packet, 0, sizeof(packet));
+	packet.targets = 1;
+
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		if (sscanf(line, "%lu;%d;%d.%d;%d.%d;%d", &time, &status, &x, &subx,
+				&y, &suby, &intensity) != 7)
+			continue;
+
+		// Frame number from the time, skipped frames are left out
+		if (frames == 0)
+			first_time = time;
+		frame = ((time - first_time) * 1000 + IRPACKET_FRAME_US / 2)
+				/ IRPACKET_FRAME_US;
+		packet.seq = (uint16_t)frame;
+		packet.timestamp = (uint32_t)(first_time * 1000 + frame * IRPACKET_FRAME_US
+				+ (long)(rnd_unit() * 21.0) - 10);
+		IRPACKET_SetTarget(&packet.target[0], status, x, subx, y, suby, intensity);
+
+		bits_normal += IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS) * 16;
+		n = IRPACKET_EncodeCompact(&encoder, &packet, words, IRPACKET_MAX_WORDS);
+		bits_compact += n * 16;
+		if (encoder.since_key == 0)
+			n_key++;
+
+		// Header, pause and 2 symbols per bit
+		airtime_us = (6 + 3 + n * 16 * 2) * (long)symbol_us;
+		frames++;
+
+		if (rnd_unit() < loss) {
+			lost++;
+			if (!waiting)
+				last_ok_time = time;
+			waiting = 1;
+			continue;
+		}
+
+		if (IRPACKET_DecodeCompact(&decoder, &received, words, n) != IRPACKET_OK) {
+			if (!waiting)
+				last_ok_time = time;
+			waiting = 1;
+			continue;
+		}
+		if (!same_target(&received.target[0], &packet.target[0])
+				|| received.seq != packet.seq || received.timestamp != packet.timestamp)
+			errors++;
+
+		// Latency from the first frame without position to this one
+		latency_us = airtime_us;
+		if (waiting)
+			latency_us += (long)(time - last_ok_time) * 1000;
+		if (latency_us > worst_us)
+			worst_us = latency_us;
+		waiting = 0;
+	}
+
+	if (frames == 0) {
+		fprintf(stderr, "no frames\n");
+		return 1;
+	}
+
+	printf("frames:               %d\n", frames);
+	printf("key interval:         %d (%ld key packets)\n", key_interval, n_key);
+	printf("normal bits/frame:    %.1f\n", (double)bits_normal / frames);
+	printf("compact bits/frame:   %.1f (%.1f%%)\n", (double)bits_compact / frames,
+			100.0 * bits_compact / bits_normal);
+	printf("lost packets:         %d (%.1f%%)\n", lost, 100.0 * lost / frames);
+	printf("worst case latency:   %.1f ms\n", worst_us / 1000.0);
+	printf("decode errors:        %d\n", errors);
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+/**
+ *  Project     Campos
+ *  @file		irfecsim.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: IR channel simulator for the forward error correction
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o irfecsim irfecsim.c \
+ *             ../Campos/src/irpacket.c ../Campos/src/irfec.c ../Campos/src/crc.c
+ *
+ *  Usage: irfecsim [-n packets] [-t targets] [-b burst length]
+ *
+ *  Sends random packets through a channel with independent bit errors
+ *  and prints the packet loss of each FEC mode against the bit error
+ *  rate. With -b, each error flips a burst of bits instead of one bit.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "irpacket.h"
+#include "irfec.h"
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+
+static const double ber_list[] = {
+	1e-4, 3e-4, 1e-3, 3e-3, 1e-2, 2e-2, 3e-2, 5e-2
+};
+#define BER_COUNT	(sizeof(ber_list) / sizeof(ber_list[0]))
+
+static const char * const mode_names[IRFEC_MODES] = {
+	"none", "hamming", "interleaved"
+};
+
+/**
+ * @brief  Pseudo random number (xorshift32), reproducible on all hosts
+ * @retval random number
+ */
+static uint32_t rnd(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/**
+ * @brief  Random number from 0 to 1
+ */
+static double rnd_unit(void) {
+	return (rnd() >> 8) / 16777216.0;
+}
+
+/**
+ * @brief  Flip bits of the coded words
+ * @param  words the coded words
+ * @param  n number of words
+ * @param  ber probability, that an error starts at a bit
+ * @param  burst number of bits flipped per error
+ */
+static void channel(uint16_t *words, int n, double ber, int burst) {
+	int pos, i;
+
+	for (pos = 0; pos < n * 16; pos++) {
+		if (rnd_unit() >= ber)
+			continue;
+		for (i = 0; i < burst && pos < n * 16; i++, pos++) {
+			words[pos / 16] ^= 0x8000 >> (pos % 16);
+		}
+	}
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	IrPacket_TypeDef packet, received;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	uint16_t coded[IRFEC_MAX_WORDS];
+	uint16_t decoded[IRFEC_MAX_WORDS];
+	int packets = 100000, targets = 1, burst = 1;
+	int mode, b, p, i, n, coded_n, decoded_n;
+	long lost[IRFEC_MODES];
+
+	for (i = 1; i < argc - 1; i += 2) {
+		if (strcmp(argv[i], "-n") == 0)
+			packets = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-t") == 0)
+			targets = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-b") == 0)
+			burst = atoi(argv[i + 1]);
+	}
+	if (targets < 1 || targets > IRPACKET_MAX_TARGETS || burst < 1
+			|| packets < 1 || (argc % 2) == 0) {
+		fprintf(stderr, "Usage: %s [-n packets] [-t targets 1..%d] [-b burst]\n",
+				argv[0], IRPACKET_MAX_TARGETS);
+		return 1;
+	}
+
+	// Length of the packets
+	memset(&packet, 0, sizeof(packet));
+	packet.targets = targets;
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+	printf("%d packets, %d target(s), burst %d bit(s)\n", packets, targets, burst);
+	printf("words per packet:");
+	for (mode = 0; mode < IRFEC_MODES; mode++)
+		printf(" %s %d", mode_names[mode],
+				IRFEC_Encode(mode, words, n, coded, IRFEC_MAX_WORDS));
+	printf("\n\n%-8s", "BER");
+	for (mode = 0; mode < IRFEC_MODES; mode++)
+		printf(" %12s", mode_names[mode]);
+	printf("\n");
+
+	for (b = 0; b < (int) BER_COUNT; b++) {
+		for (mode = 0; mode < IRFEC_MODES; mode++)
+			lost[mode] = 0;
+
+		for (p = 0; p < packets; p++) {
+			packet.seq = (uint16_t)p;
+			packet.timestamp = (uint16_t)rnd();
+			for (i = 0; i < targets; i++) {
+				IRPACKET_SetTarget(&packet.target[i], rnd() % 5,
+						rnd() % 2592, rnd() % 1000, rnd() % 1944, rnd() % 1000,
+						rnd() % 4000000);
+			}
+			n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+
+			for (mode = 0; mode < IRFEC_MODES; mode++) {
+				coded_n = IRFEC_Encode(mode, words, n, coded, IRFEC_MAX_WORDS);
+				channel(coded, coded_n, ber_list[b], burst);
+				decoded_n = IRFEC_Decode(mode, coded, coded_n, decoded,
+						IRFEC_MAX_WORDS, NULL);
+
+				// A packet is lost, if the CRC fails or the content is wrong
+				if (IRPACKET_Decode(&received, decoded, decoded_n) != IRPACKET_OK
+						|| memcmp(decoded, words, n * sizeof(uint16_t)) != 0)
+					lost[mode]++;
+			}
+		}
+
+		printf("%-8.0e", ber_list[b]);
+		for (mode = 0; mode < IRFEC_MODES; mode++)
+			printf(" %11.3f%%", 100.0 * lost[mode] / packets);
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,309 @@
+/**
+ *  Project     Campos
+ *  @file		irlinecheck.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: IR symbol buffer against the old 500us encoder
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o irlinecheck irlinecheck.c \
+ *             ../Campos/src/irline.c ../Campos/src/irpacket.c \
+ *             ../Campos/src/irfec.c ../Campos/src/crc.c
+ *
+ *  Usage: irlinecheck [-n packets]
+ *
+ *  Random packets are coded without and with FEC and sent by both
+ *  encoders with several symbol periods. The old encoder is the
+ *  bit shifter of IRLINK_500usTask(), which ran in the SysTick interrupt.
+ *  The new one is IRLINE_BuildSymbols(), whose buffer is sent by DMA.
+ *  The header starts at 0us, the data is sent some time later. The
+ *  old tick runs in the phase in which the symbol clock is started.
+ *  The carrier on/off timelines are compared with 1us resolution.
+ *  The exit code is 1, if they differ.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "irpacket.h"
+#include "irfec.h"
+#include "irline.h"
+
+/* Defines ------------------------------------------------------------------*/
+
+// Longest timeline: the data may start 8 symbols after the header
+#define MAX_SYMBOL_US		2000
+#define MAX_TIMELINE_US		((IRLINE_SYMBOLS(IRFEC_MAX_WORDS) + 8 + 2) * MAX_SYMBOL_US)
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+
+static const int symbol_periods[] = { 100, 250, 333, 500, 1000, 2000 };
+
+static uint8_t timeline_old[MAX_TIMELINE_US];
+static uint8_t timeline_new[MAX_TIMELINE_US];
+
+// State of the old encoder, as in IRLINK_500usTask()
+static uint16_t irdata[IRFEC_MAX_WORDS];
+static int irwords;
+static int header_cnt;
+static int header_endcnt;
+static int send_data;
+static int data_phase_cnt;
+static int data_bit_cnt;
+static int data_word_cnt;
+static int output;
+
+/**
+ * @brief  Pseudo random number (xorshift32)
+ */
+static uint32_t rnd(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/**
+ * @brief  Carrier on or off, like IRLINK_Output()
+ */
+static void old_output(int value) {
+	output = (value != 0);
+}
+
+/**
+ * @brief  The header of IRLINK_StartHeader()
+ */
+static void old_start_header(void) {
+	old_output(1);
+	header_cnt = 5 + 1;
+}
+
+/**
+ * @brief  The start of the data of IRLINK_Send(), but with any number
+ * 		   of words
+ */
+static void old_send(const uint16_t *data, int words) {
+	memcpy(irdata, data, words * sizeof(uint16_t));
+	irwords = words;
+	data_phase_cnt = 0;
+	data_bit_cnt = 0;
+	data_word_cnt = 0;
+	header_endcnt = 3;
+	send_data = 1;
+}
+
+/**
+ * @brief  The old IRLINK_500usTask()
+ */
+static void old_task(void) {
+
+	// Header is n ms high and then one ms low.
+	if (header_cnt > 0) {
+		header_cnt--;
+
+	} else if(send_data) {
+		if (header_endcnt > 0) {
+			// pause x ms
+			header_endcnt--;
+			old_output(0);
+		} else {
+			// Send now the data
+			if (data_word_cnt < irwords) {
+
+				// Manchester code
+				if (data_phase_cnt == 0) {
+					if (irdata[data_word_cnt] & 0x8000) {
+						old_output(1);
+					} else {
+						old_output(0);
+					}
+				} else {
+					if (irdata[data_word_cnt] & 0x8000) {
+						old_output(0);
+					} else {
+						old_output(1);
+					}
+				}
+
+				// Next phase
+				data_phase_cnt++;
+				if (data_phase_cnt >= 2 ) {
+
+					// Next bit
+					irdata[data_word_cnt] <<= 1;
+					data_phase_cnt = 0;
+					data_bit_cnt ++;
+					if (data_bit_cnt >= 16 ) {
+
+						// Next word (16bit)
+						data_bit_cnt = 0;
+						data_word_cnt ++;
+					}
+				}
+			} else {
+				// finished
+				old_output(0);
+				send_data = 0;
+			}
+		}
+	}
+}
+
+/**
+ * @brief  Timeline of the old encoder. The task runs every symbol_us,
+ * 		   one tick is at send_us.
+ * @retval length of the timeline in us
+ */
+static int old_timeline(const uint16_t *data, int words, int symbol_us,
+		int send_us) {
+	int t, tick, sent = 0;
+
+	tick = send_us % symbol_us;
+	old_start_header();
+	for (t = 0; t < MAX_TIMELINE_US; t++) {
+		if (t == tick) {
+			// The data is ready just before this tick
+			if (t == send_us) {
+				old_send(data, words);
+				sent = 1;
+			}
+			old_task();
+			tick += symbol_us;
+		}
+		timeline_old[t] = output;
+		if (sent && !send_data)
+			return t + 1;
+	}
+	return t;
+}
+
+/**
+ * @brief  Timeline of the symbol buffer. It is started at send_us,
+ * 		   the header is shortened like in IRLINK_SendQueued().
+ * @retval length of the timeline in us
+ */
+static int new_timeline(const uint16_t *data, int words, int symbol_us,
+		int send_us) {
+	uint16_t symbols[IRLINE_SYMBOLS(IRFEC_MAX_WORDS)];
+	int header_symbols, n, t = 0, i;
+
+	header_symbols = IRLINE_HEADER_SYMBOLS - send_us / symbol_us;
+	if (header_symbols < 0)
+		header_symbols = 0;
+	n = IRLINE_BuildSymbols(symbols, data, words, header_symbols, 1);
+
+	// The header started at 0
+	while (t < send_us)
+		timeline_new[t++] = 1;
+
+	// One symbol per period of the symbol clock
+	for (i = 0; i < n; i++) {
+		while (t < send_us + (i + 1) * symbol_us)
+			timeline_new[t++] = (symbols[i] != 0);
+	}
+	return t;
+}
+
+/**
+ * @brief  Compare both timelines until the end of the longer one
+ * @retval 1 if they are equal
+ */
+static int compare(int n_old, int n_new, const char *name, int symbol_us,
+		int send_us) {
+	int n = (n_old > n_new) ? n_old : n_new;
+	int t, a, b;
+
+	for (t = 0; t < n; t++) {
+		a = (t < n_old) ? timeline_old[t] : 0;
+		b = (t < n_new) ? timeline_new[t] : 0;
+		if (a != b) {
+			printf("%s, symbol %d us, data at %d us: old %d new %d at %d us\n",
+					name, symbol_us, send_us, a, b, t);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	static const char * const fec_names[IRFEC_MODES] = {
+		"no FEC", "Hamming", "interleaved"
+	};
+	IrPacket_TypeDef packet;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	uint16_t coded[IRFEC_MAX_WORDS];
+	int packets = 200, checked = 0, failed = 0;
+	int opt, p, i, s, fec, n, coded_n, symbol_us, send_us;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n': packets = atoi(optarg); break;
+		default:
+			fprintf(stderr, "Usage: %s [-n packets]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	for (p = 0; p < packets; p++) {
+		// Random packet with 1 to 4 targets
+		memset(&packet, 0, sizeof(packet));
+		packet.seq = (uint16_t)rnd();
+		packet.timestamp = rnd();
+		packet.flags = IRPACKET_FLAG_SYNC;
+		if (rnd() & 1) {
+			packet.flags |= IRPACKET_FLAG_LATENCY;
+			packet.latency = (uint16_t)rnd();
+		}
+		packet.targets = 1 + rnd() % IRPACKET_MAX_TARGETS;
+		for (i = 0; i < packet.targets; i++)
+			IRPACKET_SetTarget(&packet.target[i], rnd() % 5, rnd() % 2592,
+					rnd() % 1000, rnd() % 1944, rnd() % 1000, rnd() % 0x400000);
+		n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+
+		for (fec = 0; fec < IRFEC_MODES; fec++) {
+			coded_n = IRFEC_Encode((IrFec_ModeTypeDef)fec, words, n, coded,
+					IRFEC_MAX_WORDS);
+			for (s = 0; s < (int)(sizeof(symbol_periods) / sizeof(int)); s++) {
+				symbol_us = symbol_periods[s];
+
+				// Data directly with the header, on a tick, and up to
+				// 8 symbols later, after the end of the header
+				for (i = 0; i < 4; i++) {
+					if (i == 0)
+						send_us = 0;
+					else if (i == 1)
+						send_us = symbol_us * (1 + rnd() % 8);
+					else
+						send_us = rnd() % (8 * symbol_us);
+					checked++;
+					if (!compare(old_timeline(coded, coded_n, symbol_us, send_us),
+							new_timeline(coded, coded_n, symbol_us, send_us),
+							fec_names[fec], symbol_us, send_us))
+						failed++;
+				}
+			}
+		}
+	}
+
+	printf("%d timelines compared, %d differ\n", checked, failed);
+	return failed ? 1 : 0;
+}
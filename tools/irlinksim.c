@@ -0,0 +1,398 @@
+/**
+ *  Project     Campos
+ *  @file		irlinksim.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: IR pulse train decoder and link simulator
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o irlinksim irlinksim.c irrx.c \
+ *             ../Campos/src/irpacket.c ../Campos/src/irfec.c \
+ *             ../Campos/src/irline.c ../Campos/src/crc.c timesync.c -lm
+ *
+ *  Usage: irlinksim -r <trace> [-s symbol us] [-f fec] [-w window]
+ *         irlinksim [-n frames] [-s symbol us] [-p frame us] [-f fec] [-c]
+ *                   [-d drift ppm] [-j jitter us] [-g glitches/s]
+ *                   [-G glitch us] [-w window] [-o trace] [-L]
+ *
+ *  A trace has one edge per line: "<time in us> <level>", level 1 is a
+ *  burst. Lines starting with '#' are ignored.
+ *
+ *  With -r, the trace is decoded and the positions are printed with
+ *  their capture time on the receiver clock. It is estimated from the
+ *  timesync packets over the last -w headers.
+ *  Otherwise random positions are coded like the tracker does, sent
+ *  through a simulated channel and decoded again. The transmitter clock
+ *  drifts by -d ppm, each edge has a gaussian jitter of -j us and random
+ *  pulses up to -G us long are added -g times per second. -o writes the
+ *  simulated trace. With -L the packets carry a random latency. The
+ *  tracker time stamps overflow during the simulation, and the error of
+ *  the estimated capture times is printed.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "irpacket.h"
+#include "irfec.h"
+#include "irline.h"
+#include "irrx.h"
+#include "timesync.h"
+
+/* Defines ------------------------------------------------------------------*/
+
+// Tracker time of the first frame. It overflows after 16.7s
+#define TRACKER_START_US	0xFF000000
+
+/* Type defs ----------------------------------------------------------------*/
+typedef struct {
+	double t_us;
+	int toggle_signal;		// 1: edge of the signal, 0: start or end of noise
+} Event_TypeDef;
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+
+// Sent packets by the low byte of the sequence number, which is sent
+static IrPacket_TypeDef sent[256];
+static int sent_valid[256];
+static double sent_rx_us[256];		// Receiver time of the capture
+static TimeSync_TypeDef timesync;
+static double sync_err_sum = 0, sync_err_max = 0;
+static long sync_n = 0;
+static long n_ok = 0, n_wrong = 0, n_err[6];
+
+static const char * const result_names[] = {
+	"ok", "short", "version", "length", "crc", "reference"
+};
+
+/**
+ * @brief  Pseudo random number from 0 to 1 (xorshift32)
+ */
+static double rnd_unit(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return ((rnd_state >> 8) + 0.5) / 16777216.0;
+}
+
+/**
+ * @brief  Gaussian random number (Box-Muller)
+ */
+static double rnd_gauss(void) {
+	return sqrt(-2.0 * log(rnd_unit())) * cos(2.0 * M_PI * rnd_unit());
+}
+
+/**
+ * @brief  Compare two targets field by field
+ * @retval 1 if they are equal
+ */
+static int same_target(const IrPacket_TargetTypeDef *a,
+		const IrPacket_TargetTypeDef *b) {
+	return a->x == b->x && a->y == b->y && a->status == b->status
+			&& a->intensity == b->intensity;
+}
+
+/**
+ * @brief  Compare events by time
+ */
+static int event_cmp(const void *a, const void *b) {
+	double d = ((const Event_TypeDef *)a)->t_us - ((const Event_TypeDef *)b)->t_us;
+	return (d < 0) ? -1 : (d > 0);
+}
+
+/**
+ * @brief  Print a decoded packet
+ */
+static void print_packet(IrRx_TypeDef *rx, double header_us,
+		IrPacket_ResultTypeDef result, const IrPacket_TypeDef *packet) {
+	int i;
+
+	(void)rx;
+	if (result != IRPACKET_OK) {
+		printf("%.1f error %s\n", header_us, result_names[-result]);
+		return;
+	}
+	if (packet->flags & IRPACKET_FLAG_SYNC)
+		TIMESYNC_Add(&timesync, packet->timestamp, header_us);
+	if (packet->flags & IRPACKET_FLAG_LATENCY)
+		printf("%.1f seq %u latency of the last packet %.1f ms\n", header_us,
+				packet->seq, packet->latency * IRPACKET_LATENCY_US / 1000.0);
+	for (i = 0; i < packet->targets; i++) {
+		printf("%.1f seq %u time %u rx %.1f target %d status %d x %.3f y %.3f intensity %d\n",
+				header_us, packet->seq, packet->timestamp,
+				TIMESYNC_Valid(&timesync) ? TIMESYNC_ToReceiver(&timesync, packet->timestamp) : 0.0, i,
+				packet->target[i].status,
+				IRPACKET_FixedToMilli(packet->target[i].x) / 1000.0,
+				IRPACKET_FixedToMilli(packet->target[i].y) / 1000.0,
+				packet->target[i].intensity << IRPACKET_INTENSITY_SHIFT);
+	}
+}
+
+/**
+ * @brief  Compare a decoded packet with the sent one
+ */
+static void check_packet(IrRx_TypeDef *rx, double header_us,
+		IrPacket_ResultTypeDef result, const IrPacket_TypeDef *packet) {
+	uint8_t seq = (uint8_t)packet->seq;
+	double err;
+	int i, same;
+
+	(void)rx;
+	if (result != IRPACKET_OK) {
+		n_err[-result]++;
+		return;
+	}
+	same = sent_valid[seq] && packet->targets == sent[seq].targets;
+	for (i = 0; same && i < packet->targets; i++)
+		same = same_target(&packet->target[i], &sent[seq].target[i]);
+	if (same && (packet->flags & IRPACKET_FLAG_LATENCY))
+		same = (packet->latency == sent[seq].latency);
+	if (!same) {
+		n_wrong++;
+		return;
+	}
+	n_ok++;
+
+	// Error of the capture time, after the window is filled
+	if (packet->flags & IRPACKET_FLAG_SYNC)
+		TIMESYNC_Add(&timesync, packet->timestamp, header_us);
+	if (timesync.count >= timesync.window) {
+		err = fabs(TIMESYNC_ToReceiver(&timesync, packet->timestamp) - sent_rx_us[seq]);
+		sync_err_sum += err * err;
+		if (err > sync_err_max)
+			sync_err_max = err;
+		sync_n++;
+	}
+}
+
+/**
+ * @brief  Decode a trace file
+ */
+static int decode_trace(const char *name, double symbol_us, IrFec_ModeTypeDef fec,
+		int window) {
+	IrRx_TypeDef rx;
+	FILE *f;
+	char line[256];
+	double t;
+	int level;
+
+	f = fopen(name, "r");
+	if (f == NULL) {
+		perror(name);
+		return 1;
+	}
+
+	IRRX_Init(&rx, symbol_us, fec, print_packet, NULL);
+	TIMESYNC_Init(&timesync, window);
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%lf %d", &t, &level) == 2)
+			IRRX_Edge(&rx, t, level != 0);
+	}
+	IRRX_Flush(&rx);
+	fclose(f);
+
+	fprintf(stderr, "headers %u packets %u errors %u glitches %u\n",
+			rx.counters.headers, rx.counters.packets, rx.counters.errors,
+			rx.counters.glitches);
+	fprintf(stderr, "drift %.1f ppm, rms %.1f us\n", TIMESYNC_DriftPpm(&timesync),
+			timesync.rms);
+	return 0;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	IrRx_TypeDef rx;
+	IrPacket_DeltaTypeDef delta;
+	IrPacket_TypeDef packet;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	uint16_t coded[IRFEC_MAX_WORDS];
+	uint16_t symbols[IRLINE_SYMBOLS(IRFEC_MAX_WORDS)];
+	Event_TypeDef *events;
+	int max_events, n_events;
+	const char *trace_in = NULL, *trace_out = NULL;
+	FILE *out = NULL;
+	double symbol_us = 100, frame_us = 1e6 / 30;
+	double drift_ppm = 0, jitter_us = 0, glitch_rate = 0, glitch_us = 50;
+	double t, t_frame, t_glitch, t_busy = -1, x = 1200, y = 900;
+	IrFec_ModeTypeDef fec = IRFEC_NONE;
+	int frames = 1000, compact = 0, latency = 0, n_sent = 0, window = 64;
+	int opt, frame, i, n, last, signal, noise, level;
+
+	while ((opt = getopt(argc, argv, "r:n:s:p:f:cd:j:g:G:w:o:L")) != -1) {
+		switch (opt) {
+		case 'r': trace_in = optarg; break;
+		case 'n': frames = atoi(optarg); break;
+		case 's': symbol_us = atof(optarg); break;
+		case 'p': frame_us = atof(optarg); break;
+		case 'f': fec = (IrFec_ModeTypeDef)atoi(optarg); break;
+		case 'c': compact = 1; break;
+		case 'd': drift_ppm = atof(optarg); break;
+		case 'j': jitter_us = atof(optarg); break;
+		case 'g': glitch_rate = atof(optarg); break;
+		case 'G': glitch_us = atof(optarg); break;
+		case 'w': window = atoi(optarg); break;
+		case 'o': trace_out = optarg; break;
+		case 'L': latency = 1; break;
+		default:
+			fprintf(stderr, "Usage: %s -r <trace> [-s symbol us] [-f fec] [-w window]\n"
+					"       %s [-n frames] [-s symbol us] [-p frame us] [-f fec] [-c]\n"
+					"          [-d drift ppm] [-j jitter us] [-g glitches/s]"
+					" [-G glitch us] [-w window] [-o trace] [-L]\n", argv[0], argv[0]);
+			return 1;
+		}
+	}
+	if (fec >= IRFEC_MODES || symbol_us <= 0 || frames < 1) {
+		fprintf(stderr, "invalid parameter\n");
+		return 1;
+	}
+
+	if (trace_in != NULL)
+		return decode_trace(trace_in, symbol_us, fec, window);
+
+	if (trace_out != NULL) {
+		out = fopen(trace_out, "w");
+		if (out == NULL) {
+			perror(trace_out);
+			return 1;
+		}
+		fprintf(out, "# symbol %.1f us, fec %d, compact %d\n", symbol_us, fec, compact);
+	}
+
+	max_events = IRLINE_SYMBOLS(IRFEC_MAX_WORDS) + 2 * (int)(symbol_us * 1e-6
+			* IRLINE_SYMBOLS(IRFEC_MAX_WORDS) * glitch_rate * 10 + 10);
+	events = malloc(max_events * sizeof(Event_TypeDef));
+	if (events == NULL)
+		return 1;
+
+	IRPACKET_DeltaInit(&delta, IRPACKET_KEY_INTERVAL);
+	IRRX_Init(&rx, symbol_us, fec, check_packet, NULL);
+	TIMESYNC_Init(&timesync, window);
+	memset(&packet, 0, sizeof(packet));
+	packet.targets = 1;
+	level = 0;
+	t_glitch = -log(rnd_unit()) * 1e6 / (glitch_rate > 0 ? glitch_rate : 1);
+
+	for (frame = 0; frame < frames; frame++) {
+		// Transmitter time runs with the drifting clock
+		t_frame = frame * frame_us * (1.0 + drift_ppm * 1e-6);
+
+		// Random walk of the target
+		x += rnd_gauss() * 2.0;
+		y += rnd_gauss() * 2.0;
+		if (x < 0 || x > 2500) x = 1200;
+		if (y < 0 || y > 1900) y = 900;
+		packet.seq = (uint16_t)frame;
+		packet.flags = IRPACKET_FLAG_SYNC;
+		if (latency) {
+			packet.flags |= IRPACKET_FLAG_LATENCY;
+			packet.latency = 300 + (int)(rnd_unit() * 100);
+		}
+		packet.timestamp = (uint32_t)(TRACKER_START_US + frame * frame_us);
+		IRPACKET_SetTarget(&packet.target[0], 3, (int)x,
+				(int)((x - (int)x) * 1000), (int)y, (int)((y - (int)y) * 1000),
+				200000 + (int)(rnd_gauss() * 3000));
+
+		// Like the tracker, no header while the last packet is sent
+		if (t_frame < t_busy)
+			continue;
+		sent[(uint8_t)packet.seq] = packet;
+		sent_valid[(uint8_t)packet.seq] = 1;
+		sent_rx_us[(uint8_t)packet.seq] = t_frame;
+		n_sent++;
+
+		if (compact)
+			n = IRPACKET_EncodeCompact(&delta, &packet, words, IRPACKET_MAX_WORDS);
+		else
+			n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+		n = IRFEC_Encode(fec, words, n, coded, IRFEC_MAX_WORDS);
+		n = IRLINE_BuildSymbols(symbols, coded, n, IRLINE_HEADER_SYMBOLS, 1);
+		t_busy = t_frame + n * symbol_us * (1.0 + drift_ppm * 1e-6);
+
+		// Edges of the signal
+		n_events = 0;
+		last = 0;
+		for (i = 0; i < n; i++) {
+			if ((symbols[i] != 0) != last) {
+				last = (symbols[i] != 0);
+				t = t_frame + i * symbol_us * (1.0 + drift_ppm * 1e-6);
+				if (jitter_us > 0)
+					t += rnd_gauss() * jitter_us;
+				events[n_events].t_us = t;
+				events[n_events].toggle_signal = 1;
+				n_events++;
+			}
+		}
+
+		// Noise pulses until the end of the packet
+		while (glitch_rate > 0 && t_glitch < t_busy
+				&& n_events < max_events - 2) {
+			events[n_events].t_us = t_glitch;
+			events[n_events].toggle_signal = 0;
+			events[n_events + 1].t_us = t_glitch + rnd_unit() * glitch_us;
+			events[n_events + 1].toggle_signal = 0;
+			n_events += 2;
+			t_glitch += -log(rnd_unit()) * 1e6 / glitch_rate;
+		}
+
+		// The received level is signal xor noise
+		qsort(events, n_events, sizeof(Event_TypeDef), event_cmp);
+		signal = 0;
+		noise = 0;
+		for (i = 0; i < n_events; i++) {
+			if (events[i].toggle_signal)
+				signal = !signal;
+			else
+				noise = !noise;
+			if ((signal ^ noise) != level) {
+				level = signal ^ noise;
+				IRRX_Edge(&rx, events[i].t_us, level);
+				if (out != NULL)
+					fprintf(out, "%.1f %d\n", events[i].t_us, level);
+			}
+		}
+	}
+	IRRX_Flush(&rx);
+	if (out != NULL)
+		fclose(out);
+	free(events);
+
+	printf("frames %d, symbol %.0f us, fec %d, compact %d\n", frames, symbol_us,
+			fec, compact);
+	printf("drift %.0f ppm, jitter %.1f us, %.0f glitches/s up to %.0f us\n",
+			drift_ppm, jitter_us, glitch_rate, glitch_us);
+	printf("headers %u, glitches removed %u\n", rx.counters.headers,
+			rx.counters.glitches);
+	printf("sent %d, ok %ld (%.2f%%), wrong %ld\n", n_sent, n_ok,
+			100.0 * n_ok / n_sent, n_wrong);
+	printf("errors: short %ld, length %ld, crc %ld, reference %ld\n",
+			n_err[-IRPACKET_ERR_SHORT], n_err[-IRPACKET_ERR_LENGTH],
+			n_err[-IRPACKET_ERR_CRC], n_err[-IRPACKET_ERR_REFERENCE]);
+	printf("time sync: window %d, drift %.1f ppm (true %.1f), rejected %u, restarts %u\n",
+			window, TIMESYNC_DriftPpm(&timesync), drift_ppm, timesync.rejected,
+			timesync.restarts);
+	if (sync_n > 0)
+		printf("capture time error: rms %.2f us, max %.2f us\n",
+				sqrt(sync_err_sum / sync_n), sync_err_max);
+	return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ *  Project     Campos
+ *  @file		irpkt.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: encode and decode IR link packets
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o irpkt irpkt.c ../Campos/src/irpacket.c \
+ *             ../Campos/src/crc.c
+ *
+ *  Usage: irpkt -e <seq> <time> <status> <x.xxx> <y.yyy> <intensity> [...]
+ *         irpkt -d [<word> ...]
+ *
+ *  The time is the capture time stamp in us.
+ *  -e prints the words of a packet with one or more targets as hex.
+ *  -d decodes hex words from the command line, or one packet per line
+ *  from stdin. The packet format is described in irpacket.h
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "irpacket.h"
+
+/* local variables ----------------------------------------------------------*/
+static const char * const result_names[] = {
+	"ok", "short", "version", "length", "crc", "reference"
+};
+
+/**
+ * @brief  Parse a position like "123.456" into pixels and 1/1000 pixels
+ * @param  s the text
+ * @param  pixel the pixels
+ * @param  sub the sub pixels from 0..999
+ */
+static void parse_position(const char *s, int *pixel, int *sub) {
+	double v = atof(s);
+
+	*pixel = (int)v;
+	*sub = (int)((v - *pixel) * 1000.0 + 0.5);
+	if (*sub > 999)
+		*sub = 999;
+}
+
+/**
+ * @brief  Print a decoded packet
+ * @param  words the received words
+ * @param  n number of words
+ * @retval 0 if the packet was valid
+ */
+static int decode(const uint16_t *words, int n) {
+	IrPacket_TypeDef packet;
+	IrPacket_ResultTypeDef result;
+	int i;
+
+	result = IRPACKET_Decode(&packet, words, n);
+	if (result != IRPACKET_OK) {
+		printf("error: %s\n", result_names[-result]);
+		return 1;
+	}
+
+	printf("version %d seq %u time %u targets %d\n", packet.version,
+			packet.seq, packet.timestamp, packet.targets);
+	for (i = 0; i < packet.targets; i++) {
+		printf("  %d: status %d x %.3f y %.3f intensity %d\n", i,
+				packet.target[i].status,
+				IRPACKET_FixedToMilli(packet.target[i].x) / 1000.0,
+				IRPACKET_FixedToMilli(packet.target[i].y) / 1000.0,
+				packet.target[i].intensity << IRPACKET_INTENSITY_SHIFT);
+	}
+	return 0;
+}
+
+/**
+ * @brief  Encode a packet from the command line
+ * @retval 0 on success
+ */
+static int encode(int argc, char *argv[]) {
+	IrPacket_TypeDef packet;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	int i, n, x, subx, y, suby;
+
+	if (argc < 6 || (argc - 2) % 4 != 0) {
+		fprintf(stderr, "-e needs seq, time and 4 values per target\n");
+		return 1;
+	}
+
+	memset(&packet, 0, sizeof(packet));
+	packet.seq = (uint16_t)strtoul(argv[0], NULL, 0);
+	packet.timestamp = (uint32_t)strtoul(argv[1], NULL, 0);
+	packet.targets = (argc - 2) / 4;
+	if (packet.targets > IRPACKET_MAX_TARGETS) {
+		fprintf(stderr, "max. %d targets\n", IRPACKET_MAX_TARGETS);
+		return 1;
+	}
+
+	for (i = 0; i < packet.targets; i++) {
+		parse_position(argv[2 + i*4 + 1], &x, &subx);
+		parse_position(argv[2 + i*4 + 2], &y, &suby);
+		IRPACKET_SetTarget(&packet.target[i], atoi(argv[2 + i*4]),
+				x, subx, y, suby, atoi(argv[2 + i*4 + 3]));
+	}
+
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+	for (i = 0; i < n; i++)
+		printf("%04x%s", words[i], (i < n - 1) ? " " : "\n");
+	return 0;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	uint16_t words[256];
+	char line[2048];
+	char *p, *end;
+	int i, n, errors = 0;
+
+	if (argc >= 2 && strcmp(argv[1], "-e") == 0)
+		return encode(argc - 2, &argv[2]);
+
+	if (argc < 2 || strcmp(argv[1], "-d") != 0) {
+		fprintf(stderr, "Usage: %s -e <seq> <time> <status> <x> <y> <intensity> [...]\n"
+				"       %s -d [<word> ...]\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	// Words from the command line
+	if (argc > 2) {
+		for (i = 2, n = 0; i < argc && n < 256; i++)
+			words[n++] = (uint16_t)strtoul(argv[i], NULL, 16);
+		return decode(words, n);
+	}
+
+	// One packet per line from stdin
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		n = 0;
+		p = line;
+		while (n < 256) {
+			words[n] = (uint16_t)strtoul(p, &end, 16);
+			if (end == p)
+				break;
+			n++;
+			p = end;
+		}
+		if (n > 0)
+			errors += decode(words, n);
+	}
+
+	return errors ? 1 : 0;
+}
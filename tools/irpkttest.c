@@ -0,0 +1,494 @@
+/**
+ *  Project     Campos
+ *  @file		irpkttest.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: round trip tests of the IR packet coder
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o irpkttest irpkttest.c timesync.c \
+ *             ../Campos/src/irpacket.c ../Campos/src/crc.c -lm
+ *
+ *  Usage: irpkttest [-n packets]
+ *
+ *  Encodes packets and decodes them again:
+ *  - the whole 12.4 fixed point range and 0 up to the maximum number of
+ *    targets, one target more is rejected
+ *  - each single bit error, a wrong version and wrong lengths
+ *  - time stamps and sequence numbers that overflow, also for the
+ *    clock fit of the receiver. The compact decoder restores the high
+ *    byte of the sequence numbers.
+ *  - jumps of the tracker clock for the clock fit
+ *  - random compact packets with lost packets, with and without latency
+ *  Each failed test is printed, the exit code is 1 if one failed.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "irpacket.h"
+#include "timesync.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define CHECK(cond, ...) \
+	do { \
+		checks++; \
+		if (!(cond)) { \
+			failed++; \
+			printf("FAIL %s:%d: ", __func__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} while (0)
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+static long checks = 0, failed = 0;
+
+/**
+ * @brief  Pseudo random number (xorshift32)
+ */
+static uint32_t rnd(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/**
+ * @brief  Compare two packets field by field
+ * @retval 1 if they are equal
+ */
+static int same_packet(const IrPacket_TypeDef *a, const IrPacket_TypeDef *b) {
+	int i;
+
+	if (a->seq != b->seq || a->timestamp != b->timestamp
+			|| a->targets != b->targets
+			|| (a->flags & ~IRPACKET_FLAG_DELTA) != (b->flags & ~IRPACKET_FLAG_DELTA))
+		return 0;
+	if ((a->flags & IRPACKET_FLAG_LATENCY) && a->latency != b->latency)
+		return 0;
+	for (i = 0; i < a->targets; i++) {
+		if (a->target[i].x != b->target[i].x || a->target[i].y != b->target[i].y
+				|| a->target[i].status != b->target[i].status
+				|| a->target[i].intensity != b->target[i].intensity)
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief  Random packet
+ */
+static void random_packet(IrPacket_TypeDef *packet, int targets) {
+	int i;
+
+	memset(packet, 0, sizeof(*packet));
+	packet->seq = (uint16_t)rnd();
+	packet->timestamp = rnd();
+	packet->flags = (rnd() & 1) ? IRPACKET_FLAG_SYNC : 0;
+	if (rnd() & 1) {
+		packet->flags |= IRPACKET_FLAG_LATENCY;
+		packet->latency = (uint16_t)rnd();
+	}
+	packet->targets = targets;
+	for (i = 0; i < targets; i++) {
+		packet->target[i].x = (uint16_t)rnd();
+		packet->target[i].y = (uint16_t)rnd();
+		packet->target[i].status = rnd() & 0x0F;
+		packet->target[i].intensity = rnd() & IRPACKET_INTENSITY_MAX;
+	}
+}
+
+/**
+ * @brief  Encode and decode a packet
+ * @retval 1 if the decoded packet is the same
+ */
+static int round_trip(const IrPacket_TypeDef *packet) {
+	IrPacket_TypeDef decoded, expected;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	int n;
+
+	n = IRPACKET_Encode(packet, words, IRPACKET_MAX_WORDS);
+	if (n == 0)
+		return 0;
+
+	// Only the low byte of the sequence number is sent
+	expected = *packet;
+	expected.seq &= 0xFF;
+	return IRPACKET_Decode(&decoded, words, n) == IRPACKET_OK
+			&& decoded.version == IRPACKET_VERSION
+			&& same_packet(&expected, &decoded);
+}
+
+/**
+ * @brief  Check the sequence number restored by the compact decoder.
+ * 		   The first packet gives the high byte, then it must follow the
+ * 		   sent sequence numbers.
+ * @retval 1 if it is right
+ */
+static int same_seq(int *offset, uint16_t sent, uint16_t decoded) {
+	if (*offset < 0)
+		*offset = (uint16_t)(sent - decoded);
+	return (uint16_t)(decoded + *offset) == sent;
+}
+
+/**
+ * @brief  Every 12.4 fixed point value, in pixels with 1/1000 sub pixels
+ * 		   and in a packet
+ */
+static void test_fixed_range(void) {
+	IrPacket_TypeDef packet;
+	int fixed, milli, errors = 0;
+
+	for (fixed = 0; fixed <= 0xFFFF; fixed++) {
+		milli = IRPACKET_FixedToMilli((uint16_t)fixed);
+		if (IRPACKET_ToFixed(milli / 1000, milli % 1000) != fixed)
+			errors++;
+	}
+	CHECK(errors == 0, "%d fixed point values changed by the conversion", errors);
+
+	errors = 0;
+	random_packet(&packet, 1);
+	for (fixed = 0; fixed <= 0xFFFF; fixed++) {
+		packet.target[0].x = (uint16_t)fixed;
+		packet.target[0].y = (uint16_t)(0xFFFF - fixed);
+		if (!round_trip(&packet))
+			errors++;
+	}
+	CHECK(errors == 0, "%d positions not decoded", errors);
+
+	// The largest position of the sensor, and the limits of the intensity
+	IRPACKET_SetTarget(&packet.target[0], 4, 4095, 937, 0, 0, 0x7FFFFFFF);
+	CHECK(packet.target[0].x == 0xFFFF, "x 4095.937 is 0x%04x",
+			packet.target[0].x);
+	CHECK(packet.target[0].intensity == IRPACKET_INTENSITY_MAX,
+			"intensity not limited: 0x%03x", packet.target[0].intensity);
+	CHECK(round_trip(&packet), "limits not decoded");
+	IRPACKET_SetTarget(&packet.target[0], 0, 0, 0, 0, 0, -1);
+	CHECK(packet.target[0].intensity == 0, "negative intensity is %u",
+			packet.target[0].intensity);
+	CHECK(round_trip(&packet), "intensity 0 not decoded");
+}
+
+/**
+ * @brief  0 up to the maximum number of targets, more are rejected
+ */
+static void test_targets(void) {
+	IrPacket_TypeDef packet;
+	uint16_t words[IRPACKET_MAX_WORDS + IRPACKET_TARGET_WORDS];
+	int targets, n;
+
+	for (targets = 0; targets <= IRPACKET_MAX_TARGETS; targets++) {
+		random_packet(&packet, targets);
+		CHECK(round_trip(&packet), "%d targets not decoded", targets);
+	}
+
+	// Encoder: one target more, and a buffer that is one word too small
+	random_packet(&packet, IRPACKET_MAX_TARGETS);
+	packet.flags |= IRPACKET_FLAG_LATENCY;
+	packet.targets = IRPACKET_MAX_TARGETS + 1;
+	CHECK(IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS + IRPACKET_TARGET_WORDS) == 0,
+			"%d targets encoded", packet.targets);
+	packet.targets = IRPACKET_MAX_TARGETS;
+	CHECK(IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS - 1) == 0,
+			"packet encoded into a too small buffer");
+	CHECK(IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS) == IRPACKET_MAX_WORDS,
+			"largest packet is not IRPACKET_MAX_WORDS long");
+
+	// Decoder: a valid packet with one target more
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+	memset(&words[n - 1], 0, IRPACKET_TARGET_WORDS * sizeof(uint16_t));
+	n += IRPACKET_TARGET_WORDS;
+	words[n - 1] = IRPACKET_Crc16(words, n - 1);
+	CHECK(IRPACKET_Decode(&packet, words, n) == IRPACKET_ERR_LENGTH,
+			"%d targets decoded", IRPACKET_MAX_TARGETS + 1);
+}
+
+/**
+ * @brief  Each single bit error is detected. Outside of the first word
+ * 		   it is a CRC error.
+ */
+static void test_bit_errors(void) {
+	IrPacket_TypeDef packet, decoded;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	IrPacket_ResultTypeDef result;
+	int targets, n, w, bit;
+
+	for (targets = 0; targets <= IRPACKET_MAX_TARGETS; targets++) {
+		random_packet(&packet, targets);
+		n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+		for (w = 0; w < n; w++) {
+			for (bit = 0; bit < 16; bit++) {
+				words[w] ^= 1 << bit;
+				result = IRPACKET_Decode(&decoded, words, n);
+				if (w == 0)
+					CHECK(result != IRPACKET_OK, "bit %d of the header word "
+							"not detected", bit);
+				else
+					CHECK(result == IRPACKET_ERR_CRC, "bit %d of word %d: "
+							"result %d", bit, w, result);
+				words[w] ^= 1 << bit;
+			}
+		}
+		CHECK(IRPACKET_Decode(&decoded, words, n) == IRPACKET_OK,
+				"packet changed by the test");
+	}
+}
+
+/**
+ * @brief  Wrong version and wrong lengths, with a correct CRC
+ */
+static void test_header(void) {
+	IrPacket_TypeDef packet, decoded;
+	uint16_t words[IRPACKET_MAX_WORDS + 1];
+	int n;
+
+	random_packet(&packet, 2);
+	packet.flags = 0;
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+
+	// Other version
+	words[0] = (words[0] & 0x0FFF) | (1 << 12);
+	words[n - 1] = IRPACKET_Crc16(words, n - 1);
+	CHECK(IRPACKET_Decode(&decoded, words, n) == IRPACKET_ERR_VERSION,
+			"version 1 accepted");
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+
+	// The received words are no number of targets
+	words[n - 1] = 0;
+	words[n] = IRPACKET_Crc16(words, n);
+	CHECK(IRPACKET_Decode(&decoded, words, n + 1) == IRPACKET_ERR_LENGTH,
+			"%d words accepted", n + 1);
+
+	// Shorter than the header with the latency
+	packet.flags = IRPACKET_FLAG_LATENCY;
+	packet.targets = 0;
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+	words[n - 2] = IRPACKET_Crc16(words, n - 2);
+	CHECK(IRPACKET_Decode(&decoded, words, n - 1) == IRPACKET_ERR_LENGTH,
+			"%d words with latency accepted", n - 1);
+
+	// Less words than a header
+	CHECK(IRPACKET_Decode(&decoded, words, IRPACKET_HEADER_WORDS) == IRPACKET_ERR_SHORT,
+			"truncated packet accepted");
+	CHECK(IRPACKET_Decode(&decoded, words, 1) == IRPACKET_ERR_SHORT,
+			"one word accepted");
+
+	// A packet without one target: the CRC is wrong
+	random_packet(&packet, 2);
+	n = IRPACKET_Encode(&packet, words, IRPACKET_MAX_WORDS);
+	CHECK(IRPACKET_Decode(&decoded, words, n - IRPACKET_TARGET_WORDS)
+			== IRPACKET_ERR_CRC, "packet without a target accepted");
+}
+
+/**
+ * @brief  Time stamps and sequence numbers overflow
+ */
+static void test_wrap(void) {
+	IrPacket_DeltaTypeDef tx, rx;
+	IrPacket_TypeDef packet, decoded;
+	TimeSync_TypeDef ts;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	IrPacket_ResultTypeDef result;
+	double err, err_max = 0;
+	int i, n, deltas = 0, offset = -1;
+
+	random_packet(&packet, 1);
+	packet.timestamp = 0xFFFFFFFF;
+	packet.seq = 0xFFFF;
+	CHECK(round_trip(&packet), "time 0xFFFFFFFF not decoded");
+
+	// Compact packets over the overflow of both
+	IRPACKET_DeltaInit(&tx, IRPACKET_KEY_INTERVAL);
+	IRPACKET_DeltaInit(&rx, IRPACKET_KEY_INTERVAL);
+	packet.timestamp = 0xFFFFFFFF - 5 * 33333;
+	packet.seq = 0xFFFF - 5;
+	for (i = 0; i < 12; i++) {
+		n = IRPACKET_EncodeCompact(&tx, &packet, words, IRPACKET_MAX_WORDS);
+		if ((words[0] >> 8) & IRPACKET_FLAG_DELTA)
+			deltas++;
+		result = IRPACKET_DecodeCompact(&rx, &decoded, words, n);
+		CHECK(result == IRPACKET_OK && same_seq(&offset, packet.seq, decoded.seq),
+				"seq %u: result %d seq %u", packet.seq, result, decoded.seq);
+		decoded.seq = packet.seq;
+		CHECK(same_packet(&packet, &decoded), "seq %u time %u: time %u",
+				packet.seq, packet.timestamp, decoded.timestamp);
+		packet.seq++;
+		packet.timestamp += 33333;
+		packet.target[0].x++;
+	}
+	CHECK(deltas >= 10, "only %d delta packets", deltas);
+
+	// The receiver unwraps the tracker time. 30 frames per second,
+	// the tracker clock is 50ppm fast.
+	TIMESYNC_Init(&ts, 64);
+	for (i = 0; i < 1000; i++) {
+		TIMESYNC_Add(&ts, (uint32_t)(0xFFF00000u + i * 33333u),
+				1e6 + i * 33333.0 / 1.00005);
+	}
+	for (i = 900; i < 1000; i++) {
+		err = fabs(TIMESYNC_ToReceiver(&ts, (uint32_t)(0xFFF00000u + i * 33333u))
+				- (1e6 + i * 33333.0 / 1.00005));
+		if (err > err_max)
+			err_max = err;
+	}
+	CHECK(TIMESYNC_Valid(&ts) && err_max < 1.0,
+			"time after the overflow is %.1f us wrong", err_max);
+	// The drift is the one of the receiver clock
+	CHECK(fabs(TIMESYNC_DriftPpm(&ts) + 50.0) < 1.0,
+			"drift %.1f ppm instead of -50 ppm", TIMESYNC_DriftPpm(&ts));
+}
+
+/**
+ * @brief  The tracker clock jumps back (reset of the tracker) and
+ * 		   forward (restart of TIM5). The fit must follow the new clock.
+ */
+static void test_clock_jump(void) {
+	static const int64_t jumps[] = { -500000000, 1200000000 };
+	TimeSync_TypeDef ts;
+	uint32_t offset = 0, tracker_us;
+	double receiver_us, err, err_max;
+	int i, j;
+
+	TIMESYNC_Init(&ts, 64);
+	for (j = 0; j < 3; j++) {
+		if (j > 0)
+			offset += (uint32_t)jumps[j - 1];
+		err_max = 0;
+		for (i = 0; i < 300; i++) {
+			receiver_us = 1e6 + (j * 300 + i) * 33333.0 / 1.00005;
+			tracker_us = 600000000u + offset + (j * 300 + i) * 33333u;
+			TIMESYNC_Add(&ts, tracker_us, receiver_us);
+			if (i >= 200) {
+				err = fabs(TIMESYNC_ToReceiver(&ts, tracker_us) - receiver_us);
+				if (err > err_max)
+					err_max = err;
+			}
+		}
+		CHECK(TIMESYNC_Valid(&ts) && err_max < 1.0,
+				"time after jump %d is %.1f us wrong", j, err_max);
+		CHECK(fabs(TIMESYNC_DriftPpm(&ts) + 50.0) < 1.0,
+				"drift after jump %d is %.1f ppm", j, TIMESYNC_DriftPpm(&ts));
+	}
+	CHECK(ts.restarts == 2, "%u restarts instead of 2", ts.restarts);
+}
+
+/**
+ * @brief  Random compact packets. Lost packets are not given to the
+ * 		   decoder. After a lost key packet it must reject the delta
+ * 		   packets until the next key packet, a lost delta packet must
+ * 		   not break the following ones. It must never decode a wrong
+ * 		   packet.
+ */
+static void test_compact(int packets) {
+	IrPacket_DeltaTypeDef tx, rx;
+	IrPacket_TypeDef packet, decoded;
+	uint16_t words[IRPACKET_MAX_WORDS];
+	IrPacket_ResultTypeDef result;
+	int i, t, n, key_lost = 0, delta, ok = 0, deltas = 0, key_words = 0, delta_words = 0;
+	int latency, offset;
+
+	for (latency = 0; latency < 2; latency++) {
+		offset = -1;
+		IRPACKET_DeltaInit(&tx, IRPACKET_KEY_INTERVAL);
+		IRPACKET_DeltaInit(&rx, IRPACKET_KEY_INTERVAL);
+		random_packet(&packet, 1 + rnd() % IRPACKET_MAX_TARGETS);
+		for (i = 0; i < packets; i++) {
+			// The tracker skips frames sometimes, the targets move a bit
+			packet.seq += 1 + ((rnd() % 10) == 0);
+			packet.timestamp += 33333 + rnd() % 100;
+			packet.flags = IRPACKET_FLAG_SYNC;
+			if (latency) {
+				packet.flags |= IRPACKET_FLAG_LATENCY;
+				packet.latency += (int)(rnd() % 21) - 10;
+			}
+			if ((rnd() % 50) == 0)
+				packet.targets = 1 + rnd() % IRPACKET_MAX_TARGETS;
+			for (t = 0; t < packet.targets; t++) {
+				packet.target[t].x += (int)(rnd() % 65) - 32;
+				packet.target[t].y += (int)(rnd() % 65) - 32;
+				packet.target[t].status = rnd() % 5;
+				packet.target[t].intensity = (packet.target[t].intensity
+						+ (int)(rnd() % 9) - 4) & IRPACKET_INTENSITY_MAX;
+			}
+
+			n = IRPACKET_EncodeCompact(&tx, &packet, words, IRPACKET_MAX_WORDS);
+			CHECK(n > 0, "packet %d not encoded", i);
+			delta = (words[0] >> 8) & IRPACKET_FLAG_DELTA;
+			if (delta) {
+				deltas++;
+				delta_words += n;
+			} else {
+				key_words += n;
+			}
+
+			// Lost packet
+			if ((rnd() % 20) == 0) {
+				if (!delta)
+					key_lost = 1;
+				continue;
+			}
+			result = IRPACKET_DecodeCompact(&rx, &decoded, words, n);
+			if (key_lost && delta) {
+				CHECK(result == IRPACKET_ERR_REFERENCE,
+						"delta packet %d after a lost key packet: result %d", i, result);
+				continue;
+			}
+			CHECK(result == IRPACKET_OK && same_seq(&offset, packet.seq, decoded.seq),
+					"packet %d: result %d seq %u", i, result, decoded.seq);
+			decoded.seq = packet.seq;
+			CHECK(same_packet(&packet, &decoded), "packet %d is wrong", i);
+			key_lost = 0;
+			ok++;
+		}
+	}
+	CHECK(deltas > packets, "only %d delta packets", deltas);
+	CHECK(deltas < 2 * packets && delta_words * (2 * packets - deltas) < key_words * deltas,
+			"delta packets are not shorter");
+	printf("compact: %d packets, %d delta packets, %d decoded\n", 2 * packets,
+			deltas, ok);
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	int packets = 10000, opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n': packets = atoi(optarg); break;
+		default:
+			fprintf(stderr, "Usage: %s [-n packets]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	test_fixed_range();
+	test_targets();
+	test_bit_errors();
+	test_header();
+	test_wrap();
+	test_clock_jump();
+	test_compact(packets);
+
+	printf("%ld checks, %ld failed\n", checks, failed);
+	return failed ? 1 : 0;
+}
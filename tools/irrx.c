@@ -0,0 +1,187 @@
+/**
+ *  Project     Campos
+ *  @file		irrx.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host library: IR receiver that decodes a pulse train
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *  The input are the edges of the demodulated IR signal (1 = burst).
+ *  The header is detected by its length. The Manchester decoder
+ *  synchronizes to the transition in the middle of each bit, so it
+ *  follows a drifting clock of the transmitter.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <string.h>
+#include "irrx.h"
+#include "irline.h"
+
+/* Defines ------------------------------------------------------------------*/
+
+// A header is accepted, if it is at most this number of symbols shorter
+#define IRRX_HEADER_TOLERANCE	1.5
+
+/* Prototypes of local functions ---------------------------------------------*/
+static void IRRX_Finish(IrRx_TypeDef *rx);
+static void IRRX_Process(IrRx_TypeDef *rx, double t_us, int level);
+
+/**
+ * @brief  Initialize the receiver
+ * @param  rx the receiver
+ * @param  symbol_us nominal duration of a symbol
+ * @param  fec FEC mode of the transmitter
+ * @param  callback called for each received packet
+ * @param  user for the callback
+ */
+void IRRX_Init(IrRx_TypeDef *rx, double symbol_us, IrFec_ModeTypeDef fec,
+		IrRx_CallbackTypeDef callback, void *user) {
+	memset(rx, 0, sizeof(*rx));
+	rx->symbol_us = symbol_us;
+	rx->glitch_us = symbol_us / 4;
+	rx->fec = fec;
+	rx->callback = callback;
+	rx->user = user;
+	rx->state = IRRX_IDLE;
+	IRPACKET_DeltaInit(&rx->delta, IRPACKET_KEY_INTERVAL);
+}
+
+/**
+ * @brief  Decode the received bits and call the callback
+ * @param  rx the receiver
+ */
+static void IRRX_Finish(IrRx_TypeDef *rx) {
+	uint16_t data[IRFEC_MAX_WORDS];
+	IrPacket_TypeDef packet;
+	IrPacket_ResultTypeDef result;
+	int n;
+
+	rx->state = IRRX_IDLE;
+
+	// Only the frame sync pulse
+	if (rx->bits == 0)
+		return;
+
+	if (rx->bits % 16 != 0) {
+		result = IRPACKET_ERR_SHORT;
+	} else {
+		n = IRFEC_Decode(rx->fec, rx->words, rx->bits / 16, data,
+				IRFEC_MAX_WORDS, NULL);
+		result = IRPACKET_DecodeCompact(&rx->delta, &packet, data, n);
+	}
+
+	if (result == IRPACKET_OK)
+		rx->counters.packets++;
+	else
+		rx->counters.errors++;
+
+	if (rx->callback != NULL)
+		rx->callback(rx, rx->header_us, result, &packet);
+}
+
+/**
+ * @brief  Process an edge after the glitch filter
+ * @param  rx the receiver
+ * @param  t_us time of the edge
+ * @param  level new level
+ */
+static void IRRX_Process(IrRx_TypeDef *rx, double t_us, int level) {
+	double t = rx->symbol_us;
+	double d;
+
+	if (rx->state == IRRX_DATA) {
+		d = t_us - rx->mid_us;
+		if (d < 1.5 * t) {
+			// Edge between two equal bits
+			return;
+		}
+		if (d <= 2.5 * t) {
+			// Edge in the middle of a bit. Falling edge: burst first = 1
+			if (rx->bits < IRFEC_MAX_WORDS * 16) {
+				if (level == 0)
+					rx->words[rx->bits / 16] |= 0x8000 >> (rx->bits % 16);
+				else
+					rx->words[rx->bits / 16] &= ~(0x8000 >> (rx->bits % 16));
+			}
+			rx->bits++;
+			rx->mid_us = t_us;
+			return;
+		}
+
+		// No more bits. This edge may be the next header
+		IRRX_Finish(rx);
+	}
+
+	if (rx->state == IRRX_HEADER && level == 0) {
+		if (t_us - rx->header_us
+				>= (IRLINE_HEADER_SYMBOLS - IRRX_HEADER_TOLERANCE) * t) {
+			rx->counters.headers++;
+			rx->state = IRRX_DATA;
+			rx->bits = 0;
+
+			// The first bit follows the pause. Its middle is 2 symbols
+			// after this virtual one
+			rx->mid_us = t_us + (IRLINE_PAUSE_SYMBOLS - 1) * t;
+		} else {
+			rx->state = IRRX_IDLE;
+		}
+		return;
+	}
+
+	if (level == 1) {
+		rx->state = IRRX_HEADER;
+		rx->header_us = t_us;
+	}
+}
+
+/**
+ * @brief  Feed an edge of the demodulated signal into the receiver.
+ * 		   Pulses shorter than glitch_us are removed.
+ * @param  rx the receiver
+ * @param  t_us time of the edge in us
+ * @param  level new level, 1 = burst
+ */
+void IRRX_Edge(IrRx_TypeDef *rx, double t_us, int level) {
+	if (rx->pending) {
+		if (level == rx->pending_level)
+			return;
+		if (t_us - rx->pending_us < rx->glitch_us) {
+			rx->pending = 0;
+			rx->counters.glitches++;
+			return;
+		}
+		IRRX_Process(rx, rx->pending_us, rx->pending_level);
+	}
+
+	rx->pending = 1;
+	rx->pending_us = t_us;
+	rx->pending_level = level;
+}
+
+/**
+ * @brief  End of the input. Decodes the last packet.
+ * @param  rx the receiver
+ */
+void IRRX_Flush(IrRx_TypeDef *rx) {
+	if (rx->pending) {
+		IRRX_Process(rx, rx->pending_us, rx->pending_level);
+		rx->pending = 0;
+	}
+	if (rx->state == IRRX_DATA)
+		IRRX_Finish(rx);
+	rx->state = IRRX_IDLE;
+}
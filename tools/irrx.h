@@ -0,0 +1,84 @@
+/**
+ *  Project     Campos
+ *  @file		irrx.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host library: IR receiver that decodes a pulse train
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IRRX_H_
+#define IRRX_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "irpacket.h"
+#include "irfec.h"
+
+/* Type defs -----------------------------------------------------------------*/
+typedef enum {
+	IRRX_IDLE = 0,		// Waiting for the header
+	IRRX_HEADER = 1,	// Header burst is on
+	IRRX_DATA = 2		// Receiving Manchester bits
+} IrRx_StateTypeDef;
+
+typedef struct {
+	uint32_t headers;		// Headers (frame sync pulses) detected
+	uint32_t packets;		// Packets decoded
+	uint32_t errors;		// Packets with errors
+	uint32_t glitches;		// Short pulses removed
+} IrRx_CountersTypeDef;
+
+typedef struct IrRx IrRx_TypeDef;
+
+// Called for each header with data. header_us is the rising edge of the
+// header, result is IRPACKET_OK or an error code
+typedef void (*IrRx_CallbackTypeDef)(IrRx_TypeDef *rx, double header_us,
+		IrPacket_ResultTypeDef result, const IrPacket_TypeDef *packet);
+
+struct IrRx {
+	// Configuration
+	double symbol_us;			// Nominal duration of a symbol
+	double glitch_us;			// Shorter pulses are removed
+	IrFec_ModeTypeDef fec;		// FEC mode of the transmitter
+	IrRx_CallbackTypeDef callback;
+	void *user;					// For the callback
+
+	// State
+	IrRx_StateTypeDef state;
+	double header_us;			// Rising edge of the header
+	double mid_us;				// Last transition in the middle of a bit
+	int bits;					// Number of received bits
+	uint16_t words[IRFEC_MAX_WORDS];
+	IrPacket_DeltaTypeDef delta;// Reference for compact packets
+
+	// Edge waiting for the glitch filter
+	int pending;
+	double pending_us;
+	int pending_level;
+
+	IrRx_CountersTypeDef counters;
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void IRRX_Init(IrRx_TypeDef *rx, double symbol_us, IrFec_ModeTypeDef fec,
+		IrRx_CallbackTypeDef callback, void *user);
+void IRRX_Edge(IrRx_TypeDef *rx, double t_us, int level);
+void IRRX_Flush(IrRx_TypeDef *rx);
+
+#endif /* IRRX_H_ */
@@ -0,0 +1,293 @@
+/**
+ *  Project     Campos
+ *  @file		lcdzoombench.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: benchmark of the zoomed image renderer
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o lcdzoombench lcdzoombench.c \
+ *             ../Campos/src/lcdline.c
+ *
+ *  Usage: lcdzoombench [-n frames]
+ *
+ *  Renders random camera images with random cursor positions and pan
+ *  offsets with 1x, 2x and 4x magnification. The LCD port is replaced
+ *  by a buffer that takes the pixel stream.
+ *  - The old LCD_Image_Zoomed() only had 2x without pan. Its stream must
+ *    be the same as the one of the line buffer renderer.
+ *  - For each magnification, a per pixel renderer like the old one is
+ *    compared with the line buffer renderer of lcd.c.
+ *  Then the time per frame of each renderer is printed. The exit code
+ *  is 1, if a pixel stream differs.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "lcdline.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define LCD_RED		0xF800
+
+// The LCD port writes into the stream buffer
+#define LCD_IO_WRITE_1xDATA(x)	(*stream++ = (x))
+
+// Pixels of the largest image
+#define MAX_STREAM	(LCDLINE_SIZE * LCDLINE_SIZE)
+
+/* local variables ----------------------------------------------------------*/
+static uint32_t rnd_state = 0x12345678;
+
+static uint16_t color_table[256];
+static uint32_t color_table2[256];
+static LcdLine_BufferTypeDef lcd_line;
+
+static uint8_t pixels[LCDLINE_CAMERA_SIZE * LCDLINE_CAMERA_SIZE];
+static uint16_t stream_old[MAX_STREAM];
+static uint16_t stream_new[MAX_STREAM];
+static uint16_t *stream;
+
+/**
+ * @brief  Pseudo random number (xorshift32)
+ */
+static uint32_t rnd(void) {
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/**
+ * @brief  The old LCD_Image_Zoomed(), 2x without pan
+ * @retval number of written pixels
+ */
+static int render_old(uint8_t* pixelp, int position_intx, int position_inty,
+		int cursor) {
+	int x, y;
+	int v;
+
+	int cursor_x = 120 - position_intx;
+	int cursor_y = 2 * position_inty;
+
+	//Show or hide the cursor
+	if (!cursor) {
+		cursor_x = -1;
+		cursor_y = -1;
+	}
+
+	stream = stream_old;
+	for (y = 0; y < 240; y++) {
+		if (y == cursor_y) {
+
+			// Draw the vertical cursor line
+			for (x = 240; x != 0; x--) {
+
+				// 2 pixels width
+				LCD_IO_WRITE_1xDATA(LCD_RED);
+				LCD_IO_WRITE_1xDATA(LCD_RED);
+			}
+			pixelp += 120;
+			y++;
+
+		} else {
+
+			for (x = 120; x != 0; x--) {
+				// Draw the camera image
+				v = color_table[*pixelp];
+				// Draw the horizontal cursor line
+				if (x == cursor_x)
+					v = LCD_RED;
+				// 2 pixels width
+				LCD_IO_WRITE_1xDATA(v);
+				LCD_IO_WRITE_1xDATA(v);
+				pixelp++;
+			}
+		}
+		// 2 pixels height
+		if (y % 2 == 0) {
+			pixelp -= 120;
+		}
+	}
+	return stream - stream_old;
+}
+
+/**
+ * @brief  Renderer like the old one for each magnification: a table
+ * 		   lookup and a cursor test per pixel, each camera line is read
+ * 		   once per LCD line.
+ * @retval number of written pixels
+ */
+static int render_pixel(const LcdLine_ZoomTypeDef *z, uint8_t *pixelp) {
+	int x, y, i, k;
+	uint16_t v;
+	uint8_t *p;
+
+	stream = stream_old;
+	for (y = z->pan_y; y < z->pan_y + z->span; y++) {
+		for (i = 0; i < z->zoom; i++) {
+			p = pixelp + y * LCDLINE_CAMERA_SIZE + z->pan_x;
+			for (x = 0; x < z->span; x++) {
+				v = color_table[*p++];
+				if (y == z->cursor_y || x == z->cursor_x)
+					v = LCD_RED;
+				for (k = z->zoom; k != 0; k--)
+					LCD_IO_WRITE_1xDATA(v);
+			}
+		}
+	}
+	return stream - stream_old;
+}
+
+/**
+ * @brief  The line buffer renderer, like LCD_Image_Zoomed() in lcd.c
+ * @retval number of written pixels
+ */
+static int render_line(const LcdLine_ZoomTypeDef *z, uint8_t *pixelp) {
+	int x, y, i;
+	uint16_t *bufp;
+
+	stream = stream_new;
+	for (y = z->pan_y; y < z->pan_y + z->span; y++) {
+
+		// Expand the camera line into the line buffer
+		LCDLINE_Expand(z, &lcd_line, pixelp, y, color_table, color_table2);
+
+		// Send the line buffer once per LCD line
+		for (i = z->zoom; i != 0; i--) {
+			bufp = lcd_line.pixel;
+			for (x = z->size; x != 0; x--) {
+				LCD_IO_WRITE_1xDATA(*bufp++);
+			}
+		}
+	}
+	return stream - stream_new;
+}
+
+/**
+ * @brief  Compare both pixel streams
+ * @retval 1 if they are equal
+ */
+static int compare(int n_old, int n_new, const LcdLine_ZoomTypeDef *z,
+		const char *name) {
+	int i;
+
+	if (n_old != n_new || n_new != z->size * z->size) {
+		printf("%s %dx: %d and %d pixels instead of %d\n", name, z->zoom,
+				n_old, n_new, z->size * z->size);
+		return 0;
+	}
+	for (i = 0; i < n_new; i++) {
+		if (stream_old[i] != stream_new[i]) {
+			printf("%s %dx pan %d,%d cursor %d,%d: pixel %d,%d is %04x instead of %04x\n",
+					name, z->zoom, z->pan_x, z->pan_y, z->cursor_x, z->cursor_y,
+					i % z->size, i / z->size, stream_new[i], stream_old[i]);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief  Time in seconds
+ */
+static double seconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	static const int zooms[] = { 1, 2, 4 };
+	LcdLine_ZoomTypeDef z;
+	double t, t_old, t_pixel, t_line;
+	int frames = 2000, checked = 0, failed = 0;
+	int opt, f, i, zoom, x, y, pan_x, pan_y, cursor;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n': frames = atoi(optarg); break;
+		default:
+			fprintf(stderr, "Usage: %s [-n frames]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// The color tables of LCD_Init()
+	for (i = 0; i < 256; i++) {
+		color_table[i] = ((i / 4) << 5);
+		color_table2[i] = (color_table[i] << 16) | color_table[i];
+	}
+
+	for (f = 0; f < frames; f++) {
+		for (i = 0; i < (int)sizeof(pixels); i++)
+			pixels[i] = (uint8_t)rnd();
+		x = rnd() % LCDLINE_CAMERA_SIZE;
+		y = rnd() % LCDLINE_CAMERA_SIZE;
+		cursor = (rnd() % 4) != 0;
+
+		// The old renderer
+		LCDLINE_Setup(&z, 2, -1, -1, x, y, cursor);
+		checked++;
+		if (!compare(render_old(pixels, x, y, cursor), render_line(&z, pixels),
+				&z, "old"))
+			failed++;
+
+		// Each magnification, following the light point or a fixed pan
+		for (i = 0; i < 3; i++) {
+			zoom = zooms[i];
+			pan_x = (rnd() & 1) ? -1 : (int)(rnd() % LCDLINE_CAMERA_SIZE);
+			pan_y = (rnd() & 1) ? -1 : (int)(rnd() % LCDLINE_CAMERA_SIZE);
+			LCDLINE_Setup(&z, zoom, pan_x, pan_y, x, y, cursor);
+			checked++;
+			if (!compare(render_pixel(&z, pixels), render_line(&z, pixels),
+					&z, "per pixel"))
+				failed++;
+		}
+	}
+	printf("%d pixel streams compared, %d differ\n", checked, failed);
+
+	// Time per frame
+	printf("zoom       old  per pixel  line buffer  (us per frame on this host)\n");
+	for (i = 0; i < 3; i++) {
+		LCDLINE_Setup(&z, zooms[i], -1, -1, 60, 60, 1);
+		t = seconds();
+		for (f = 0; (zooms[i] == 2) && (f < frames); f++)
+			render_old(pixels, 60, 60, 1);
+		t_old = (seconds() - t) * 1e6 / frames;
+		t = seconds();
+		for (f = 0; f < frames; f++)
+			render_pixel(&z, pixels);
+		t_pixel = (seconds() - t) * 1e6 / frames;
+		t = seconds();
+		for (f = 0; f < frames; f++)
+			render_line(&z, pixels);
+		t_line = (seconds() - t) * 1e6 / frames;
+		if (zooms[i] == 2)
+			printf("%3dx %9.1f %10.1f %12.1f\n", zooms[i], t_old, t_pixel, t_line);
+		else
+			printf("%3dx %9s %10.1f %12.1f\n", zooms[i], "-", t_pixel, t_line);
+	}
+
+	return failed ? 1 : 0;
+}
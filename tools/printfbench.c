@@ -0,0 +1,386 @@
+/**
+ *  Project     Campos
+ *  @file		printfbench.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: test and benchmark the printf of the firmware
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -Ihost -I../Campos/inc -o printfbench printfbench.c \
+ *             ../Campos/src/printf.c
+ *
+ *  Usage: printfbench [-n calls]
+ *
+ *  Compares the output of my_snprintf() with the C library for a list of
+ *  formats, then measures the formats of the status window in main.c with
+ *  the former printf of the firmware, the new one and the C library.
+ *  The former printf read the arguments through a pointer to the format,
+ *  that does not work on the host. Its copy below gets them as an array.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "printf.h"
+
+/* local variables ----------------------------------------------------------*/
+UART_HandleTypeDef UartHandle;
+static long n_failed = 0;
+static volatile int sink;
+
+/**
+ * @brief  Replaces the debug port
+ */
+int USARTL1_PutByte(UART_HandleTypeDef *huart, uint8_t b) {
+	sink += b;
+	return 1;
+}
+
+/* The former printf ---------------------------------------------------------*/
+#define PAD_RIGHT 1
+#define PAD_ZERO 2
+#define PRINT_BUF_LEN 12
+
+static void old_printchar(char **str, int c)
+{
+	**str = c;
+	++(*str);
+}
+
+static int old_prints(char **out, const char *string, int width, int pad)
+{
+	register int pc = 0, padchar = ' ';
+
+	if (width > 0) {
+		register int len = 0;
+		register const char *ptr;
+		for (ptr = string; *ptr; ++ptr) ++len;
+		if (len >= width) width = 0;
+		else width -= len;
+		if (pad & PAD_ZERO) padchar = '0';
+	}
+	if (!(pad & PAD_RIGHT)) {
+		for ( ; width > 0; --width) {
+			old_printchar (out, padchar);
+			++pc;
+		}
+	}
+	for ( ; *string ; ++string) {
+		old_printchar (out, *string);
+		++pc;
+	}
+	for ( ; width > 0; --width) {
+		old_printchar (out, padchar);
+		++pc;
+	}
+
+	return pc;
+}
+
+static int old_printi(char **out, int i, int b, int sg, int width, int pad, int letbase)
+{
+	char print_buf[PRINT_BUF_LEN];
+	register char *s;
+	register int t, neg = 0, pc = 0;
+	register unsigned int u = i;
+
+	if (i == 0) {
+		print_buf[0] = '0';
+		print_buf[1] = '\0';
+		return old_prints (out, print_buf, width, pad);
+	}
+
+	if (sg && b == 10 && i < 0) {
+		neg = 1;
+		u = -i;
+	}
+
+	s = print_buf + PRINT_BUF_LEN-1;
+	*s = '\0';
+
+	while (u) {
+		t = u % b;
+		if( t >= 10 )
+			t += letbase - '0' - 10;
+		*--s = t + '0';
+		u /= b;
+	}
+
+	if (neg) {
+		if( width && (pad & PAD_ZERO) ) {
+			old_printchar (out, '-');
+			++pc;
+			--width;
+		}
+		else {
+			*--s = '-';
+		}
+	}
+
+	return pc + old_prints (out, s, width, pad);
+}
+
+// Only the integer conversions, the formats of main.c have no strings
+static int __attribute__((noinline)) old_print(char **out, const char *format,
+		const int *varg)
+{
+	register int width, pad;
+	register int pc = 0;
+
+	for (; *format != 0; ++format) {
+		if (*format == '%') {
+			++format;
+			width = pad = 0;
+			if (*format == '\0') break;
+			if (*format == '%') goto out;
+			if (*format == '-') {
+				++format;
+				pad = PAD_RIGHT;
+			}
+			while (*format == '0') {
+				++format;
+				pad |= PAD_ZERO;
+			}
+			for ( ; *format >= '0' && *format <= '9'; ++format) {
+				width *= 10;
+				width += *format - '0';
+			}
+			if( *format == 'd' ) {
+				pc += old_printi (out, *varg++, 10, 1, width, pad, 'a');
+				continue;
+			}
+			if( *format == 'x' ) {
+				pc += old_printi (out, *varg++, 16, 0, width, pad, 'a');
+				continue;
+			}
+			if( *format == 'u' ) {
+				pc += old_printi (out, *varg++, 10, 0, width, pad, 'a');
+				continue;
+			}
+		}
+		else {
+		out:
+			old_printchar (out, *format);
+			++pc;
+		}
+	}
+	if (out) **out = '\0';
+	return pc;
+}
+
+static int old_sprintf(char *out, const char *format, int a, int b)
+{
+	int varg[2] = { a, b };
+	return old_print(&out, format, varg);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+
+/**
+ * @brief  Compare one result with the C library
+ */
+static void check(const char *format, const char *mine, int n_mine,
+		const char *libc, int n_libc) {
+	if (strcmp(mine, libc) != 0 || n_mine != n_libc) {
+		printf("FAILED %-12s \"%s\" (%d), C library \"%s\" (%d)\n",
+				format, mine, n_mine, libc, n_libc);
+		n_failed++;
+	}
+}
+
+// The size is volatile, the compiler would warn about the truncation
+#define CHECK(size, format, ...) do { \
+	char m[64], l[64]; \
+	volatile size_t sz = (size); \
+	int nm = my_snprintf(m, sz, format, __VA_ARGS__); \
+	int nl = snprintf(l, sz, format, __VA_ARGS__); \
+	check(format, m, nm, l, nl); \
+} while (0)
+
+/**
+ * @brief  Compare the output with the C library
+ */
+static void test_formats(void) {
+	static const int ints[] = {
+		0, 1, -1, 7, 42, -42, 99, 100, 999, 1000, 12345, -12345, 65535,
+		99999, 100000, 2147483647, -2147483647 - 1
+	};
+	static const char * const int_formats[] = {
+		"%d", "%i", "%5d", "%-5d|", "%05d", "%04d.%03d", "%+d", "% d",
+		"%.3d", "%8.3d", "%-08d|", "%.0d", "%u", "%x", "%X", "%#x",
+		"%08x", "%02x", "%o", "%#o", "%hd", "%hhu", "%c%%"
+	};
+	static const char * const strings[] = { "", "a", "Campos", "0123456789" };
+	static const char * const string_formats[] = {
+		"%s", "%10s", "%-10s|", "%.2s", "%5.1s", "<%s>"
+	};
+	char m[64], l[64];
+	int i, j, nm, nl;
+
+	for (i = 0; i < (int) (sizeof(int_formats) / sizeof(int_formats[0])); i++)
+		for (j = 0; j < (int) (sizeof(ints) / sizeof(ints[0])); j++) {
+			nm = my_snprintf(m, sizeof(m), int_formats[i], ints[j], ints[j] & 0x3FF);
+			nl = snprintf(l, sizeof(l), int_formats[i], ints[j], ints[j] & 0x3FF);
+			check(int_formats[i], m, nm, l, nl);
+		}
+
+	for (i = 0; i < (int) (sizeof(string_formats) / sizeof(string_formats[0])); i++)
+		for (j = 0; j < (int) (sizeof(strings) / sizeof(strings[0])); j++) {
+			nm = my_snprintf(m, sizeof(m), string_formats[i], strings[j]);
+			nl = snprintf(l, sizeof(l), string_formats[i], strings[j]);
+			check(string_formats[i], m, nm, l, nl);
+		}
+
+	CHECK(64, "%*d|%-*d|", 6, 12, -6, 34);
+	CHECK(64, "%.*d", 5, 42);
+	CHECK(64, "%ld %lu", -1234567890L, 4000000000UL);
+	CHECK(64, "%lld", -9223372036854775807LL - 1);
+	CHECK(64, "%llu %llx", 18446744073709551615ULL, 0x123456789ABCULL);
+	CHECK(64, "%zu", (size_t) 123456);
+	CHECK(64, "%5c|%-3c|", 'a', 'b');
+	CHECK(64, "100%% %d%%", 5);
+
+	// Truncated output
+	CHECK(5, "%d", 123456);
+	CHECK(1, "%s", "abc");
+	CHECK(8, "x=%05d y=%05d", 1, 2);
+
+	// Fixed point
+	for (i = -1000; i < 2600000; i += 997) {
+		nm = sprintf_fixed(m, sizeof(m), i, 4, 3);
+		nl = snprintf(l, sizeof(l), "%s%04d.%03d", i < 0 ? "-" : "",
+				abs(i) / 1000, abs(i) % 1000);
+		check("fixed", m, nm, l, nl);
+	}
+	CHECK(6, "%04d.%03d", 1234, 567);
+	nm = sprintf_fixed(m, 6, 1234567, 4, 3);
+	check("fixed 6", m, nm, "1234.", 8);
+	nm = sprintf_fixed(m, sizeof(m), 5, 0, 2);
+	check("fixed 0.05", m, nm, "0.05", 4);
+
+	// Without fractional part like "%05d"
+	for (i = 0; i < 200000; i += 97) {
+		nm = sprintf_fixed(m, sizeof(m), i, 5, 0);
+		nl = snprintf(l, sizeof(l), "%05d", i);
+		check("fixed 5.0", m, nm, l, nl);
+	}
+}
+
+/* Benchmark -----------------------------------------------------------------*/
+
+/**
+ * @brief  Time in ns
+ */
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief  Measure the formats of the status window in main.c
+ */
+static void benchmark(int calls) {
+	int *x, *sub, *val;
+	char txt[20];
+	double t0, t_old, t_new, t_fixed, t_libc;
+	int i, k;
+
+	x = malloc(calls * sizeof(int));
+	sub = malloc(calls * sizeof(int));
+	val = malloc(calls * sizeof(int));
+	srand(1);
+	for (i = 0; i < calls; i++) {
+		x[i] = rand() % 2592;
+		sub[i] = rand() % 1000;
+		val[i] = rand() % 100000;
+	}
+
+	printf("\n%-12s %12s %12s %12s %12s\n", "format", "former", "my_snprintf",
+			"sprintf_fixed", "C library");
+	for (k = 0; k < 2; k++) {
+		const char *format = (k == 0) ? "%04d.%03d" : "%05d";
+
+		t0 = now_ns();
+		for (i = 0; i < calls; i++) {
+			old_sprintf(txt, format, k == 0 ? x[i] : val[i], sub[i]);
+			sink += txt[3];
+		}
+		t_old = (now_ns() - t0) / calls;
+
+		t0 = now_ns();
+		for (i = 0; i < calls; i++) {
+			my_snprintf(txt, sizeof(txt), format, k == 0 ? x[i] : val[i], sub[i]);
+			sink += txt[3];
+		}
+		t_new = (now_ns() - t0) / calls;
+
+		t0 = now_ns();
+		for (i = 0; i < calls; i++) {
+			if (k == 0)
+				sprintf_fixed(txt, sizeof(txt), x[i] * 1000 + sub[i], 4, 3);
+			else
+				sprintf_fixed(txt, sizeof(txt), val[i], 5, 0);
+			sink += txt[3];
+		}
+		t_fixed = (now_ns() - t0) / calls;
+
+		t0 = now_ns();
+		for (i = 0; i < calls; i++) {
+			snprintf(txt, sizeof(txt), format, k == 0 ? x[i] : val[i], sub[i]);
+			sink += txt[3];
+		}
+		t_libc = (now_ns() - t0) / calls;
+
+		printf("%-12s %9.1f ns %9.1f ns %9.1f ns %9.1f ns\n", format,
+				t_old, t_new, t_fixed, t_libc);
+	}
+
+	free(x);
+	free(sub);
+	free(val);
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	int opt, calls = 1000000;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			calls = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n calls]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (calls < 1)
+		calls = 1;
+
+	test_formats();
+	printf("%ld format tests failed\n", n_failed);
+
+	benchmark(calls);
+
+	return n_failed != 0;
+}
@@ -0,0 +1,288 @@
+/**
+ *  Project     Campos
+ *  @file		record.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tools: recording file with camera frames and tracking results
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  The pixels are difference coded like in the frame stream. The index at
+ *  the end of the file allows to seek to any frame. If the recorder was
+ *  stopped without closing the file, the index is rebuilt from the record
+ *  lengths when it is opened.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "record.h"
+
+/* local variables ----------------------------------------------------------*/
+static uint8_t record_coded[RECORD_MAX_PIXELS * 3 / 2 + 1];
+
+/**
+ * @brief  Write a 16 bit value little endian
+ */
+static void put16(uint8_t *p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+/**
+ * @brief  Write a 32 bit value little endian
+ */
+static void put32(uint8_t *p, uint32_t v) {
+	put16(p, v & 0xFFFF);
+	put16(p + 2, v >> 16);
+}
+
+/**
+ * @brief  Read a 16 bit value little endian
+ */
+static uint16_t get16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * @brief  Read a 32 bit value little endian
+ */
+static uint32_t get32(const uint8_t *p) {
+	return get16(p) | ((uint32_t) get16(p + 2) << 16);
+}
+
+/**
+ * @brief  Write the file header
+ * @retval 0 on success
+ */
+static int write_header(Record_TypeDef *r, uint32_t index_offset) {
+	uint8_t h[RECORD_HEADER_SIZE];
+
+	memcpy(h, RECORD_MAGIC, 4);
+	put16(&h[4], RECORD_VERSION);
+	put16(&h[6], RECORD_HEADER_SIZE);
+	put32(&h[8], r->frames);
+	put32(&h[12], index_offset);
+
+	if (fseek(r->f, 0, SEEK_SET) != 0)
+		return -1;
+	return fwrite(h, 1, sizeof(h), r->f) == sizeof(h) ? 0 : -1;
+}
+
+/**
+ * @brief  Add one entry to the index
+ * @retval 0 on success
+ */
+static int add_index(Record_TypeDef *r, uint32_t offset) {
+	uint32_t *p;
+
+	if (r->frames >= r->index_size) {
+		r->index_size = r->index_size ? r->index_size * 2 : 1024;
+		p = realloc(r->index, r->index_size * sizeof(uint32_t));
+		if (!p)
+			return -1;
+		r->index = p;
+	}
+	r->index[r->frames++] = offset;
+	return 0;
+}
+
+/**
+ * @brief  Create a new recording
+ * @param  r the recording
+ * @param  name file name
+ * @retval 0 on success
+ */
+int RECORD_Create(Record_TypeDef *r, const char *name) {
+	memset(r, 0, sizeof(*r));
+	r->f = fopen(name, "w+b");
+	if (!r->f)
+		return -1;
+	r->writing = 1;
+	return write_header(r, 0);
+}
+
+/**
+ * @brief  Append a frame
+ * @param  r the recording
+ * @param  fr frame information and tracking result
+ * @param  pixels width * height pixels
+ * @retval 0 on success
+ */
+int RECORD_Write(Record_TypeDef *r, const Record_FrameTypeDef *fr,
+		const uint8_t *pixels) {
+	uint8_t h[RECORD_FRAME_HEADER];
+	int pixel_count, len;
+	long offset;
+
+	pixel_count = fr->frame.width * fr->frame.height;
+	if (!r->writing || pixel_count > RECORD_MAX_PIXELS)
+		return -1;
+	len = STREAM_DeltaEncode(pixels, pixel_count, record_coded,
+			sizeof(record_coded));
+	if (len < 0)
+		return -1;
+
+	put32(&h[0], RECORD_FRAME_HEADER + len);
+	put16(&h[4], fr->frame.frame);
+	h[6] = fr->frame.size;
+	h[7] = fr->frame.tile;
+	put16(&h[8], fr->frame.width);
+	put16(&h[10], fr->frame.height);
+	put16(&h[12], fr->frame.x);
+	put16(&h[14], fr->frame.y);
+	put32(&h[16], fr->frame.exposure);
+	put32(&h[20], fr->frame.timestamp);
+	h[24] = fr->track_valid;
+	h[25] = fr->status;
+	put16(&h[26], fr->x);
+	put16(&h[28], fr->subx);
+	put16(&h[30], fr->y);
+	put16(&h[32], fr->suby);
+	put32(&h[34], fr->intensity);
+	put32(&h[38], len);
+
+	if (fseek(r->f, 0, SEEK_END) != 0)
+		return -1;
+	offset = ftell(r->f);
+	if (fwrite(h, 1, sizeof(h), r->f) != sizeof(h)
+			|| fwrite(record_coded, 1, len, r->f) != (size_t) len)
+		return -1;
+
+	return add_index(r, offset);
+}
+
+/**
+ * @brief  Open a recording for reading
+ * @param  r the recording
+ * @param  name file name
+ * @retval 0 on success
+ */
+int RECORD_Open(Record_TypeDef *r, const char *name) {
+	uint8_t h[RECORD_HEADER_SIZE];
+	uint32_t n, index_offset, i;
+	long offset;
+
+	memset(r, 0, sizeof(*r));
+	r->f = fopen(name, "rb");
+	if (!r->f)
+		return -1;
+	if (fread(h, 1, sizeof(h), r->f) != sizeof(h)
+			|| memcmp(h, RECORD_MAGIC, 4) != 0
+			|| get16(&h[4]) != RECORD_VERSION)
+		return -1;
+
+	n = get32(&h[8]);
+	index_offset = get32(&h[12]);
+
+	if (index_offset != 0) {
+		// Closed file with index
+		if (fseek(r->f, index_offset, SEEK_SET) != 0)
+			return -1;
+		for (i = 0; i < n; i++) {
+			if (fread(h, 1, 4, r->f) != 4 || add_index(r, get32(h)) != 0)
+				return -1;
+		}
+	} else {
+		// Rebuild the index from the record lengths
+		offset = get16(&h[6]);
+		while (fseek(r->f, offset, SEEK_SET) == 0
+				&& fread(h, 1, 4, r->f) == 4 && get32(h) >= RECORD_FRAME_HEADER) {
+			if (add_index(r, offset) != 0)
+				return -1;
+			offset += get32(h);
+		}
+		// The last record may be incomplete
+		if (r->frames > 0) {
+			fseek(r->f, 0, SEEK_END);
+			if (ftell(r->f) < offset)
+				r->frames--;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief  Read one frame
+ * @param  r the recording
+ * @param  n index of the frame, from 0 to r->frames - 1
+ * @param  fr output: frame information and tracking result
+ * @param  pixels output, RECORD_MAX_PIXELS bytes
+ * @retval 0 on success
+ */
+int RECORD_Read(Record_TypeDef *r, uint32_t n, Record_FrameTypeDef *fr,
+		uint8_t *pixels) {
+	uint8_t h[RECORD_FRAME_HEADER];
+	uint32_t len;
+
+	if (n >= r->frames || fseek(r->f, r->index[n], SEEK_SET) != 0
+			|| fread(h, 1, sizeof(h), r->f) != sizeof(h))
+		return -1;
+
+	fr->frame.frame = get16(&h[4]);
+	fr->frame.size = h[6];
+	fr->frame.tile = h[7];
+	fr->frame.width = get16(&h[8]);
+	fr->frame.height = get16(&h[10]);
+	fr->frame.x = get16(&h[12]);
+	fr->frame.y = get16(&h[14]);
+	fr->frame.exposure = get32(&h[16]);
+	fr->frame.timestamp = get32(&h[20]);
+	fr->track_valid = h[24];
+	fr->status = h[25];
+	fr->x = get16(&h[26]);
+	fr->subx = get16(&h[28]);
+	fr->y = get16(&h[30]);
+	fr->suby = get16(&h[32]);
+	fr->intensity = get32(&h[34]);
+	len = get32(&h[38]);
+
+	if (fr->frame.width * fr->frame.height > RECORD_MAX_PIXELS
+			|| len > sizeof(record_coded)
+			|| fread(record_coded, 1, len, r->f) != len)
+		return -1;
+
+	return STREAM_DeltaDecode(record_coded, len, pixels,
+			fr->frame.width * fr->frame.height);
+}
+
+/**
+ * @brief  Close the recording. A new recording gets its index.
+ * @param  r the recording
+ * @retval 0 on success
+ */
+int RECORD_Close(Record_TypeDef *r) {
+	uint8_t b[4];
+	uint32_t i;
+	long index_offset;
+	int ret = 0;
+
+	if (r->writing) {
+		fseek(r->f, 0, SEEK_END);
+		index_offset = ftell(r->f);
+		for (i = 0; i < r->frames; i++) {
+			put32(b, r->index[i]);
+			if (fwrite(b, 1, 4, r->f) != 4)
+				ret = -1;
+		}
+		if (write_header(r, index_offset) != 0)
+			ret = -1;
+	}
+	if (fclose(r->f) != 0)
+		ret = -1;
+	free(r->index);
+	r->index = NULL;
+	return ret;
+}
@@ -0,0 +1,82 @@
+/**
+ *  Project     Campos
+ *  @file		record.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Header file for record.c
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef RECORD_H_
+#define RECORD_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include "stream.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+// File layout, all values little endian:
+//  header: "CREC", version (16 bit), header size (16 bit), number of
+//          frames, offset of the index (32 bit). The index offset is 0,
+//          if the recording was not closed.
+//  per frame: length of the record (32 bit), frame number (16 bit),
+//          camera size, tile (8 bit), width, height, crop offset x, y
+//          (16 bit), exposure, time stamp (32 bit), tracking valid,
+//          status (8 bit), x, sub x, y, sub y (16 bit), intensity,
+//          length of the pixel data (32 bit), difference coded pixels
+//  index:  file offset of each frame record (32 bit)
+#define RECORD_MAGIC			"CREC"
+#define RECORD_VERSION			1
+#define RECORD_HEADER_SIZE		16
+#define RECORD_FRAME_HEADER		42
+
+// Largest frame: a tile of the total view
+#define RECORD_MAX_PIXELS		(864 * 108)
+
+/* Type defs -----------------------------------------------------------------*/
+typedef struct {
+	Stream_FrameTypeDef frame;	// camera size, offset, tile and time stamp
+	int track_valid;			// The tracking result was received
+	uint8_t status;				// Track_StatusTypeDef
+	uint16_t x;					// position in sensor pixels
+	uint16_t subx;				// sub pixel position from 0..999
+	uint16_t y;
+	uint16_t suby;
+	uint32_t intensity;
+} Record_FrameTypeDef;
+
+typedef struct {
+	FILE *f;
+	int writing;
+	uint32_t frames;		// Number of frames
+	uint32_t *index;		// File offset of each frame
+	uint32_t index_size;	// Allocated index entries
+} Record_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+int RECORD_Create(Record_TypeDef *r, const char *name);
+int RECORD_Write(Record_TypeDef *r, const Record_FrameTypeDef *fr,
+		const uint8_t *pixels);
+int RECORD_Open(Record_TypeDef *r, const char *name);
+int RECORD_Read(Record_TypeDef *r, uint32_t n, Record_FrameTypeDef *fr,
+		uint8_t *pixels);
+int RECORD_Close(Record_TypeDef *r);
+
+#endif /* RECORD_H_ */
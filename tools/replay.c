@@ -0,0 +1,231 @@
+/**
+ *  Project     Campos
+ *  @file		replay.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: replay a recording through the tracking
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -Ihost -I../Campos/inc -o replay replay.c record.c \
+ *             ../Campos/src/track.c ../Campos/src/stream.c \
+ *             ../Campos/src/cobs.c ../Campos/src/crc.c
+ *
+ *  Usage: replay [-s first frame] [-n frames] [-x directory] <recording>
+ *
+ *  The frames of a recording from "streamrx -r" are fed through
+ *  TRACK_Search() of the firmware. For each frame, the recorded and the
+ *  replayed tracking result are printed as CSV. -s seeks to a frame
+ *  index, the tracking starts with the recorded status of the frame
+ *  before. A search in the total view should start at tile 0.
+ *  -x writes the replayed frames as PGM files into a directory.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "camera.h"
+#include "track.h"
+#include "history.h"
+#include "record.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define TILES_X			3
+
+/* global variables ---------------------------------------------------------*/
+// The firmware variables that are used by the tracking
+Union_PixelsType pixels;
+int window_x, window_y;
+int offset_window_x, offset_window_y;
+int offset_x, offset_y;
+extern int lost_cnt;
+extern int max;
+
+/* local variables ----------------------------------------------------------*/
+static Camera_SizeTypeDef camera_size = CAMERA_ZOOMED;
+static const char * const status_names[] = {
+	"init", "searching", "light", "center", "lost"
+};
+
+/**
+ * @brief  Replaces the camera driver: the requested size is only noted
+ */
+void BSP_CAMERA_SetSize(Camera_SizeTypeDef s) {
+	camera_size = s;
+	offset_x = 0;
+	offset_y = 0;
+}
+
+/**
+ * @brief  Replaces the camera driver: the requested window is only noted
+ */
+void BSP_CAMERA_SetOffset(int o_x, int o_y) {
+	offset_x = o_x;
+	offset_y = o_y;
+}
+
+/**
+ * @brief  Replaces the history, it is not used by the replay
+ */
+void HISTORY_Init(void) {
+}
+
+/**
+ * @brief  Replaces the history, it is not used by the replay
+ */
+void HISTORY_Add(Track_StatusTypeDef status, int x, int subx, int y, int suby,
+		int intensity) {
+}
+
+/**
+ * @brief  Name of a tracking status
+ */
+static const char *status_name(int status) {
+	return (status >= 0 && status < 5) ? status_names[status] : "?";
+}
+
+/**
+ * @brief  Write a frame as PGM file
+ */
+static void write_pgm(const char *dir, uint32_t n, const Record_FrameTypeDef *fr) {
+	char name[1024];
+	FILE *f;
+
+	snprintf(name, sizeof(name), "%s/replay_%06u.pgm", dir, n);
+	f = fopen(name, "wb");
+	if (!f) {
+		perror(name);
+		return;
+	}
+	fprintf(f, "P5\n# frame %u tile %u offset %u %u\n%d %d\n255\n",
+			fr->frame.frame, fr->frame.tile, fr->frame.x, fr->frame.y,
+			fr->frame.width, fr->frame.height);
+	fwrite(&pixels.firstByte, 1, fr->frame.width * fr->frame.height, f);
+	fclose(f);
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	Record_TypeDef record;
+	Record_FrameTypeDef fr;
+	const char *dir = NULL;
+	uint32_t first = 0, count = 0, i, end;
+	long n_compared = 0, n_same = 0;
+	int opt, same;
+
+	while ((opt = getopt(argc, argv, "s:n:x:")) != -1) {
+		switch (opt) {
+		case 's':
+			first = atoi(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'x':
+			dir = optarg;
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (argc - optind != 1) {
+		fprintf(stderr, "Usage: %s [-s first frame] [-n frames] [-x directory] "
+				"<recording>\n", argv[0]);
+		return 1;
+	}
+
+	if (RECORD_Open(&record, argv[optind]) != 0) {
+		fprintf(stderr, "%s: no valid recording\n", argv[optind]);
+		return 1;
+	}
+	end = record.frames;
+	if (count > 0 && first + count < end)
+		end = first + count;
+
+	// Start with the status after the frame before
+	TRACK_Init();
+	track_status = TRACK_SEARCHING;
+	if (first > 0 && RECORD_Read(&record, first - 1, &fr, &pixels.firstByte) == 0
+			&& fr.track_valid) {
+		track_status = fr.status;
+		position_x = fr.x;
+		position_y = fr.y;
+		offset_x = fr.frame.x;
+		offset_y = fr.frame.y;
+	}
+	lost_cnt = 0;
+	max = 0;
+
+	printf("index,frame,size,tile,offset_x,offset_y,"
+			"status,x,y,intensity,replay_status,replay_x,replay_y,"
+			"replay_intensity,same\n");
+
+	for (i = first; i < end; i++) {
+		if (RECORD_Read(&record, i, &fr, &pixels.firstByte) != 0) {
+			fprintf(stderr, "Frame %u is damaged\n", i);
+			break;
+		}
+
+		// The zoomed frames need a status that evaluates them
+		if ((fr.frame.size == CAMERA_ZOOMED) && (track_status == TRACK_SEARCHING))
+			track_status = TRACK_LIGHT_FOUND;
+		if ((fr.frame.size == CAMERA_TOTAL) && (track_status != TRACK_SEARCHING)
+				&& (track_status != TRACK_INIT))
+			track_status = TRACK_SEARCHING;
+
+		camera_size = fr.frame.size;
+		window_x = fr.frame.tile % TILES_X;
+		window_y = fr.frame.tile / TILES_X;
+		offset_window_x = fr.frame.x;
+		offset_window_y = fr.frame.y;
+
+		TRACK_Search();
+
+		same = fr.track_valid && (fr.status == track_status)
+				&& (fr.x == position_x) && (fr.subx == position_subx)
+				&& (fr.y == position_y) && (fr.suby == position_suby)
+				&& (fr.intensity == (uint32_t) intensity);
+		if (fr.track_valid) {
+			n_compared++;
+			n_same += same;
+		}
+
+		printf("%u,%u,%s,%u,%u,%u,", i, fr.frame.frame,
+				fr.frame.size == CAMERA_ZOOMED ? "zoomed" : "total",
+				fr.frame.tile, fr.frame.x, fr.frame.y);
+		if (fr.track_valid)
+			printf("%s,%u.%03u,%u.%03u,%u,", status_name(fr.status),
+					fr.x, fr.subx, fr.y, fr.suby, fr.intensity);
+		else
+			printf(",,,,");
+		printf("%s,%d.%03d,%d.%03d,%d,%d\n", status_name(track_status),
+				position_x, position_subx, position_y, position_suby,
+				intensity, same);
+
+		if (dir)
+			write_pgm(dir, i, &fr);
+	}
+
+	fprintf(stderr, "%u frames, %ld with tracking result, %ld replayed equal\n",
+			end > first ? end - first : 0, n_compared, n_same);
+	RECORD_Close(&record);
+
+	return 0;
+}
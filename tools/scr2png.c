@@ -0,0 +1,299 @@
+/**
+ *  Project     Campos
+ *  @file		scr2png.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: convert a LCD screenshot stream into a PNG file
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -o scr2png scr2png.c
+ *
+ *  Usage: scr2png <serial port or captured file> <output.png>
+ *
+ *  If the input is a serial port, it is set to 115200 baud and the
+ *  screenshot is requested with the 'S' command. Otherwise the input is
+ *  a file with a captured stream. The stream format is described at
+ *  USARTL2_ScreenshotLine() in usartl2.c
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SCR_MAX_W	320
+#define SCR_MAX_H	240
+
+/* local variables ----------------------------------------------------------*/
+static int fd_in;
+static uint8_t image[SCR_MAX_H][SCR_MAX_W * 3];
+static uint32_t crc_table[256];
+
+/**
+ * @brief  Read exactly one byte from the input
+ * @retval the byte or -1 at the end of the input
+ */
+static int get_byte(void) {
+	uint8_t b;
+
+	if (read(fd_in, &b, 1) != 1)
+		return -1;
+	return b;
+}
+
+/**
+ * @brief  Read one 16 bit little endian value
+ * @retval the value or -1 at the end of the input
+ */
+static int get_word(void) {
+	int l, h;
+
+	l = get_byte();
+	h = get_byte();
+	if (l < 0 || h < 0)
+		return -1;
+	return l | (h << 8);
+}
+
+/**
+ * @brief  Configure a serial port for 115200 baud, 8N1, raw
+ * @retval 0 on success
+ */
+static int serial_setup(int fd) {
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) != 0)
+		return -1;
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, B115200);
+	cfsetospeed(&tio, B115200);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 50;	// 5s timeout
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+/**
+ * @brief  CRC32 as used by PNG
+ */
+static uint32_t png_crc(uint32_t crc, const uint8_t *p, size_t n) {
+	int i, k;
+	uint32_t c;
+
+	if (crc_table[1] == 0) {
+		for (i = 0; i < 256; i++) {
+			c = i;
+			for (k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			crc_table[i] = c;
+		}
+	}
+	crc = ~crc;
+	while (n--)
+		crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+/**
+ * @brief  Write a 32 bit big endian value
+ */
+static void put_be32(uint8_t *p, uint32_t v) {
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+/**
+ * @brief  Write one PNG chunk
+ */
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len) {
+	uint8_t b[4];
+	uint32_t crc;
+
+	put_be32(b, len);
+	fwrite(b, 1, 4, f);
+	fwrite(type, 1, 4, f);
+	if (len)
+		fwrite(data, 1, len, f);
+	crc = png_crc(0, (const uint8_t *) type, 4);
+	crc = png_crc(crc, data, len);
+	put_be32(b, crc);
+	fwrite(b, 1, 4, f);
+}
+
+/**
+ * @brief  Write the image as PNG. The zlib stream uses uncompressed
+ *         blocks, so no compression library is necessary.
+ * @retval 0 on success
+ */
+static int png_write(const char *name, int w, int h) {
+	FILE *f;
+	uint8_t hdr[13];
+	uint8_t *raw, *z, *p;
+	uint32_t raw_len, z_len, a = 1, b = 0;
+	uint32_t i, blk;
+	int y;
+
+	// Filter byte 0 in front of each line
+	raw_len = h * (w * 3 + 1);
+	raw = malloc(raw_len);
+	z = malloc(raw_len + raw_len / 65535 * 5 + 16);
+	if (!raw || !z)
+		return -1;
+	for (y = 0; y < h; y++) {
+		raw[y * (w * 3 + 1)] = 0;
+		memcpy(&raw[y * (w * 3 + 1) + 1], image[y], w * 3);
+	}
+
+	// zlib header, stored blocks and adler32
+	p = z;
+	*p++ = 0x78;
+	*p++ = 0x01;
+	for (i = 0; i < raw_len; i += blk) {
+		blk = raw_len - i;
+		if (blk > 65535)
+			blk = 65535;
+		*p++ = (i + blk == raw_len) ? 1 : 0;
+		*p++ = blk & 0xFF;
+		*p++ = blk >> 8;
+		*p++ = ~blk & 0xFF;
+		*p++ = (~blk >> 8) & 0xFF;
+		memcpy(p, &raw[i], blk);
+		p += blk;
+	}
+	for (i = 0; i < raw_len; i++) {
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_be32(p, (b << 16) | a);
+	p += 4;
+	z_len = p - z;
+
+	f = fopen(name, "wb");
+	if (!f)
+		return -1;
+	fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+	put_be32(&hdr[0], w);
+	put_be32(&hdr[4], h);
+	hdr[8] = 8;		// bit depth
+	hdr[9] = 2;		// RGB
+	hdr[10] = 0;
+	hdr[11] = 0;
+	hdr[12] = 0;
+	png_chunk(f, "IHDR", hdr, 13);
+	png_chunk(f, "IDAT", z, z_len);
+	png_chunk(f, "IEND", NULL, 0);
+	fclose(f);
+	free(raw);
+	free(z);
+	return 0;
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	const char magic[] = "CSCR";
+	int c, i, w, h, x, y, line, v, errors;
+	uint16_t sum;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <serial port or file> <output.png>\n", argv[0]);
+		return 1;
+	}
+
+	fd_in = open(argv[1], O_RDWR | O_NOCTTY);
+	if (fd_in < 0)
+		fd_in = open(argv[1], O_RDONLY);
+	if (fd_in < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	// Request the screenshot, if it's a serial port
+	if (isatty(fd_in)) {
+		if (serial_setup(fd_in) != 0) {
+			perror("serial port");
+			return 1;
+		}
+		tcflush(fd_in, TCIOFLUSH);
+		if (write(fd_in, "S", 1) != 1) {
+			perror("write");
+			return 1;
+		}
+	}
+
+	// Search the start of the stream
+	i = 0;
+	while (i < 4) {
+		c = get_byte();
+		if (c < 0) {
+			fprintf(stderr, "No screenshot found\n");
+			return 1;
+		}
+		if (c == magic[i])
+			i++;
+		else
+			i = (c == magic[0]) ? 1 : 0;
+	}
+
+	w = get_word();
+	h = get_word();
+	if (w <= 0 || h <= 0 || w > SCR_MAX_W || h > SCR_MAX_H) {
+		fprintf(stderr, "Invalid size %dx%d\n", w, h);
+		return 1;
+	}
+
+	errors = 0;
+	for (y = 0; y < h; y++) {
+		line = get_word();
+		if (line != y) {
+			fprintf(stderr, "Line %d: unexpected line number %d\n", y, line);
+			return 1;
+		}
+		sum = 0;
+		for (x = 0; x < w; x++) {
+			v = get_word();
+			if (v < 0) {
+				fprintf(stderr, "Stream ends in line %d\n", y);
+				return 1;
+			}
+			sum += v;
+
+			// RGB565 to RGB888
+			image[y][x * 3 + 0] = ((v >> 11) & 0x1F) * 255 / 31;
+			image[y][x * 3 + 1] = ((v >> 5) & 0x3F) * 255 / 63;
+			image[y][x * 3 + 2] = (v & 0x1F) * 255 / 31;
+		}
+		if (get_word() != sum) {
+			fprintf(stderr, "Line %d: checksum error\n", y);
+			errors++;
+		}
+	}
+
+	if (png_write(argv[2], w, h) != 0) {
+		perror(argv[2]);
+		return 1;
+	}
+	printf("%dx%d pixels written to %s, %d line(s) with errors\n", w, h,
+			argv[2], errors);
+	return errors ? 2 : 0;
+}
@@ -0,0 +1,311 @@
+/**
+ *  Project     Campos
+ *  @file		streamrx.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: receive the binary frame stream and write the frames
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o streamrx streamrx.c record.c \
+ *             ../Campos/src/stream.c ../Campos/src/cobs.c ../Campos/src/crc.c
+ *
+ *  Usage: streamrx [-b baud index] [-m mode] [-n frames]
+ *                  <serial port or captured file> <output directory>
+ *         streamrx -r [-b baud index] [-n frames]
+ *                  <serial port or captured file> <recording>
+ *
+ *  If the input is a serial port, the baud rate is switched with the 'b'
+ *  command (0: 115200 .. 5: 2000000, see usartl2.c) and the stream is
+ *  started with the 's' command (1: raw, 2: difference coded, 3: record).
+ *  After -n frames, or at the end of a captured file, the stream is
+ *  stopped. Each complete frame is written as <dir>/frame_<number>.pgm,
+ *  with the frame information in a comment line. With -r, the record mode
+ *  is started and the frames are written with their tracking results into
+ *  a recording file for the replay tool. ASCII output of the debug
+ *  console between the packets is ignored.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "stream.h"
+#include "record.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define FRAME_MAX_PIXELS	(864 * 108)
+#define FRAME_MODE_DEFAULT	2
+#define FRAME_MODE_RECORD	3
+// Telemetry packets are stored by the low byte of the frame number
+#define TELEMETRY_SIZE		256
+
+/* local variables ----------------------------------------------------------*/
+static int fd_in;
+static const speed_t speeds[] = {
+	B115200, B230400, B460800, B921600, B1000000, B2000000
+};
+
+// Frame that is being received
+static Stream_FrameTypeDef frame;
+static int frame_valid = 0;
+static int frame_received = 0;		// Number of received pixels
+static uint8_t frame_pixels[FRAME_MAX_PIXELS];
+
+// Tracking results for the recording
+static Stream_TelemetryTypeDef telemetry[TELEMETRY_SIZE];
+static int telemetry_valid[TELEMETRY_SIZE];
+static Record_TypeDef record;
+static int recording = 0;
+
+static long n_packets = 0, n_bad = 0, n_frames = 0, n_incomplete = 0;
+static long n_pixels = 0, n_bytes = 0;
+
+/**
+ * @brief  Configure a serial port, 8N1, raw
+ * @retval 0 on success
+ */
+static int serial_setup(int fd, speed_t speed) {
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) != 0)
+		return -1;
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 50;	// 5s timeout
+	return tcsetattr(fd, TCSADRAIN, &tio);
+}
+
+/**
+ * @brief  Send a command to the debug console
+ */
+static void send_command(const char *cmd) {
+	if (write(fd_in, cmd, strlen(cmd)) != (ssize_t) strlen(cmd))
+		perror("write");
+	tcdrain(fd_in);
+	usleep(100000);
+}
+
+/**
+ * @brief  Write the received frame, if it is complete
+ */
+static void frame_finish(const char *dir) {
+	Record_FrameTypeDef fr;
+	Stream_TelemetryTypeDef *t;
+	char name[1024];
+	FILE *f;
+
+	if (!frame_valid)
+		return;
+	frame_valid = 0;
+
+	if (frame_received != frame.width * frame.height) {
+		n_incomplete++;
+		return;
+	}
+
+	if (recording) {
+		// The telemetry packet of the frame is sent before its pixels
+		t = &telemetry[frame.frame % TELEMETRY_SIZE];
+		fr.frame = frame;
+		fr.track_valid = telemetry_valid[frame.frame % TELEMETRY_SIZE]
+				&& (t->frame == frame.frame);
+		fr.status = t->status;
+		fr.x = t->x;
+		fr.subx = t->subx;
+		fr.y = t->y;
+		fr.suby = t->suby;
+		fr.intensity = t->intensity;
+		if (RECORD_Write(&record, &fr, frame_pixels) != 0)
+			perror("recording");
+		n_frames++;
+		return;
+	}
+
+	snprintf(name, sizeof(name), "%s/frame_%05u.pgm", dir, frame.frame);
+	f = fopen(name, "wb");
+	if (!f) {
+		perror(name);
+		return;
+	}
+	fprintf(f, "P5\n# frame %u offset %u %u exposure %u time %u us\n%d %d\n255\n",
+			frame.frame, frame.x, frame.y, frame.exposure, frame.timestamp,
+			frame.width, frame.height);
+	fwrite(frame_pixels, 1, frame.width * frame.height, f);
+	fclose(f);
+	n_frames++;
+}
+
+/**
+ * @brief  Decode one packet between two delimiters
+ */
+static void packet_received(const uint8_t *coded, int n, const char *dir) {
+	static uint8_t payload[STREAM_MAX_PAYLOAD];
+	uint8_t pixels[STREAM_CHUNK_PIXELS];
+	Stream_ChunkTypeDef chunk;
+	Stream_TelemetryTypeDef t;
+	uint8_t type;
+	int len;
+
+	len = STREAM_Unpack(coded, n, &type, payload, sizeof(payload));
+	if (len < 0) {
+		// Also the ASCII output of the console between the packets
+		n_bad++;
+		return;
+	}
+	if (type == STREAM_TYPE_TELEMETRY) {
+		if (STREAM_DecodeTelemetry(&t, payload, len) == STREAM_OK) {
+			telemetry[t.frame % TELEMETRY_SIZE] = t;
+			telemetry_valid[t.frame % TELEMETRY_SIZE] = 1;
+		}
+		return;
+	}
+	if (type != STREAM_TYPE_FRAME)
+		return;
+	if (STREAM_DecodeChunk(&chunk, payload, len, pixels) != STREAM_OK) {
+		n_bad++;
+		return;
+	}
+	if (chunk.frame.width * chunk.frame.height > FRAME_MAX_PIXELS
+			|| chunk.offset + chunk.count > chunk.frame.width * chunk.frame.height) {
+		n_bad++;
+		return;
+	}
+	n_packets++;
+	n_bytes += n + 1;
+	n_pixels += chunk.count;
+
+	// The first packet of a new frame
+	if (!frame_valid || chunk.frame.frame != frame.frame) {
+		frame_finish(dir);
+		frame = chunk.frame;
+		frame_valid = 1;
+		frame_received = 0;
+	}
+
+	memcpy(&frame_pixels[chunk.offset], pixels, chunk.count);
+	frame_received += chunk.count;
+	if (frame_received == frame.width * frame.height)
+		frame_finish(dir);
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	static uint8_t coded[STREAM_MAX_PACKET];
+	int opt, baud = 0, mode = FRAME_MODE_DEFAULT, frames = 0;
+	int n = 0, overflow = 0;
+	char cmd[16];
+	uint8_t b;
+
+	while ((opt = getopt(argc, argv, "b:m:n:r")) != -1) {
+		switch (opt) {
+		case 'r':
+			recording = 1;
+			mode = FRAME_MODE_RECORD;
+			break;
+		case 'b':
+			baud = atoi(optarg);
+			break;
+		case 'm':
+			mode = atoi(optarg);
+			break;
+		case 'n':
+			frames = atoi(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if ((argc - optind != 2) || (baud < 0) || (baud >= (int) (sizeof(speeds) / sizeof(speeds[0])))) {
+		fprintf(stderr, "Usage: %s [-b baud index] [-m mode] [-n frames] "
+				"<serial port or file> <output directory>\n"
+				"       %s -r [-b baud index] [-n frames] "
+				"<serial port or file> <recording>\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	if (recording && RECORD_Create(&record, argv[optind + 1]) != 0) {
+		perror(argv[optind + 1]);
+		return 1;
+	}
+
+	fd_in = open(argv[optind], O_RDWR | O_NOCTTY);
+	if (fd_in < 0)
+		fd_in = open(argv[optind], O_RDONLY);
+	if (fd_in < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	// Switch the baud rate and start the stream, if it's a serial port
+	if (isatty(fd_in)) {
+		if (serial_setup(fd_in, B115200) != 0) {
+			perror("serial port");
+			return 1;
+		}
+		if (baud != 0) {
+			snprintf(cmd, sizeof(cmd), "b%d\r", baud);
+			send_command(cmd);
+			if (serial_setup(fd_in, speeds[baud]) != 0) {
+				perror("serial port");
+				return 1;
+			}
+		}
+		tcflush(fd_in, TCIOFLUSH);
+		snprintf(cmd, sizeof(cmd), "s%d\r", mode);
+		send_command(cmd);
+	}
+
+	while (read(fd_in, &b, 1) == 1) {
+		if (b == COBS_DELIMITER) {
+			if (n > 0 && !overflow)
+				packet_received(coded, n, argv[optind + 1]);
+			n = 0;
+			overflow = 0;
+			if (frames > 0 && n_frames >= frames)
+				break;
+		} else if (n < (int) sizeof(coded)) {
+			coded[n++] = b;
+		} else {
+			overflow = 1;
+		}
+	}
+	frame_finish(argv[optind + 1]);
+
+	if (isatty(fd_in)) {
+		send_command("s0\r");
+		if (baud != 0)
+			send_command("b0\r");
+	}
+
+	if (recording && RECORD_Close(&record) != 0)
+		perror("recording");
+
+	printf("%ld frames, %ld incomplete, %ld packets, %ld not decoded\n",
+			n_frames, n_incomplete, n_packets, n_bad);
+	if (n_pixels > 0)
+		printf("%.2f bytes per pixel on the line\n", (double) n_bytes / n_pixels);
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ *  Project     Campos
+ *  @file		telem2csv.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: convert the binary telemetry stream into CSV
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o telem2csv telem2csv.c \
+ *             ../Campos/src/stream.c ../Campos/src/cobs.c ../Campos/src/crc.c
+ *
+ *  Usage: telem2csv [-b baud index] [-n packets] <serial port or captured file>
+ *
+ *  If the input is a serial port, the baud rate is switched with the 'b'
+ *  command (0: 115200 .. 5: 2000000, see usartl2.c) and the telemetry is
+ *  started with the 'D' command. After -n packets, or at the end of a
+ *  captured file, it is stopped again with 'd'.
+ *  Each telemetry packet is written as one CSV line to stdout. Other
+ *  packets and the ASCII output of the debug console are ignored.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "stream.h"
+
+/* local variables ----------------------------------------------------------*/
+static int fd_in;
+static const speed_t speeds[] = {
+	B115200, B230400, B460800, B921600, B1000000, B2000000
+};
+
+// Names of Track_StatusTypeDef
+static const char * const status_names[] = {
+	"init", "searching", "light", "center", "lost"
+};
+
+static long n_packets = 0, n_bad = 0;
+
+/**
+ * @brief  Configure a serial port, 8N1, raw
+ * @retval 0 on success
+ */
+static int serial_setup(int fd, speed_t speed) {
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) != 0)
+		return -1;
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 50;	// 5s timeout
+	return tcsetattr(fd, TCSADRAIN, &tio);
+}
+
+/**
+ * @brief  Send a command to the debug console
+ */
+static void send_command(const char *cmd) {
+	if (write(fd_in, cmd, strlen(cmd)) != (ssize_t) strlen(cmd))
+		perror("write");
+	tcdrain(fd_in);
+	usleep(100000);
+}
+
+/**
+ * @brief  Decode one packet between two delimiters and print it
+ */
+static void packet_received(const uint8_t *coded, int n) {
+	static uint8_t payload[STREAM_MAX_PAYLOAD];
+	Stream_TelemetryTypeDef t;
+	uint8_t type;
+	int len;
+
+	len = STREAM_Unpack(coded, n, &type, payload, sizeof(payload));
+	if (len < 0 || type != STREAM_TYPE_TELEMETRY)
+		return;
+	if (STREAM_DecodeTelemetry(&t, payload, len) != STREAM_OK) {
+		n_bad++;
+		return;
+	}
+	n_packets++;
+
+	printf("%u,%u,%s,%u.%03u,%u.%03u,%u,%u,%u,%u,%u,%u,%u\n",
+			t.frame, t.timestamp,
+			t.status < 5 ? status_names[t.status] : "?",
+			t.x, t.subx, t.y, t.suby, t.intensity, t.exposure,
+			t.process_us, t.frames_dropped, t.telemetry_dropped,
+			t.uart_dropped, t.ir_dropped);
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	static uint8_t coded[STREAM_MAX_PACKET];
+	int opt, baud = 0, packets = 0;
+	int n = 0, overflow = 0;
+	char cmd[16];
+	uint8_t b;
+
+	while ((opt = getopt(argc, argv, "b:n:")) != -1) {
+		switch (opt) {
+		case 'b':
+			baud = atoi(optarg);
+			break;
+		case 'n':
+			packets = atoi(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if ((argc - optind != 1) || (baud < 0) || (baud >= (int) (sizeof(speeds) / sizeof(speeds[0])))) {
+		fprintf(stderr, "Usage: %s [-b baud index] [-n packets] "
+				"<serial port or file>\n", argv[0]);
+		return 1;
+	}
+
+	fd_in = open(argv[optind], O_RDWR | O_NOCTTY);
+	if (fd_in < 0)
+		fd_in = open(argv[optind], O_RDONLY);
+	if (fd_in < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	// Switch the baud rate and start the telemetry, if it's a serial port
+	if (isatty(fd_in)) {
+		if (serial_setup(fd_in, B115200) != 0) {
+			perror("serial port");
+			return 1;
+		}
+		if (baud != 0) {
+			snprintf(cmd, sizeof(cmd), "b%d\r", baud);
+			send_command(cmd);
+			if (serial_setup(fd_in, speeds[baud]) != 0) {
+				perror("serial port");
+				return 1;
+			}
+		}
+		tcflush(fd_in, TCIOFLUSH);
+		send_command("D");
+	}
+
+	printf("frame,time_us,status,x,y,intensity,exposure,process_us,"
+			"frames_dropped,telemetry_dropped,uart_dropped,ir_dropped\n");
+
+	while (read(fd_in, &b, 1) == 1) {
+		if (b == COBS_DELIMITER) {
+			if (n > 0 && !overflow)
+				packet_received(coded, n);
+			n = 0;
+			overflow = 0;
+			if (packets > 0 && n_packets >= packets)
+				break;
+		} else if (n < (int) sizeof(coded)) {
+			coded[n++] = b;
+		} else {
+			overflow = 1;
+		}
+	}
+
+	if (isatty(fd_in)) {
+		send_command("d");
+		if (baud != 0)
+			send_command("b0\r");
+	}
+
+	fprintf(stderr, "%ld packets, %ld bad packets\n", n_packets, n_bad);
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ *  Project     Campos
+ *  @file		timesync.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host library: offset and drift between tracker and receiver clock
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *  The packets with IRPACKET_FLAG_SYNC carry the tracker time of the
+ *  rising edge of their header. Together with the receiver time of the
+ *  same edge they give one point. A straight line is fitted through the
+ *  last points by least squares. Its slope is the drift, and it maps
+ *  each capture time stamp to the receiver clock.
+ *  If the tracker clock jumps, the fit starts again with the new points.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <math.h>
+#include <string.h>
+#include "timesync.h"
+
+/* Prototypes of local functions ---------------------------------------------*/
+static double TIMESYNC_Unwrap(const TimeSync_TypeDef *ts, uint32_t tracker_us);
+static void TIMESYNC_Fit(TimeSync_TypeDef *ts);
+static void TIMESYNC_Restart(TimeSync_TypeDef *ts);
+
+/**
+ * @brief  Initialize the estimator
+ * @param  ts the estimator
+ * @param  window number of points for the fit
+ */
+void TIMESYNC_Init(TimeSync_TypeDef *ts, int window) {
+	memset(ts, 0, sizeof(*ts));
+	if (window < 2)
+		window = 2;
+	if (window > TIMESYNC_MAX_WINDOW)
+		window = TIMESYNC_MAX_WINDOW;
+	ts->window = window;
+	ts->slope = 1.0;
+}
+
+/**
+ * @brief  Tracker time without the overflow of the 32 bit timer
+ * @param  ts the estimator
+ * @param  tracker_us tracker time stamp
+ * @retval unwrapped time
+ */
+static double TIMESYNC_Unwrap(const TimeSync_TypeDef *ts, uint32_t tracker_us) {
+	if (!ts->started)
+		return tracker_us;
+	return ts->last_x + (int32_t)(tracker_us - ts->last_raw);
+}
+
+/**
+ * @brief  Fit a line through the points of the window
+ * @param  ts the estimator
+ */
+static void TIMESYNC_Fit(TimeSync_TypeDef *ts) {
+	double sx = 0, sy = 0, sxx = 0, sxy = 0, sr = 0, dx, r;
+	int i;
+
+	for (i = 0; i < ts->count; i++) {
+		sx += ts->x[i];
+		sy += ts->y[i];
+	}
+	ts->x0 = sx / ts->count;
+	ts->y0 = sy / ts->count;
+
+	for (i = 0; i < ts->count; i++) {
+		dx = ts->x[i] - ts->x0;
+		sxx += dx * dx;
+		sxy += dx * (ts->y[i] - ts->y0);
+	}
+	ts->slope = (sxx > 0) ? sxy / sxx : 1.0;
+
+	for (i = 0; i < ts->count; i++) {
+		r = ts->y[i] - ts->y0 - ts->slope * (ts->x[i] - ts->x0);
+		sr += r * r;
+	}
+	ts->rms = sqrt(sr / ts->count);
+}
+
+/**
+ * @brief  Forget all points, but keep the counters
+ * @param  ts the estimator
+ */
+static void TIMESYNC_Restart(TimeSync_TypeDef *ts) {
+	ts->count = 0;
+	ts->next = 0;
+	ts->started = 0;
+	ts->slope = 1.0;
+	ts->rms = 0;
+	ts->rejected_row = 0;
+	ts->restarts++;
+}
+
+/**
+ * @brief  Add a sync point. The fit is restarted, if the tracker time
+ * 		   runs backwards or TIMESYNC_MAX_REJECTED points in a row were
+ * 		   rejected.
+ * @param  ts the estimator
+ * @param  tracker_us tracker time of the header
+ * @param  receiver_us receiver time of the header
+ * @retval 1 if the point was used, 0 if it was an outlier
+ */
+int TIMESYNC_Add(TimeSync_TypeDef *ts, uint32_t tracker_us, double receiver_us) {
+	double x, r, limit;
+
+	if (ts->started && ((int32_t)(tracker_us - ts->last_raw) < 0
+			|| ts->rejected_row >= TIMESYNC_MAX_REJECTED))
+		TIMESYNC_Restart(ts);
+	x = TIMESYNC_Unwrap(ts, tracker_us);
+
+	// Reject outliers, if the fit is good enough
+	if (ts->count >= 8) {
+		r = receiver_us - ts->y0 - ts->slope * (x - ts->x0);
+		limit = TIMESYNC_OUTLIER_RMS * ts->rms;
+		if (limit < TIMESYNC_MIN_OUTLIER_US)
+			limit = TIMESYNC_MIN_OUTLIER_US;
+		if (fabs(r) > limit) {
+			ts->rejected++;
+			ts->rejected_row++;
+			return 0;
+		}
+	}
+	ts->rejected_row = 0;
+
+	ts->started = 1;
+	ts->last_raw = tracker_us;
+	ts->last_x = x;
+
+	ts->x[ts->next] = x;
+	ts->y[ts->next] = receiver_us;
+	ts->next = (ts->next + 1) % ts->window;
+	if (ts->count < ts->window)
+		ts->count++;
+	ts->accepted++;
+
+	TIMESYNC_Fit(ts);
+	return 1;
+}
+
+/**
+ * @brief  The estimator has enough points for offset and drift
+ * @param  ts the estimator
+ * @retval 1 if valid
+ */
+int TIMESYNC_Valid(const TimeSync_TypeDef *ts) {
+	return ts->count >= 2;
+}
+
+/**
+ * @brief  Convert a tracker time stamp to the receiver clock
+ * @param  ts the estimator
+ * @param  tracker_us tracker time stamp
+ * @retval receiver time in us
+ */
+double TIMESYNC_ToReceiver(const TimeSync_TypeDef *ts, uint32_t tracker_us) {
+	return ts->y0 + ts->slope * (TIMESYNC_Unwrap(ts, tracker_us) - ts->x0);
+}
+
+/**
+ * @brief  Drift of the receiver clock against the tracker clock
+ * @param  ts the estimator
+ * @retval drift in ppm
+ */
+double TIMESYNC_DriftPpm(const TimeSync_TypeDef *ts) {
+	return (ts->slope - 1.0) * 1e6;
+}
@@ -0,0 +1,69 @@
+/**
+ *  Project     Campos
+ *  @file		timesync.h
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host library: offset and drift between tracker and receiver clock
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TIMESYNC_H_
+#define TIMESYNC_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define TIMESYNC_MAX_WINDOW		256
+
+// Points are rejected, if they are further away from the fit than this
+// number of rms values, but at least TIMESYNC_MIN_OUTLIER_US
+#define TIMESYNC_OUTLIER_RMS	5.0
+#define TIMESYNC_MIN_OUTLIER_US	200.0
+
+// The fit is restarted after this number of rejected points in a row,
+// the tracker clock has jumped (reset of the tracker, restart of TIM5)
+#define TIMESYNC_MAX_REJECTED	8
+
+/* Type defs -----------------------------------------------------------------*/
+typedef struct {
+	int window;					// Number of points for the fit
+	int count;					// Number of points in the window
+	int next;					// Next point to write
+	double x[TIMESYNC_MAX_WINDOW];	// Tracker time, unwrapped
+	double y[TIMESYNC_MAX_WINDOW];	// Receiver time
+	int started;
+	uint32_t last_raw;			// Last tracker time stamp ..
+	double last_x;				// .. and unwrapped
+	double x0, y0;				// Fit: y = y0 + slope * (x - x0)
+	double slope;
+	double rms;					// rms of the residuals in us
+	uint32_t accepted;
+	uint32_t rejected;
+	int rejected_row;			// Rejected points since the last accepted one
+	uint32_t restarts;			// Restarts after a jump of the tracker clock
+} TimeSync_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void TIMESYNC_Init(TimeSync_TypeDef *ts, int window);
+int TIMESYNC_Add(TimeSync_TypeDef *ts, uint32_t tracker_us, double receiver_us);
+int TIMESYNC_Valid(const TimeSync_TypeDef *ts);
+double TIMESYNC_ToReceiver(const TimeSync_TypeDef *ts, uint32_t tracker_us);
+double TIMESYNC_DriftPpm(const TimeSync_TypeDef *ts);
+
+#endif /* TIMESYNC_H_ */
@@ -0,0 +1,259 @@
+/**
+ *  Project     Campos
+ *  @file		tracedump.c
+ *  @author		Gerd Bartelt - www.sebulli.com
+ *  @brief		Host tool: format the binary trace of the firmware
+ *
+ *  @copyright	GPL3
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Build: cc -O2 -I../Campos/inc -o tracedump tracedump.c \
+ *             ../Campos/src/stream.c ../Campos/src/cobs.c ../Campos/src/crc.c
+ *
+ *  Usage: tracedump [-b baud index] [-n events] [-f MHz] [-c]
+ *                   <serial port or captured file>
+ *
+ *  If the input is a serial port, the baud rate is switched with the 'b'
+ *  command (0: 115200 .. 5: 2000000, see usartl2.c) and the trace is
+ *  started with the 'X' command. After -n events, or at the end of a
+ *  captured file, it is stopped again with 'x'.
+ *  The texts are taken from TRACE_MESSAGES in trace.h, so the tool must
+ *  be built with the same trace.h as the firmware. Each event is printed
+ *  with its time since the first event and since the event before. The
+ *  cycle counter is converted with the CPU clock of -f MHz (168).
+ *  -c prints the timeline as CSV.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "stream.h"
+#include "trace.h"
+
+/* local variables ----------------------------------------------------------*/
+static int fd_in;
+static const speed_t speeds[] = {
+	B115200, B230400, B460800, B921600, B1000000, B2000000
+};
+
+// The message texts of the firmware
+#define TRACE_TEXT(id, text)	text,
+static const char * const trace_texts[TRACE_IDS] = {
+	TRACE_MESSAGES(TRACE_TEXT)
+};
+#define TRACE_NAME(id, text)	#id,
+static const char * const trace_names[TRACE_IDS] = {
+	TRACE_MESSAGES(TRACE_NAME)
+};
+
+static int csv = 0;
+static double mhz = 168.0;
+static long n_events = 0, n_bad = 0;
+static uint32_t last_dropped = 0;
+static uint32_t last_cycles;
+static uint64_t time_cycles = 0;		// Cycle counter without overflows
+static uint64_t last_time = 0;
+
+/**
+ * @brief  Configure a serial port, 8N1, raw
+ * @retval 0 on success
+ */
+static int serial_setup(int fd, speed_t speed) {
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) != 0)
+		return -1;
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 50;	// 5s timeout
+	return tcsetattr(fd, TCSADRAIN, &tio);
+}
+
+/**
+ * @brief  Send a command to the debug console
+ */
+static void send_command(const char *cmd) {
+	if (write(fd_in, cmd, strlen(cmd)) != (ssize_t) strlen(cmd))
+		perror("write");
+	tcdrain(fd_in);
+	usleep(100000);
+}
+
+/**
+ * @brief  Print one event
+ */
+static void print_event(const Stream_TraceEventTypeDef *e) {
+	char text[256];
+	double t, dt;
+
+	// The events are in order, so the overflows of the counter can be
+	// counted. TRACE_TICK events make sure there is one every 25s.
+	if (n_events == 0)
+		last_cycles = e->cycles;
+	time_cycles += (uint32_t) (e->cycles - last_cycles);
+	last_cycles = e->cycles;
+	t = time_cycles / mhz;
+	dt = (time_cycles - last_time) / mhz;
+	last_time = time_cycles;
+	n_events++;
+
+	if (e->id < TRACE_IDS)
+		snprintf(text, sizeof(text), trace_texts[e->id], e->arg[0], e->arg[1]);
+	else
+		snprintf(text, sizeof(text), "unknown message %u (%u, %u)",
+				e->id, e->arg[0], e->arg[1]);
+
+	if (csv)
+		printf("%.3f,%.3f,%u,%s,%u,%u,\"%s\"\n", t, dt, e->id,
+				e->id < TRACE_IDS ? trace_names[e->id] : "?",
+				e->arg[0], e->arg[1], text);
+	else
+		printf("%14.3f %+12.3f  %s\n", t, dt, text);
+}
+
+/**
+ * @brief  Decode one packet between two delimiters and print its events
+ */
+static void packet_received(const uint8_t *coded, int n) {
+	static uint8_t payload[STREAM_MAX_PAYLOAD];
+	Stream_TraceEventTypeDef events[STREAM_TRACE_EVENTS];
+	uint32_t dropped;
+	uint8_t type;
+	int len, count, i;
+
+	len = STREAM_Unpack(coded, n, &type, payload, sizeof(payload));
+	if (len < 0 || type != STREAM_TYPE_TRACE)
+		return;
+	count = STREAM_DecodeTrace(events, STREAM_TRACE_EVENTS, &dropped,
+			payload, len);
+	if (count < 0) {
+		n_bad++;
+		return;
+	}
+
+	// A new trace was started
+	if (count > 0 && events[0].id == TRACE_START)
+		last_dropped = 0;
+	if (dropped != last_dropped) {
+		if (!csv)
+			printf("%14s %12s  --- %u events dropped ---\n", "", "",
+					dropped - last_dropped);
+		last_dropped = dropped;
+	}
+
+	for (i = 0; i < count; i++)
+		print_event(&events[i]);
+}
+
+/**
+ * @brief  Main program
+ */
+int main(int argc, char *argv[]) {
+	static uint8_t coded[STREAM_MAX_PACKET];
+	int opt, baud = 0, events = 0;
+	int n = 0, overflow = 0;
+	char cmd[16];
+	uint8_t b;
+
+	while ((opt = getopt(argc, argv, "b:n:f:c")) != -1) {
+		switch (opt) {
+		case 'b':
+			baud = atoi(optarg);
+			break;
+		case 'n':
+			events = atoi(optarg);
+			break;
+		case 'f':
+			mhz = atof(optarg);
+			break;
+		case 'c':
+			csv = 1;
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if ((argc - optind != 1) || (baud < 0) || (mhz <= 0)
+			|| (baud >= (int) (sizeof(speeds) / sizeof(speeds[0])))) {
+		fprintf(stderr, "Usage: %s [-b baud index] [-n events] [-f MHz] [-c] "
+				"<serial port or file>\n", argv[0]);
+		return 1;
+	}
+
+	fd_in = open(argv[optind], O_RDWR | O_NOCTTY);
+	if (fd_in < 0)
+		fd_in = open(argv[optind], O_RDONLY);
+	if (fd_in < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	// Switch the baud rate and start the trace, if it's a serial port
+	if (isatty(fd_in)) {
+		if (serial_setup(fd_in, B115200) != 0) {
+			perror("serial port");
+			return 1;
+		}
+		if (baud != 0) {
+			snprintf(cmd, sizeof(cmd), "b%d\r", baud);
+			send_command(cmd);
+			if (serial_setup(fd_in, speeds[baud]) != 0) {
+				perror("serial port");
+				return 1;
+			}
+		}
+		tcflush(fd_in, TCIOFLUSH);
+		send_command("X");
+	}
+
+	if (csv)
+		printf("time_us,delta_us,id,name,a,b,text\n");
+	else
+		printf("%14s %12s  %s\n", "time_us", "delta_us", "message");
+
+	while (read(fd_in, &b, 1) == 1) {
+		if (b == COBS_DELIMITER) {
+			if (n > 0 && !overflow)
+				packet_received(coded, n);
+			n = 0;
+			overflow = 0;
+			if (events > 0 && n_events >= events)
+				break;
+		} else if (n < (int) sizeof(coded)) {
+			coded[n++] = b;
+		} else {
+			overflow = 1;
+		}
+	}
+
+	if (isatty(fd_in)) {
+		send_command("x");
+		if (baud != 0)
+			send_command("b0\r");
+	}
+
+	fprintf(stderr, "%ld events, %u dropped, %ld bad packets\n",
+			n_events, last_dropped, n_bad);
+
+	return 0;
+}